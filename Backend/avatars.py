@@ -0,0 +1,107 @@
+"""Fetches the Slack profile pictures of bookers for the displays, so those never need
+a Slack token of their own.
+
+Pictures are kept in memory with the hash of their content, which displays get as the
+ETag. A display that already has the picture gets a 304 instead of the image again."""
+
+from __future__ import annotations
+
+import hashlib
+import logging
+import os
+import time
+from dataclasses import dataclass
+
+import aiohttp
+from slack_sdk.errors import SlackApiError
+from slack_sdk.web.async_client import AsyncWebClient
+
+logger = logging.getLogger("display_api.avatars")
+
+# Slack pictures rarely change, so this mostly bounds how long a new one takes to
+# show up on the displays.
+AVATAR_MAX_AGE_SECONDS = 6 * 60 * 60
+MAX_CACHED_AVATARS = 512
+# Large enough to stay sharp on a full HD display, the display scales it down.
+SLACK_IMAGE_FIELD = "image_192"
+
+_slack_client = AsyncWebClient(token=os.getenv("SLACK_BOT_TOKEN"))
+
+
+@dataclass
+class Avatar:
+    """A profile picture, or the lack of one when the content is empty."""
+
+    content: bytes
+    content_type: str
+    content_hash: str
+    fetched_at: float
+
+
+_avatars_by_user_id: dict[str, Avatar] = {}
+
+
+async def get_avatar(user_id: str) -> Avatar | None:
+    """Gets the profile picture of a Slack user, from memory when it is recent enough.
+
+    Args:
+        user_id: The Slack ID of the user.
+
+    Returns:
+        The avatar. None when the user has no picture or Slack couldn't be reached,
+        in which case an older picture is returned when there is one.
+    """
+    avatar = _avatars_by_user_id.get(user_id)
+    if avatar and time.time() - avatar.fetched_at < AVATAR_MAX_AGE_SECONDS:
+        return avatar if avatar.content else None
+
+    fetched_avatar = await fetch_avatar(user_id)
+    if fetched_avatar is None:
+        return avatar if avatar and avatar.content else None
+
+    # Dicts keep insertion order, so re-inserting makes the first one the least
+    # recently fetched.
+    _avatars_by_user_id.pop(user_id, None)
+    _avatars_by_user_id[user_id] = fetched_avatar
+    if len(_avatars_by_user_id) > MAX_CACHED_AVATARS:
+        del _avatars_by_user_id[next(iter(_avatars_by_user_id))]
+    return fetched_avatar if fetched_avatar.content else None
+
+
+async def fetch_avatar(user_id: str) -> Avatar | None:
+    """Fetches the profile picture of a Slack user from Slack.
+
+    Args:
+        user_id: The Slack ID of the user.
+
+    Returns:
+        The avatar, with empty content when the user has no picture. None when Slack
+        couldn't be reached.
+    """
+    try:
+        user_info = await _slack_client.users_info(user=user_id)
+    except SlackApiError:
+        # Not a Slack user, like the bookings made on a display itself.
+        return Avatar(b"", "", "", time.time())
+    except Exception:
+        logger.warning("Could not look up user %s.", user_id, exc_info=True)
+        return None
+
+    image_url = user_info["user"].get("profile", {}).get(SLACK_IMAGE_FIELD)
+    if not image_url:
+        return Avatar(b"", "", "", time.time())
+
+    try:
+        async with (
+            aiohttp.ClientSession() as session,
+            session.get(image_url) as response,
+        ):
+            response.raise_for_status()
+            content = await response.read()
+            content_type = response.headers.get("Content-Type", "image/jpeg")
+    except Exception:
+        logger.warning("Could not fetch the avatar of user %s.", user_id, exc_info=True)
+        return None
+
+    content_hash = hashlib.sha1(content).hexdigest()  # noqa: S324
+    return Avatar(content, content_type, content_hash, time.time())
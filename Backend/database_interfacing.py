@@ -10,6 +10,7 @@ from pathlib import Path
 
 import aiosqlite
 
+import schedule_versions
 from data_models import (
     Booking,
     IncorrectTimeError,
@@ -56,12 +57,15 @@ async def configure_database() -> None:
     """)
 
 
-async def create_booking(new_booking: Booking) -> None:
+async def create_booking(new_booking: Booking) -> Booking:
     """Creates a booking in the database.
 
     Args:
         booking: The booking to create.
 
+    Returns:
+        The created booking, with its ID and end time as stored.
+
     Raises:
         OverlappingBookingError: If the booking overlaps with another booking.
     """
@@ -94,8 +98,11 @@ async def create_booking(new_booking: Booking) -> None:
             new_booking.user_name,
         ),
     )
+    new_booking.id = cursor.lastrowid
     await database.commit()
     await cursor.close()
+    await schedule_versions.record_booking_change(new_booking.room_id, new_booking.id)
+    return new_booking
 
 
 async def delete_booking(booking_id: int) -> None:
@@ -116,6 +123,7 @@ async def delete_booking(booking_id: int) -> None:
     await cursor.execute("DELETE FROM bookings WHERE id = ?", (booking.id,))
     await database.commit()
     await cursor.close()
+    await schedule_versions.record_booking_change(booking.room_id, booking.id)
 
 
 async def change_booking_time(
@@ -163,6 +171,7 @@ async def change_booking_time(
     )
     await database.commit()
     await cursor.close()
+    await schedule_versions.record_booking_change(booking.room_id, booking.id)
 
 
 async def get_booking_by_id(booking_id: int) -> Booking | None:
@@ -379,6 +388,67 @@ async def get_upcoming_bookings_for_room(
     return bookings
 
 
+async def get_remaining_bookings_for_room(
+    room: Room, search_end_time: int
+) -> list[Booking]:
+    """Gets the current booking and all upcoming bookings of a room up to a time.
+
+    Args:
+        Room: The room to get the bookings for.
+        search_end_time: The end time to search to.
+
+    Returns:
+        A list of bookings, ordered by start time.
+    """
+    database = await _get_database_connection()
+    cursor = await database.cursor()
+    await cursor.execute(
+        """
+        SELECT * FROM bookings
+        WHERE room_id = ? AND end_time >= strftime('%s', 'now') AND start_time <= ?
+        ORDER BY start_time ASC
+        """,
+        (room.id, search_end_time),
+    )
+    fetched_bookings = await cursor.fetchall()
+    await cursor.close()
+
+    return [
+        await _get_booking_from_cursor_response(booking) for booking in fetched_bookings
+    ]
+
+
+async def get_bookings_for_room_between(
+    room: Room, search_start_time: int, search_end_time: int
+) -> list[Booking]:
+    """Gets the bookings of a room that overlap with a time span.
+
+    Args:
+        Room: The room to get the bookings for.
+        search_start_time: The start time of the span.
+        search_end_time: The end time of the span.
+
+    Returns:
+        A list of bookings, ordered by start time.
+    """
+    database = await _get_database_connection()
+    cursor = await database.cursor()
+    await cursor.execute(
+        """
+        SELECT * FROM bookings
+        WHERE room_id = ? AND end_time >= ? AND start_time <= ?
+        ORDER BY start_time ASC
+        """,
+        (room.id, search_start_time, search_end_time),
+    )
+    fetched_bookings = await cursor.fetchall()
+    await cursor.close()
+
+    return [
+        await _get_booking_from_cursor_response(booking) for booking in fetched_bookings
+    ]
+
+
 async def get_coming_week_bookings_for_room(room: Room) -> list[Booking]:
     """Gets the bookings for a room from the start of the current day to one week after the start of today.
 
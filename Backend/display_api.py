@@ -4,17 +4,26 @@ Written by Mervin van Brakel, 2025."""
 
 from __future__ import annotations
 
+import hashlib
+import hmac
 import logging
 import os
+import sys
+import time
+from datetime import datetime
 
 import pytz
 import uvicorn
 from dotenv import load_dotenv
-from fastapi import FastAPI, HTTPException
+from fastapi import FastAPI, Header, HTTPException, Request, Response
+from pydantic import BaseModel
+from starlette.middleware.base import RequestResponseEndpoint
 
+import avatars
 import database_interfacing
+import schedule_versions
 import utility
-from data_models import Booking
+from data_models import Booking, OverlappingBookingError, Room
 
 load_dotenv()
 
@@ -30,9 +39,44 @@ if not os.getenv("DISPLAY_API_PORT").isdigit():
     error_message = "DISPLAY_API_PORT should be a port number!"
     raise ValueError(error_message)
 
+BOOK_NOW_DURATIONS_MINUTES = (15, 30, 60)
+BOOK_NOW_MAX_TEXT_LENGTH = 100
+# Booking from displays stays disabled until this is set. Every display gets a token
+# derived from it for its own room, see get_book_now_token.
+BOOK_NOW_SECRET = os.getenv("DISPLAY_BOOK_NOW_SECRET", "")
+
+
+@app.middleware("http")
+async def add_server_time_header(
+    request: Request, call_next: RequestResponseEndpoint
+) -> Response:
+    """Stamps every response with the time it was sent in milliseconds, which the
+    displays use to correct their own clocks. The Date header only has seconds.
+
+    Args:
+        request: The incoming request.
+        call_next: The endpoint handling the request.
+
+    Returns:
+        The response of the endpoint, with an X-Server-Time header.
+    """
+    response = await call_next(request)
+    response.headers["X-Server-Time"] = str(int(time.time() * 1000))
+    return response
+
+
+class BookNowRequest(BaseModel):
+    """Body of a booking made on a display."""
+
+    duration_minutes: int
+    name: str
+    user: str
+
 
 @app.get("/rooms/{room_id}/{timezone_id}")
-async def get_room_display_data(room_id: int, timezone_id: str):
+async def get_room_display_data(
+    room_id: int, timezone_id: str, since: str | None = None
+):
     """Gets the display data for a room. Was having troubles with the "/" character,
     apparently URL-encoding doesn't work nicely here because Uvicorn decodes it before
     it gets to FastAPI or something.
@@ -40,33 +84,285 @@ async def get_room_display_data(room_id: int, timezone_id: str):
     Args:
         room_id: The ID of the room to get the display data for.
         timezone_id: The IANA ID of the display, where the / is an & instead lol.
+        since: The schedule version token the display already has, if any.
+
+    Returns:
+        Just the version when nothing changed since the given version, the changed
+        bookings when the changes are still known, the full display data otherwise.
+    """
+    room = await database_interfacing.get_room_by_id(room_id)
+    if not room:
+        raise HTTPException(status_code=404, detail="ERROR: Room ID not found.")
+
+    timezone = await get_timezone_from_id(timezone_id)
+    logger.debug("Getting display data for room %s in timezone %s.", room_id, timezone)
+
+    if since:
+        version = await schedule_versions.get_version_token(room.id)
+        changed_booking_ids = await schedule_versions.get_changed_booking_ids(
+            room.id, since
+        )
+        if changed_booking_ids == []:
+            return {"version": version, "unchanged": True}
+        if changed_booking_ids is not None:
+            return {
+                "version": version,
+                "changes": await get_booking_changes(room, changed_booking_ids),
+            }
+
+    return await get_room_display_dict(room, timezone)
+
+
+@app.get("/rooms/{room_id}/{timezone_id}/days/{date_text}")
+async def get_room_day_schedule(room_id: int, timezone_id: str, date_text: str):
+    """Gets all bookings of a room on one day, for the week view of the displays.
+    Displays cache these per day and refetch them once the version changes.
+
+    Args:
+        room_id: The ID of the room to get the bookings for.
+        timezone_id: The IANA ID of the display, where the / is an & instead.
+        date_text: The day in the display's timezone, as YYYY-MM-DD.
+
+    Returns:
+        The schedule version, the day and its bookings ordered by start time.
+    """
+    room = await database_interfacing.get_room_by_id(room_id)
+    if not room:
+        raise HTTPException(status_code=404, detail="ERROR: Room ID not found.")
+
+    timezone = await get_timezone_from_id(timezone_id)
+    try:
+        day = datetime.strptime(date_text, "%Y-%m-%d").date()  # noqa: DTZ007
+    except ValueError as error:
+        raise HTTPException(status_code=400, detail="ERROR: Invalid date.") from error
+
+    version = await schedule_versions.get_version_token(room.id)
+    day_start_time, day_end_time = await utility.get_day_start_end_time_from_date(
+        day, timezone
+    )
+    bookings = await database_interfacing.get_bookings_for_room_between(
+        room, day_start_time, day_end_time
+    )
+
+    return {
+        "version": version,
+        "date": date_text,
+        "bookings": [await booking_to_sendable_dict(booking) for booking in bookings],
+    }
+
+
+@app.get("/batch/rooms/{timezone_id}")
+async def get_batched_room_display_data(timezone_id: str, room_ids: str):
+    """Gets the display data for multiple rooms in one go. Used by displays that act
+    as a relay for the other displays on their site, so a slow link to the backend
+    only has to carry one request for all of them.
+
+    Args:
+        timezone_id: The IANA ID of the displays, where the / is an & instead.
+        room_ids: Comma separated IDs of the rooms to get the display data for.
+
+    Returns:
+        The display data per room ID. Rooms that don't exist are left out.
+    """
+    try:
+        requested_room_ids = [
+            int(room_id) for room_id in room_ids.split(",") if room_id.strip()
+        ]
+    except ValueError as error:
+        raise HTTPException(
+            status_code=400, detail="ERROR: Invalid room IDs."
+        ) from error
+
+    timezone = await get_timezone_from_id(timezone_id)
+    logger.debug(
+        "Getting batched display data for rooms %s in timezone %s.",
+        requested_room_ids,
+        timezone,
+    )
+
+    rooms = {}
+    for room_id in requested_room_ids:
+        room = await database_interfacing.get_room_by_id(room_id)
+        if room:
+            rooms[str(room_id)] = await get_room_display_dict(room, timezone)
+
+    return {"rooms": rooms}
+
+
+def get_book_now_token(room_id: int) -> str:
+    """Gets the token a display has to send along to book its room. It only works for
+    that one room, so a token taken from one display can't book any other room.
+
+    Args:
+        room_id: The ID of the room the display shows.
+
+    Returns:
+        The token, which is empty when booking from displays is disabled.
     """
+    if not BOOK_NOW_SECRET:
+        return ""
+    return hmac.new(
+        BOOK_NOW_SECRET.encode(), str(room_id).encode(), hashlib.sha256
+    ).hexdigest()
+
+
+@app.post("/rooms/{room_id}/book")
+async def book_room_now(
+    room_id: int,
+    book_now_request: BookNowRequest,
+    authorization: str | None = Header(default=None),
+):
+    """Books a room from now on, for walk-up users claiming a free room on its display.
+    The display shows the booking before this returns and rolls it back when it fails.
+
+    Args:
+        room_id: The ID of the room to book.
+        book_now_request: The duration and texts of the booking.
+        authorization: The room's book-now token, as "Bearer {token}".
+
+    Returns:
+        The created booking, in the same format as the display data.
+    """
+    if not BOOK_NOW_SECRET:
+        raise HTTPException(
+            status_code=403, detail="ERROR: Booking from displays is disabled."
+        )
+    token = (authorization or "").removeprefix("Bearer ").strip()
+    if not hmac.compare_digest(token, get_book_now_token(room_id)):
+        logger.warning("Refused a booking from a display for room %s.", room_id)
+        raise HTTPException(status_code=401, detail="ERROR: Invalid book-now token.")
+
+    if book_now_request.duration_minutes not in BOOK_NOW_DURATIONS_MINUTES:
+        raise HTTPException(status_code=400, detail="ERROR: Invalid duration.")
+
     room = await database_interfacing.get_room_by_id(room_id)
     if not room:
         raise HTTPException(status_code=404, detail="ERROR: Room ID not found.")
 
+    start_time = int(time.time())
+    booking = Booking(
+        id=None,
+        room_id=room.id,
+        start_time=start_time,
+        end_time=start_time + book_now_request.duration_minutes * 60,
+        name=book_now_request.name[:BOOK_NOW_MAX_TEXT_LENGTH],
+        user_id="display",
+        user_name=book_now_request.user[:BOOK_NOW_MAX_TEXT_LENGTH],
+    )
+
+    try:
+        created_booking = await database_interfacing.create_booking(booking)
+    except OverlappingBookingError as error:
+        raise HTTPException(status_code=409, detail=str(error)) from error
+
+    return {"booking": await booking_to_sendable_dict(created_booking)}
+
+
+@app.get("/users/{user_id}/avatar")
+async def get_user_avatar(user_id: str, request: Request) -> Response:
+    """Gets the profile picture of a booker, proxied from Slack. The ETag is the hash
+    of the picture, which the displays also use to name it in their cache.
+
+    Args:
+        user_id: The Slack ID of the user, as sent with the bookings.
+        request: The incoming request, for its If-None-Match header.
+
+    Returns:
+        The picture, or an empty 304 response when the display already has it.
+    """
+    avatar = await avatars.get_avatar(user_id)
+    if avatar is None:
+        raise HTTPException(status_code=404, detail="ERROR: No avatar for this user.")
+
+    headers = {"ETag": f'"{avatar.content_hash}"'}
+    if request.headers.get("If-None-Match") == headers["ETag"]:
+        return Response(status_code=304, headers=headers)
+    return Response(
+        content=avatar.content, media_type=avatar.content_type, headers=headers
+    )
+
+
+async def get_timezone_from_id(timezone_id: str) -> pytz.tzinfo:
+    """Gets the timezone from the ID sent by a display.
+
+    Args:
+        timezone_id: The IANA ID of the display, where the / is an & instead.
+
+    Returns:
+        The timezone.
+
+    Raises:
+        HTTPException: If the timezone ID is invalid.
+    """
     timezone = timezone_id.replace("&", "/")
     if timezone not in pytz.all_timezones:
         raise HTTPException(
             status_code=400, detail="ERROR: Invalid system timezone ID."
         )
+    return pytz.timezone(timezone)
 
-    logger.debug("Getting display data for room %s in timezone %s.", room_id, timezone)
 
-    day_end_time = await utility.get_day_end_time_from_timezone(pytz.timezone(timezone))
+async def get_room_display_dict(room: Room, timezone: pytz.tzinfo) -> dict:
+    """Constructs the display data for a room. Besides the bookings to show, it has
+    the whole remaining schedule of the day and its version, so displays can apply the
+    changes to it afterwards.
+
+    Args:
+        room: The room to construct the display data for.
+        timezone: The timezone of the display.
+
+    Returns:
+        The display data dict.
+    """
+    # Read first, so a change made while this is put together is sent again later
+    # rather than missed.
+    version = await schedule_versions.get_version_token(room.id)
+    day_end_time = await utility.get_day_end_time_from_timezone(timezone)
     current_booking = await database_interfacing.get_current_booking_for_room(room)
     upcoming_bookings = await database_interfacing.get_upcoming_bookings_for_room(
         room, day_end_time, 3
     )
+    remaining_bookings = await database_interfacing.get_remaining_bookings_for_room(
+        room, day_end_time
+    )
 
     return {
         "current_booking": await booking_to_sendable_dict(current_booking),
         "first_upcoming_booking": await booking_to_sendable_dict(upcoming_bookings[0]),
         "second_upcoming_booking": await booking_to_sendable_dict(upcoming_bookings[1]),
         "third_upcoming_booking": await booking_to_sendable_dict(upcoming_bookings[2]),
+        "version": version,
+        "bookings": [
+            await booking_to_sendable_dict(booking) for booking in remaining_bookings
+        ],
     }
 
 
+async def get_booking_changes(room: Room, changed_booking_ids: list[int]) -> list:
+    """Constructs the changes to send to a display that already has a schedule.
+
+    Args:
+        room: The room the display shows.
+        changed_booking_ids: The IDs of the bookings that changed.
+
+    Returns:
+        Per booking, either its current data or that it was removed from the room.
+    """
+    changes = []
+    for booking_id in changed_booking_ids:
+        booking = await database_interfacing.get_booking_by_id(booking_id)
+        if booking is None or booking.room_id != room.id:
+            changes.append({"id": str(booking_id), "removed": True})
+        else:
+            changes.append(
+                {
+                    "id": str(booking_id),
+                    "booking": await booking_to_sendable_dict(booking),
+                }
+            )
+    return changes
+
+
 async def booking_to_sendable_dict(booking: Booking) -> dict:
     """Constructs and returns the booking dict for display.
 
@@ -81,6 +377,7 @@ async def booking_to_sendable_dict(booking: Booking) -> dict:
             "id": "",
             "name": "",
             "user": "",
+            "user_id": "",
             "start_time": 0,
             "end_time": 0,
         }
@@ -89,6 +386,7 @@ async def booking_to_sendable_dict(booking: Booking) -> dict:
         "id": str(booking.id),
         "name": booking.name,
         "user": booking.user_name,
+        "user_id": booking.user_id,
         "start_time": booking.start_time,
         "end_time": booking.end_time,
     }
@@ -104,3 +402,9 @@ async def start_display_api():
     )
     server = uvicorn.Server(config)
     await server.serve()
+
+
+if __name__ == "__main__":
+    # Prints the book-now tokens to configure on the displays of the given rooms.
+    for room_id_text in sys.argv[1:]:
+        print(f"{room_id_text}: {get_book_now_token(int(room_id_text))}")
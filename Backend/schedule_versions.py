@@ -0,0 +1,74 @@
+"""Keeps track of which bookings changed per room, so displays can poll for just the
+changes since the schedule they already have.
+
+Versions only live as long as this process. Every start gets a new epoch, so after a
+restart the displays' version tokens no longer match and they get a full schedule."""
+
+from __future__ import annotations
+
+import uuid
+from collections import deque
+
+MAX_CHANGES_PER_ROOM = 256
+
+_schedule_epoch = uuid.uuid4().hex[:8]
+_latest_version = 0
+_changes_by_room: dict[int, deque[tuple[int, int]]] = {}
+_forgotten_version_by_room: dict[int, int] = {}
+
+
+async def record_booking_change(room_id: int, booking_id: int) -> None:
+    """Records that a booking of a room was created, changed or deleted.
+
+    Args:
+        room_id: The ID of the room the booking is in.
+        booking_id: The ID of the booking that changed.
+    """
+    global _latest_version  # noqa: PLW0603
+    _latest_version += 1
+
+    room_changes = _changes_by_room.setdefault(room_id, deque())
+    room_changes.append((_latest_version, booking_id))
+    if len(room_changes) > MAX_CHANGES_PER_ROOM:
+        forgotten_version, _ = room_changes.popleft()
+        _forgotten_version_by_room[room_id] = forgotten_version
+
+
+async def get_version_token(room_id: int) -> str:
+    """Gets the token describing the current schedule version of a room.
+
+    Args:
+        room_id: The ID of the room.
+
+    Returns:
+        The version token, which displays send back to get the changes since.
+    """
+    room_changes = _changes_by_room.get(room_id)
+    room_version = room_changes[-1][0] if room_changes else 0
+    return f"{_schedule_epoch}.{room_version}"
+
+
+async def get_changed_booking_ids(room_id: int, since_token: str) -> list[int] | None:
+    """Gets the IDs of the bookings of a room that changed since a version.
+
+    Args:
+        room_id: The ID of the room.
+        since_token: A version token previously handed out for this room.
+
+    Returns:
+        The changed booking IDs, oldest change first and without duplicates. None when
+        the token is from another run or too old, so only a full schedule will do.
+    """
+    epoch, _, version_text = since_token.partition(".")
+    if epoch != _schedule_epoch or not version_text.isdigit():
+        return None
+
+    since_version = int(version_text)
+    if since_version < _forgotten_version_by_room.get(room_id, 0):
+        return None
+
+    changed_booking_ids = []
+    for version, booking_id in _changes_by_room.get(room_id, ()):
+        if version > since_version and booking_id not in changed_booking_ids:
+            changed_booking_ids.append(booking_id)
+    return changed_booking_ids
@@ -4,7 +4,7 @@ Written by Mervin van Brakel, 2025."""
 
 from __future__ import annotations
 
-from datetime import datetime
+from datetime import date, datetime, time, timedelta
 
 import pytz  # noqa: TC002
 
@@ -86,6 +86,25 @@ async def get_day_end_time_from_timezone(
     return int(today.replace(hour=23, minute=59, second=59).timestamp())
 
 
+async def get_day_start_end_time_from_date(
+    day: date, user_timezone: pytz.tzinfo
+) -> tuple[int, int]:
+    """Gets the first and last second of a day, based on the user's timezone.
+
+    Args:
+        day: The day to get the times for.
+        user_timezone: The user's timezone.
+
+    Returns:
+        The start and end time of the day in timestamp format.
+    """
+    day_start = user_timezone.localize(datetime.combine(day, time.min))
+    next_day_start = user_timezone.localize(
+        datetime.combine(day + timedelta(days=1), time.min)
+    )
+    return int(day_start.timestamp()), int(next_day_start.timestamp()) - 1
+
+
 async def get_new_unix_start_end_time_from_booking_and_time_strings(
     booking: Booking, start_time: str, end_time: str, user_timezone: pytz.tzinfo
 ) -> tuple[int, int]:
@@ -0,0 +1,82 @@
+#include "pacedanimationdriver.h"
+#include "../diagnostics/logging.h"
+#include <QtMath>
+
+namespace {
+const qint64 FRAME_RATE_REPORT_INTERVAL = 1000;
+// Shorter stretches of animation are too noisy to say much about the rate.
+const qint64 MIN_FRAME_RATE_MEASUREMENT_TIME = 250;
+} // namespace
+
+PacedAnimationDriver::PacedAnimationDriver(int targetFrameRate,
+                                           DisplayMetrics *displayMetrics,
+                                           QObject *parent)
+    : QAnimationDriver{parent}, m_frameInterval(1000.0 / targetFrameRate),
+      m_displayMetrics(displayMetrics), m_frameTimer(new QTimer(this)),
+      m_lastFrameSlot(0), m_measurementStart(0), m_measuredFrames(0),
+      m_droppedFrames(0) {
+  m_frameTimer->setSingleShot(true);
+  m_frameTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_frameTimer, &QTimer::timeout, this,
+          &PacedAnimationDriver::onFrameTimer);
+  m_clock.start();
+  m_displayMetrics->setTargetAnimationFrameRate(targetFrameRate);
+}
+
+qint64 PacedAnimationDriver::elapsed() const { return m_clock.elapsed(); }
+
+void PacedAnimationDriver::start() {
+  QAnimationDriver::start();
+  qint64 now = elapsed();
+  m_lastFrameSlot = qFloor(now / m_frameInterval);
+  m_measurementStart = now;
+  m_measuredFrames = 0;
+  m_droppedFrames = 0;
+  scheduleNextFrame();
+}
+
+void PacedAnimationDriver::stop() {
+  m_frameTimer->stop();
+  reportFrameRate(elapsed());
+  QAnimationDriver::stop();
+}
+
+void PacedAnimationDriver::onFrameTimer() {
+  qint64 now = elapsed();
+  // The timer can fire a millisecond early, that still counts as the slot it
+  // was meant for.
+  qint64 frameSlot =
+      qMax(m_lastFrameSlot + 1, qint64(qFloor(now / m_frameInterval)));
+  m_droppedFrames += frameSlot - m_lastFrameSlot - 1;
+  m_lastFrameSlot = frameSlot;
+  m_measuredFrames++;
+
+  advance();
+  if (!isRunning()) {
+    return;
+  }
+  if (now - m_measurementStart >= FRAME_RATE_REPORT_INTERVAL) {
+    reportFrameRate(now);
+  }
+  scheduleNextFrame();
+}
+
+void PacedAnimationDriver::scheduleNextFrame() {
+  double nextFrameTime = (m_lastFrameSlot + 1) * m_frameInterval;
+  m_frameTimer->start(qMax(0, qCeil(nextFrameTime - elapsed())));
+}
+
+void PacedAnimationDriver::reportFrameRate(qint64 now) {
+  qint64 measurementTime = now - m_measurementStart;
+  qCDebug(lcAnimation) << m_measuredFrames << "frames and" << m_droppedFrames
+                       << "dropped in" << measurementTime << "ms";
+  if (measurementTime >= MIN_FRAME_RATE_MEASUREMENT_TIME) {
+    m_displayMetrics->setAnimationFrameRate(1000.0 * m_measuredFrames /
+                                            measurementTime);
+  }
+  m_displayMetrics->recordDroppedAnimationFrames(m_droppedFrames);
+
+  m_measurementStart = now;
+  m_measuredFrames = 0;
+  m_droppedFrames = 0;
+}
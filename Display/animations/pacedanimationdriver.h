@@ -0,0 +1,41 @@
+#ifndef PACEDANIMATIONDRIVER_H
+#define PACEDANIMATIONDRIVER_H
+
+#include "../diagnostics/displaymetrics.h"
+#include <QAnimationDriver>
+#include <QElapsedTimer>
+#include <QTimer>
+
+// Advances every animation of the GUI thread at a fixed frame rate instead of
+// Qt's default timer, so weak panels only get asked for the frames they can
+// paint. Ticks are aligned to a fixed grid of frame slots and animations are
+// given the real elapsed time, so a slot missed under load is dropped instead
+// of stretching the animation. Widgets only, Qt Quick has its own driver.
+class PacedAnimationDriver : public QAnimationDriver {
+  Q_OBJECT
+public:
+  PacedAnimationDriver(int targetFrameRate, DisplayMetrics *displayMetrics,
+                       QObject *parent = nullptr);
+
+  qint64 elapsed() const override;
+
+protected:
+  void start() override;
+  void stop() override;
+
+private:
+  double m_frameInterval;
+  DisplayMetrics *m_displayMetrics;
+  QTimer *m_frameTimer;
+  QElapsedTimer m_clock;
+  qint64 m_lastFrameSlot;
+  qint64 m_measurementStart;
+  quint64 m_measuredFrames;
+  quint64 m_droppedFrames;
+
+  void onFrameTimer();
+  void scheduleNextFrame();
+  void reportFrameRate(qint64 now);
+};
+
+#endif // PACEDANIMATIONDRIVER_H
@@ -0,0 +1,111 @@
+#include "transitiontimeline.h"
+#include <QtMath>
+#include <algorithm>
+
+TransitionTimeline::TransitionTimeline(QObject *parent)
+    : QAbstractAnimation{parent}, m_maximumDuration(-1) {}
+
+void TransitionTimeline::addAnimation(int startTime,
+                                      QAbstractAnimation *animation) {
+  TimelineEntry entry;
+  entry.startTime = startTime;
+  entry.animation = animation;
+  addEntry(entry);
+}
+
+void TransitionTimeline::addAction(int startTime,
+                                   std::function<void()> action) {
+  TimelineEntry entry;
+  entry.startTime = startTime;
+  entry.action = action;
+  addEntry(entry);
+}
+
+void TransitionTimeline::addEntry(const TimelineEntry &entry) {
+  // Kept sorted on start time (stable for equal ones), so when two entries
+  // touch the same property the one that started last wins.
+  auto position = std::upper_bound(
+      m_entries.begin(), m_entries.end(), entry.startTime,
+      [](int startTime, const TimelineEntry &other) {
+        return startTime < other.startTime;
+      });
+  m_entries.insert(position, entry);
+}
+
+void TransitionTimeline::setMaximumDuration(int maximumDuration) {
+  m_maximumDuration = maximumDuration;
+}
+
+int TransitionTimeline::duration() const {
+  return qCeil(getNaturalDuration() * getTimeScale());
+}
+
+void TransitionTimeline::fastForward() {
+  updateCurrentTime(duration());
+  stop();
+  m_entries.clear();
+}
+
+void TransitionTimeline::cancel() {
+  stop();
+  for (const TimelineEntry &entry : std::as_const(m_entries)) {
+    if (entry.animation && !entry.done) {
+      entry.animation->stop();
+    }
+  }
+  m_entries.clear();
+}
+
+void TransitionTimeline::updateCurrentTime(int currentTime) {
+  double timelineTime = currentTime / getTimeScale();
+  bool reachedEnd = currentTime >= duration();
+
+  for (TimelineEntry &entry : m_entries) {
+    if (entry.done || (timelineTime < entry.startTime && !reachedEnd)) {
+      continue;
+    }
+
+    if (entry.action) {
+      entry.done = true;
+      entry.action();
+      continue;
+    }
+
+    if (!entry.animation) {
+      entry.done = true;
+      continue;
+    }
+    if (entry.animation->state() == QAbstractAnimation::Stopped) {
+      // Property animations ignore time changes while stopped, so they are
+      // started and immediately paused, which also keeps them off the global
+      // animation timer.
+      entry.animation->start();
+      entry.animation->pause();
+    }
+    int animationDuration = entry.animation->totalDuration();
+    int animationTime = reachedEnd ? animationDuration
+                                   : qRound(timelineTime - entry.startTime);
+    if (animationTime >= animationDuration) {
+      animationTime = animationDuration;
+      entry.done = true;
+    }
+    entry.animation->setCurrentTime(animationTime);
+  }
+}
+
+int TransitionTimeline::getNaturalDuration() const {
+  int naturalDuration = 0;
+  for (const TimelineEntry &entry : m_entries) {
+    int entryDuration = entry.animation ? entry.animation->totalDuration() : 0;
+    naturalDuration = qMax(naturalDuration, entry.startTime + entryDuration);
+  }
+  return naturalDuration;
+}
+
+double TransitionTimeline::getTimeScale() const {
+  int naturalDuration = getNaturalDuration();
+  if (m_maximumDuration <= 0 || naturalDuration <= m_maximumDuration) {
+    return 1.0;
+  }
+  return static_cast<double>(m_maximumDuration) / naturalDuration;
+}
@@ -0,0 +1,50 @@
+#ifndef TRANSITIONTIMELINE_H
+#define TRANSITIONTIMELINE_H
+
+#include <QAbstractAnimation>
+#include <QList>
+#include <QPointer>
+#include <functional>
+
+// Plays every animation of a state change from a single animation clock, so
+// the parts can't drift apart the way separately started animations and
+// timers do under load. Animations and actions are added at a start time in
+// the transition; added animations are driven by the timeline and must not be
+// started on their own. When the transition would take longer than the
+// maximum duration, it is sped up as a whole to fit.
+class TransitionTimeline : public QAbstractAnimation {
+  Q_OBJECT
+public:
+  explicit TransitionTimeline(QObject *parent = nullptr);
+
+  void addAnimation(int startTime, QAbstractAnimation *animation);
+  void addAction(int startTime, std::function<void()> action);
+  void setMaximumDuration(int maximumDuration);
+  int duration() const override;
+
+  // Jumps to the end state of everything on the timeline, running all
+  // actions that were still pending, then empties it.
+  void fastForward();
+  // Stops right where it is and drops whatever hasn't happened yet.
+  void cancel();
+
+protected:
+  void updateCurrentTime(int currentTime) override;
+
+private:
+  struct TimelineEntry {
+    int startTime = 0;
+    QPointer<QAbstractAnimation> animation;
+    std::function<void()> action;
+    bool done = false;
+  };
+
+  QList<TimelineEntry> m_entries;
+  int m_maximumDuration;
+
+  int getNaturalDuration() const;
+  double getTimeScale() const;
+  void addEntry(const TimelineEntry &entry);
+};
+
+#endif // TRANSITIONTIMELINE_H
@@ -0,0 +1,160 @@
+#include "assetcache.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QStandardPaths>
+
+namespace {
+const int MAX_DECODING_THREADS = 2;
+const int STALE_CACHE_FILE_DAYS = 30;
+const int MEMORY_CACHE_BUDGET_KILOBYTES = 32 * 1024;
+} // namespace
+
+AssetCache *AssetCache::instance() {
+  static AssetCache *assetCache = new AssetCache();
+  return assetCache;
+}
+
+AssetCache::AssetCache(QObject *parent)
+    : QObject{parent}, m_threadPool(new QThreadPool(this)) {
+  m_threadPool->setMaxThreadCount(MAX_DECODING_THREADS);
+  m_pixmapsByRequestKey.setMaxCost(MEMORY_CACHE_BUDGET_KILOBYTES);
+  m_cacheDirectory =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+      "/assets";
+  QDir().mkpath(m_cacheDirectory);
+
+  QString cacheDirectory = m_cacheDirectory;
+  m_threadPool->start(
+      [cacheDirectory]() { removeStaleCacheFiles(cacheDirectory); });
+}
+
+void AssetCache::requestPixmap(const QString &sourcePath,
+                               const QSize &logicalSize,
+                               qreal devicePixelRatio,
+                               Qt::AspectRatioMode aspectRatioMode,
+                               QObject *receiver, PixmapCallback callback) {
+  QFileInfo sourceInfo(sourcePath);
+  QSize pixelSize = logicalSize * devicePixelRatio;
+  QString requestKey =
+      QString("%1|%2|%3x%4|%5")
+          .arg(sourcePath)
+          .arg(sourceInfo.lastModified().toMSecsSinceEpoch())
+          .arg(pixelSize.width())
+          .arg(pixelSize.height())
+          .arg(static_cast<int>(aspectRatioMode));
+
+  if (QPixmap *cachedPixmap = m_pixmapsByRequestKey.object(requestKey)) {
+    callback(*cachedPixmap);
+    return;
+  }
+
+  bool alreadyLoading = m_pendingCallbacks.contains(requestKey);
+  m_pendingCallbacks[requestKey].append({receiver, callback});
+  if (alreadyLoading) {
+    return;
+  }
+
+  QString cacheDirectory = m_cacheDirectory;
+  m_threadPool->start([this, requestKey, sourcePath, cacheDirectory,
+                       pixelSize, aspectRatioMode, devicePixelRatio]() {
+    QImage image = loadScaledImage(sourcePath, cacheDirectory, pixelSize,
+                                   aspectRatioMode);
+    QMetaObject::invokeMethod(
+        this,
+        [this, requestKey, image, devicePixelRatio]() {
+          onImageLoaded(requestKey, image, devicePixelRatio);
+        },
+        Qt::QueuedConnection);
+  });
+}
+
+void AssetCache::onImageLoaded(const QString &requestKey, QImage image,
+                               qreal devicePixelRatio) {
+  // QPixmaps may only be created on the GUI thread, hence the hop back here.
+  image.setDevicePixelRatio(devicePixelRatio);
+  QPixmap pixmap = QPixmap::fromImage(image);
+  if (!pixmap.isNull()) {
+    int costInKilobytes = qMax(1, int(image.sizeInBytes() / 1024));
+    m_pixmapsByRequestKey.insert(requestKey, new QPixmap(pixmap),
+                                 costInKilobytes);
+  }
+
+  const QList<PendingCallback> pendingCallbacks =
+      m_pendingCallbacks.take(requestKey);
+  for (const PendingCallback &pendingCallback : pendingCallbacks) {
+    if (pendingCallback.receiver) {
+      pendingCallback.callback(pixmap);
+    }
+  }
+}
+
+QImage AssetCache::loadScaledImage(const QString &sourcePath,
+                                   const QString &cacheDirectory,
+                                   const QSize &pixelSize,
+                                   Qt::AspectRatioMode aspectRatioMode) {
+  QFile sourceFile(sourcePath);
+  if (!sourceFile.open(QIODevice::ReadOnly)) {
+    return QImage();
+  }
+  QByteArray sourceData = sourceFile.readAll();
+
+  QString sourceHash = QString::fromLatin1(
+      QCryptographicHash::hash(sourceData, QCryptographicHash::Sha1).toHex());
+  QString cachedVariantPath = QString("%1/%2_%3x%4_%5.png")
+                                  .arg(cacheDirectory, sourceHash)
+                                  .arg(pixelSize.width())
+                                  .arg(pixelSize.height())
+                                  .arg(static_cast<int>(aspectRatioMode));
+
+  QImage cachedVariant(cachedVariantPath);
+  if (!cachedVariant.isNull()) {
+    QFile cachedVariantFile(cachedVariantPath);
+    if (cachedVariantFile.open(QIODevice::ReadWrite)) {
+      cachedVariantFile.setFileTime(QDateTime::currentDateTime(),
+                                    QFileDevice::FileModificationTime);
+    }
+    return cachedVariant;
+  }
+
+  QBuffer sourceBuffer(&sourceData);
+  QImageReader imageReader(&sourceBuffer);
+  QImage sourceImage = imageReader.read();
+  if (sourceImage.isNull()) {
+    return QImage();
+  }
+
+  QImage scaledImage = scaleImage(sourceImage, pixelSize, aspectRatioMode);
+  scaledImage.save(cachedVariantPath, "PNG");
+  return scaledImage;
+}
+
+QImage AssetCache::scaleImage(const QImage &sourceImage, const QSize &pixelSize,
+                              Qt::AspectRatioMode aspectRatioMode) {
+  QImage scaledImage = sourceImage.scaled(pixelSize, aspectRatioMode,
+                                          Qt::SmoothTransformation);
+  if (aspectRatioMode != Qt::KeepAspectRatioByExpanding) {
+    return scaledImage;
+  }
+
+  // Expanding means covering the whole area, so crop away what sticks out.
+  QRect croppedRect(QPoint(0, 0), pixelSize);
+  croppedRect.moveCenter(scaledImage.rect().center());
+  return scaledImage.copy(croppedRect);
+}
+
+void AssetCache::removeStaleCacheFiles(const QString &cacheDirectory) {
+  QDateTime staleBefore =
+      QDateTime::currentDateTime().addDays(-STALE_CACHE_FILE_DAYS);
+  const QFileInfoList cachedFiles =
+      QDir(cacheDirectory).entryInfoList(QDir::Files);
+  for (const QFileInfo &cachedFile : cachedFiles) {
+    if (cachedFile.lastModified() < staleBefore) {
+      QFile::remove(cachedFile.absoluteFilePath());
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPixmap>
+#include <QPointer>
+#include <QSize>
+#include <QThreadPool>
+#include <functional>
+
+// Decodes and scales images on a thread pool so the GUI thread never has to.
+// Scaled variants are stored on disk keyed by the hash of the source file and
+// the requested pixel size, so after the first run an image only needs a
+// cheap decode of the small variant. Lives on the GUI thread.
+class AssetCache : public QObject {
+  Q_OBJECT
+public:
+  using PixmapCallback = std::function<void(const QPixmap &)>;
+
+  static AssetCache *instance();
+
+  // Callback is invoked on the GUI thread, unless the receiver was deleted in
+  // the meantime. Failed loads result in a null pixmap.
+  void requestPixmap(const QString &sourcePath, const QSize &logicalSize,
+                     qreal devicePixelRatio,
+                     Qt::AspectRatioMode aspectRatioMode, QObject *receiver,
+                     PixmapCallback callback);
+
+private:
+  explicit AssetCache(QObject *parent = nullptr);
+
+  struct PendingCallback {
+    QPointer<QObject> receiver;
+    PixmapCallback callback;
+  };
+
+  QThreadPool *m_threadPool;
+  QString m_cacheDirectory;
+  QCache<QString, QPixmap> m_pixmapsByRequestKey;
+  QHash<QString, QList<PendingCallback>> m_pendingCallbacks;
+
+  static QImage loadScaledImage(const QString &sourcePath,
+                                const QString &cacheDirectory,
+                                const QSize &pixelSize,
+                                Qt::AspectRatioMode aspectRatioMode);
+  static QImage scaleImage(const QImage &sourceImage, const QSize &pixelSize,
+                           Qt::AspectRatioMode aspectRatioMode);
+  static void removeStaleCacheFiles(const QString &cacheDirectory);
+  void onImageLoaded(const QString &requestKey, QImage image,
+                     qreal devicePixelRatio);
+};
+
+#endif // ASSETCACHE_H
@@ -0,0 +1,147 @@
+#include "fontfallbackcache.h"
+#include "../diagnostics/logging.h"
+#include <QFontDatabase>
+#include <QPair>
+
+namespace {
+// One bit per family in getFallbackFont, and nobody configures more.
+const int MAX_FALLBACK_FAMILIES = 64;
+// Blocks booking names mostly come from: Latin, Greek and Cyrillic,
+// punctuation, the older symbols and dingbats, and emoji.
+const QList<QPair<char32_t, char32_t>> PRECOMPUTED_RANGES = {
+    {0x20, 0x24f},    {0x370, 0x4ff},   {0x2000, 0x206f},
+    {0x2190, 0x21ff}, {0x2600, 0x27bf}, {0x1f300, 0x1faff}};
+} // namespace
+
+FontFallbackCache *FontFallbackCache::instance() {
+  static FontFallbackCache *fontFallbackCache = new FontFallbackCache();
+  return fontFallbackCache;
+}
+
+FontFallbackCache::FontFallbackCache() {}
+
+void FontFallbackCache::setFallbackFamilies(
+    const QStringList &fallbackFamilies) {
+  m_fallbackFamilies.clear();
+  m_fallbackIndexByCodePoint.clear();
+  for (const QString &fallbackFamily : fallbackFamilies) {
+    QString family = fallbackFamily.trimmed();
+    if (family.isEmpty()) {
+      continue;
+    }
+    // Asking Qt for a family it doesn't have silently gives another one,
+    // which would make the coverage wrong.
+    if (!QFontDatabase::hasFamily(family)) {
+      qCInfo(lcSettings) << "Fallback font" << family
+                         << "is not installed, skipping it.";
+      continue;
+    }
+    if (m_fallbackFamilies.size() == MAX_FALLBACK_FAMILIES) {
+      qCWarning(lcSettings) << "Only the first" << MAX_FALLBACK_FAMILIES
+                            << "fallback fonts are used.";
+      break;
+    }
+    m_fallbackFamilies.append(family);
+  }
+
+  for (const QPair<char32_t, char32_t> &range : PRECOMPUTED_RANGES) {
+    for (char32_t codePoint = range.first; codePoint <= range.second;
+         codePoint++) {
+      getFallbackIndex(codePoint);
+    }
+  }
+}
+
+void FontFallbackCache::precomputeCoverage(const QFont &font) {
+  for (const QPair<char32_t, char32_t> &range : PRECOMPUTED_RANGES) {
+    for (char32_t codePoint = range.first; codePoint <= range.second;
+         codePoint++) {
+      isSupported(font.family(), codePoint);
+    }
+  }
+}
+
+QFont FontFallbackCache::getFallbackFont(const QFont &font,
+                                         const QString &text) {
+  if (m_fallbackFamilies.isEmpty()) {
+    return font;
+  }
+
+  // The family is always the first of the families, so passing a font this
+  // returned gives the same result again.
+  const QString family = font.family();
+  quint64 neededFallbacks = 0;
+  for (qsizetype index = 0; index < text.size(); index++) {
+    char32_t codePoint = text[index].unicode();
+    if (text[index].isHighSurrogate() && index + 1 < text.size() &&
+        text[index + 1].isLowSurrogate()) {
+      codePoint = QChar::surrogateToUcs4(text[index], text[index + 1]);
+      index++;
+    }
+    if (isInvisible(codePoint) || isSupported(family, codePoint)) {
+      continue;
+    }
+    int fallbackIndex = getFallbackIndex(codePoint);
+    if (fallbackIndex >= 0) {
+      neededFallbacks |= quint64(1) << fallbackIndex;
+    }
+  }
+  if (neededFallbacks == 0) {
+    return font;
+  }
+
+  QStringList families = {family};
+  for (int index = 0; index < m_fallbackFamilies.size(); index++) {
+    if (neededFallbacks & (quint64(1) << index)) {
+      families.append(m_fallbackFamilies[index]);
+    }
+  }
+  QFont fallbackFont = font;
+  fallbackFont.setFamilies(families);
+  return fallbackFont;
+}
+
+bool FontFallbackCache::isSupported(const QString &family,
+                                    char32_t codePoint) {
+  auto coverage = m_coverageByFamily.find(family);
+  if (coverage == m_coverageByFamily.end()) {
+    // Only the character map is read from it, so the size doesn't matter.
+    coverage = m_coverageByFamily.insert(family, FamilyCoverage());
+    coverage->rawFont = QRawFont::fromFont(QFont(family));
+  }
+
+  auto isSupportedEntry = coverage->isSupportedByCodePoint.constFind(codePoint);
+  if (isSupportedEntry != coverage->isSupportedByCodePoint.constEnd()) {
+    return *isSupportedEntry;
+  }
+  bool isCharacterSupported = coverage->rawFont.supportsCharacter(codePoint);
+  coverage->isSupportedByCodePoint.insert(codePoint, isCharacterSupported);
+  return isCharacterSupported;
+}
+
+// The first family of the chain that has the character, -1 when none does and
+// it is left to Qt.
+int FontFallbackCache::getFallbackIndex(char32_t codePoint) {
+  auto fallbackIndex = m_fallbackIndexByCodePoint.constFind(codePoint);
+  if (fallbackIndex != m_fallbackIndexByCodePoint.constEnd()) {
+    return *fallbackIndex;
+  }
+
+  int foundIndex = -1;
+  for (int index = 0; index < m_fallbackFamilies.size(); index++) {
+    if (isSupported(m_fallbackFamilies[index], codePoint)) {
+      foundIndex = index;
+      break;
+    }
+  }
+  m_fallbackIndexByCodePoint.insert(codePoint, foundIndex);
+  return foundIndex;
+}
+
+// Joiners, variation selectors and tags only change how the characters next
+// to them look, fonts without them still show the sequence fine.
+bool FontFallbackCache::isInvisible(char32_t codePoint) {
+  return codePoint < 0x20 || (codePoint >= 0x200b && codePoint <= 0x200f) ||
+         (codePoint >= 0xfe00 && codePoint <= 0xfe0f) ||
+         (codePoint >= 0xe0000 && codePoint <= 0xe007f);
+}
@@ -0,0 +1,43 @@
+#ifndef FONTFALLBACKCACHE_H
+#define FONTFALLBACKCACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QRawFont>
+#include <QString>
+#include <QStringList>
+
+// Picks fonts for the characters the booking fonts don't have, like emoji and
+// other scripts in names coming from Slack, from a configured chain of
+// fallback families. Without it Qt walks every font on the system for each of
+// those characters during layout. Which family covers a code point is looked
+// up once and cached, the common blocks already at startup. GUI thread only.
+class FontFallbackCache {
+public:
+  static FontFallbackCache *instance();
+
+  void setFallbackFamilies(const QStringList &fallbackFamilies);
+  void precomputeCoverage(const QFont &font);
+  // The font with the fallback families the text needs added after its own,
+  // so Qt finds those glyphs right away. Just the font when it covers the
+  // whole text.
+  QFont getFallbackFont(const QFont &font, const QString &text);
+
+private:
+  FontFallbackCache();
+
+  struct FamilyCoverage {
+    QRawFont rawFont;
+    QHash<char32_t, bool> isSupportedByCodePoint;
+  };
+
+  QStringList m_fallbackFamilies;
+  QHash<QString, FamilyCoverage> m_coverageByFamily;
+  QHash<char32_t, int> m_fallbackIndexByCodePoint;
+
+  bool isSupported(const QString &family, char32_t codePoint);
+  int getFallbackIndex(char32_t codePoint);
+  static bool isInvisible(char32_t codePoint);
+};
+
+#endif // FONTFALLBACKCACHE_H
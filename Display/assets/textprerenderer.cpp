@@ -0,0 +1,91 @@
+#include "textprerenderer.h"
+#include <QFontMetrics>
+#include <QImage>
+#include <QPainter>
+
+namespace {
+const int MEMORY_CACHE_BUDGET_KILOBYTES = 16 * 1024;
+const int TEXT_FLAGS = Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap;
+} // namespace
+
+TextPrerenderer *TextPrerenderer::instance() {
+  static TextPrerenderer *textPrerenderer = new TextPrerenderer();
+  return textPrerenderer;
+}
+
+TextPrerenderer::TextPrerenderer() {
+  m_pixmapsByKey.setMaxCost(MEMORY_CACHE_BUDGET_KILOBYTES);
+}
+
+void TextPrerenderer::warmGlyphCache(const QFont &font) {
+  // Drawing every printable Latin-1 character once loads the font engine and
+  // rasterizes the glyphs the booking texts are most likely to use.
+  QString characters;
+  for (char16_t character = 0x20; character < 0x17f; character++) {
+    if (QChar(character).isPrint()) {
+      characters.append(QChar(character));
+    }
+  }
+
+  QFontMetrics metrics(font);
+  QImage image(metrics.horizontalAdvance(characters) + 1, metrics.height(),
+               QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+  QPainter painter(&image);
+  painter.setFont(font);
+  painter.setPen(Qt::white);
+  painter.drawText(0, metrics.ascent(), characters);
+}
+
+void TextPrerenderer::prerender(const QString &text, const QFont &font,
+                                const QColor &color, int width, int maxHeight,
+                                qreal devicePixelRatio) {
+  if (width <= 0) {
+    return;
+  }
+
+  QString cacheKey =
+      getCacheKey(text, font, color, width, maxHeight, devicePixelRatio);
+  if (m_pixmapsByKey.contains(cacheKey)) {
+    return;
+  }
+
+  QFontMetrics metrics(font);
+  QRect textRect = metrics.boundingRect(QRect(0, 0, width, maxHeight),
+                                        TEXT_FLAGS, text);
+  QSize logicalSize(width, qMin(qMax(textRect.height(), 1), maxHeight));
+
+  QImage image(logicalSize * devicePixelRatio,
+               QImage::Format_ARGB32_Premultiplied);
+  image.setDevicePixelRatio(devicePixelRatio);
+  image.fill(Qt::transparent);
+  {
+    QPainter painter(&image);
+    painter.setFont(font);
+    painter.setPen(color);
+    painter.drawText(QRect(QPoint(0, 0), logicalSize), TEXT_FLAGS, text);
+  }
+
+  QPixmap *pixmap = new QPixmap(QPixmap::fromImage(image));
+  m_pixmapsByKey.insert(cacheKey, pixmap,
+                        qMax<qsizetype>(1, image.sizeInBytes() / 1024));
+}
+
+QPixmap TextPrerenderer::find(const QString &text, const QFont &font,
+                              const QColor &color, int width, int maxHeight,
+                              qreal devicePixelRatio) const {
+  QPixmap *pixmap = m_pixmapsByKey.object(
+      getCacheKey(text, font, color, width, maxHeight, devicePixelRatio));
+  return pixmap ? *pixmap : QPixmap();
+}
+
+QString TextPrerenderer::getCacheKey(const QString &text, const QFont &font,
+                                     const QColor &color, int width,
+                                     int maxHeight, qreal devicePixelRatio) {
+  return QString("%1|%2|%3|%4|%5|%6")
+      .arg(font.key(), color.name(QColor::HexArgb))
+      .arg(width)
+      .arg(maxHeight)
+      .arg(devicePixelRatio)
+      .arg(text);
+}
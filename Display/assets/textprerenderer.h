@@ -0,0 +1,34 @@
+#ifndef TEXTPRERENDERER_H
+#define TEXTPRERENDERER_H
+
+#include <QCache>
+#include <QColor>
+#include <QFont>
+#include <QPixmap>
+#include <QString>
+
+// Lays out and rasterizes text ahead of time, so a label switching to it only
+// has to blit a pixmap. Also warms the glyph caches of the fonts in use, which
+// are shared with regular text drawing on the GUI thread. GUI thread only.
+class TextPrerenderer {
+public:
+  static TextPrerenderer *instance();
+
+  void warmGlyphCache(const QFont &font);
+  void prerender(const QString &text, const QFont &font, const QColor &color,
+                 int width, int maxHeight, qreal devicePixelRatio);
+  // Null pixmap when this exact text was not prerendered (or got evicted).
+  QPixmap find(const QString &text, const QFont &font, const QColor &color,
+               int width, int maxHeight, qreal devicePixelRatio) const;
+
+private:
+  TextPrerenderer();
+
+  QCache<QString, QPixmap> m_pixmapsByKey;
+
+  static QString getCacheKey(const QString &text, const QFont &font,
+                             const QColor &color, int width, int maxHeight,
+                             qreal devicePixelRatio);
+};
+
+#endif // TEXTPRERENDERER_H
@@ -0,0 +1,505 @@
+#include "../assets/fontfallbackcache.h"
+#include "../datafetchinghandler.h"
+#include "../diagnostics/logging.h"
+#include "../settingstrings.h"
+#include <QElapsedTimer>
+#include <QFontDatabase>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTextLayout>
+#include <QtTest>
+
+// Micro-benchmarks of the data layer, the functions every poll goes through,
+// and of laying out the booking names those end up as. Besides the QBENCHMARK
+// numbers, every row is timed against the baseline in
+// datafetchingbench_baselines.json and fails when it got slower than the
+// tolerance in that file allows, and fails when it has no baseline at all.
+// Baselines only mean something on the hardware they were recorded on, so
+// record them on a panel with a release build by running with
+// ROOMBOOKER_BENCH_RECORD_BASELINES=1.
+namespace {
+const char RECORD_BASELINES_VARIABLE[] = "ROOMBOOKER_BENCH_RECORD_BASELINES";
+const char TOLERANCE_VARIABLE[] = "ROOMBOOKER_BENCH_TOLERANCE";
+const double DEFAULT_TOLERANCE = 0.5;
+// Monday morning, so the schedule covers a whole working day.
+const qint64 DAY_START_TIME = 1767600000;
+const int REALISTIC_SCHEDULE_SIZE = 12;
+// Calendar integrations happily paste whole meeting invites into the name.
+const int HUGE_NAME_LENGTH = 64 * 1024;
+// The booking name label on a full HD screen, at the default name font.
+const int NAME_LAYOUT_WIDTH = 1200;
+const int NAME_PIXEL_SIZE = 96;
+// What a Linux panel with the Noto fonts installed ends up with, families
+// that aren't installed are skipped.
+const QStringList FALLBACK_FAMILIES = {"Noto Color Emoji", "Noto Sans",
+                                       "Noto Sans CJK JP", "Noto Sans Arabic",
+                                       "Noto Sans Hebrew", "DejaVu Sans"};
+
+QJsonObject getBookingObject(int id, const QString &name, const QString &user,
+                             qint64 startTime, qint64 endTime) {
+  QJsonObject booking;
+  booking["id"] = id == 0 ? QString() : QString::number(id);
+  booking["name"] = name;
+  booking["user"] = user;
+  booking["start_time"] = startTime;
+  booking["end_time"] = endTime;
+  return booking;
+}
+
+// What the backend sends in place of a booking that isn't there.
+QJsonObject getEmptyBookingObject() {
+  return getBookingObject(0, "", "", 0, 0);
+}
+
+// A full reply the way the backend sends it: the booking shown now, the next
+// three and the rest of the day's schedule.
+QByteArray getDisplayPayload(const QString &name, const QString &user,
+                             int scheduleSize, bool isBooked = true) {
+  QJsonArray bookings;
+  for (int i = 0; i < scheduleSize; i++) {
+    qint64 startTime = DAY_START_TIME + i * 45 * 60;
+    bookings.append(getBookingObject(1000 + i, name, user, startTime,
+                                     startTime + 30 * 60 - 1));
+  }
+
+  QJsonObject payload;
+  payload["current_booking"] =
+      isBooked && !bookings.isEmpty() ? bookings[0] : getEmptyBookingObject();
+  const QStringList upcomingKeys = {"first_upcoming_booking",
+                                    "second_upcoming_booking",
+                                    "third_upcoming_booking"};
+  for (int i = 0; i < upcomingKeys.size(); i++) {
+    payload[upcomingKeys[i]] =
+        i + 1 < bookings.size() ? bookings[i + 1] : getEmptyBookingObject();
+  }
+  payload["version"] = "1767600000.42";
+  payload["bookings"] = bookings;
+  return QJsonDocument(payload).toJson(QJsonDocument::Compact);
+}
+
+QString getEmojiName() {
+  // Family and flag sequences, skin tones and combining marks, the things
+  // that are several code points but a single character on screen.
+  const QString emojiSequence =
+      QString::fromUtf8("\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9\xE2\x80"
+                        "\x8D\xF0\x9F\x91\xA7 \xF0\x9F\x87\xB3\xF0\x9F\x87\xB1"
+                        " \xF0\x9F\x91\x8B\xF0\x9F\x8F\xBD Z\xCC\x81\xCC\xA7 "
+                        "\xF0\x9F\x8E\x89 ");
+  return QString("Team outing ") + emojiSequence.repeated(16);
+}
+
+// Latin with accents, Cyrillic, CJK, Arabic, Hebrew and emoji, so the layout
+// needs a different font for most words.
+QString getMixedScriptName() {
+  return QString::fromUtf8(
+      "R\xC3\xA9union \xC3\xA9quipe \xD0\x9C\xD0\xBE\xD1\x81\xD0\xBA"
+      "\xD0\xB2\xD0\xB0 \xE6\x9D\xB1\xE4\xBA\xAC \xE4\xBC\x9A\xE8\xAD"
+      "\xB0 \xD9\x85\xD8\xB1\xD8\xA7\xD8\xAC\xD8\xB9\xD8\xA9 \xD7\xA1"
+      "\xD7\xA7\xD7\x99\xD7\xA8\xD7\x94 \xE2\x9C\x85 \xF0\x9F\x8E\x89");
+}
+
+void addNameRows() {
+  QTest::addColumn<QString>("name");
+  QTest::addColumn<bool>("usesFallbackChain");
+
+  QTest::newRow("latin") << QString("Sprint planning") << false;
+  QTest::newRow("mixedScript") << getMixedScriptName() << false;
+  QTest::newRow("mixedScriptWithChain") << getMixedScriptName() << true;
+  QTest::newRow("emoji") << getEmojiName() << false;
+  QTest::newRow("emojiWithChain") << getEmojiName() << true;
+}
+
+void addPayloadRows() {
+  QTest::addColumn<QByteArray>("payload");
+
+  QTest::newRow("realistic")
+      << getDisplayPayload("Sprint planning", "Jane Doe",
+                           REALISTIC_SCHEDULE_SIZE);
+  QTest::newRow("unbooked") << getDisplayPayload("", "", 0, false);
+  QTest::newRow("hugeNames")
+      << getDisplayPayload(QString("x").repeated(HUGE_NAME_LENGTH),
+                           QString("y").repeated(HUGE_NAME_LENGTH),
+                           REALISTIC_SCHEDULE_SIZE);
+  QTest::newRow("emoji")
+      << getDisplayPayload(getEmojiName(), getEmojiName(),
+                           REALISTIC_SCHEDULE_SIZE);
+  QByteArray realisticPayload = getDisplayPayload(
+      "Sprint planning", "Jane Doe", REALISTIC_SCHEDULE_SIZE);
+  QTest::newRow("truncated")
+      << realisticPayload.left(realisticPayload.size() / 2);
+  QTest::newRow("wrongTypes")
+      << QByteArray("{\"current_booking\": {\"id\": 12, \"name\": [1, 2], "
+                    "\"start_time\": \"nine\", \"end_time\": null}, "
+                    "\"first_upcoming_booking\": \"none\", "
+                    "\"bookings\": {}}");
+  QTest::newRow("notJson") << QByteArray("<html>502 Bad Gateway</html>");
+}
+} // namespace
+
+class DataFetchingBench : public QObject {
+  Q_OBJECT
+
+private:
+  DisplayMetrics *m_displayMetrics;
+  SystemClock *m_clock;
+  DataFetchingHandler *m_handler;
+
+  QJsonObject m_baselines;
+  QJsonObject m_recordedBaselines;
+  double m_tolerance;
+  bool m_isRecordingBaselines;
+  QElapsedTimer m_measurementTimer;
+  qint64 m_iterations;
+
+  void readBaselines();
+  void writeBaselines();
+  void startMeasurement();
+  void compareWithBaseline();
+  QJsonObject getParsedPayload(const QByteArray &payload);
+  static QFont getNameFont();
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void parseReply_data();
+  void parseReply();
+  void getCurrentBookingData_data();
+  void getCurrentBookingData();
+  void getUpcomingBookings_data();
+  void getUpcomingBookings();
+  void getTimeString_data();
+  void getTimeString();
+  void compareCurrentBookingData_data();
+  void compareCurrentBookingData();
+  void compareUpcomingBookings_data();
+  void compareUpcomingBookings();
+  void getFallbackFont_data();
+  void getFallbackFont();
+  void layoutName_data();
+  void layoutName();
+};
+
+void DataFetchingBench::initTestCase() {
+  // Keeps the settings of a display on this machine out of the numbers.
+  QStandardPaths::setTestModeEnabled(true);
+  QSettings settings;
+  settings.setValue(UNBOOKED_NAME_TEXT_SETTING, "Free");
+  settings.setValue(UNBOOKED_INFO_TEXT_SETTING, "Nothing booked");
+  settings.setValue(UNBOOKED_STATUS_TEXT_SETTING, "Available");
+  settings.setValue(BOOKED_USERNAME_PREFIX_TEXT_SETTING, "Booked by ");
+  settings.sync();
+  // The malformed payloads would otherwise log on every iteration.
+  QLoggingCategory::setFilterRules("roombooker.parse.warning=false");
+
+  m_displayMetrics = new DisplayMetrics();
+  m_clock = new SystemClock();
+  m_handler = new DataFetchingHandler(0, m_displayMetrics, m_clock, nullptr,
+                                      nullptr, nullptr);
+  m_isRecordingBaselines = qEnvironmentVariableIsSet(RECORD_BASELINES_VARIABLE);
+  readBaselines();
+
+  // Set up like BookingDisplay::addFontsToDatabase() and warmGlyphCaches().
+  QFontDatabase::addApplicationFont(ROOMBOOKER_DATA_BENCH_RESOURCES
+                                    "/ZillaSlabSemiBold.ttf");
+  FontFallbackCache::instance()->setFallbackFamilies(FALLBACK_FAMILIES);
+  FontFallbackCache::instance()->precomputeCoverage(getNameFont());
+}
+
+void DataFetchingBench::cleanupTestCase() {
+  if (m_isRecordingBaselines) {
+    writeBaselines();
+  }
+  delete m_handler;
+  delete m_clock;
+  delete m_displayMetrics;
+  QSettings().clear();
+}
+
+void DataFetchingBench::readBaselines() {
+  QFile baselinesFile(ROOMBOOKER_DATA_BENCH_BASELINES);
+  QJsonObject baselinesObject;
+  if (baselinesFile.open(QIODevice::ReadOnly)) {
+    baselinesObject = QJsonDocument::fromJson(baselinesFile.readAll()).object();
+  } else {
+    qWarning() << "Couldn't read the benchmark baselines from"
+               << baselinesFile.fileName();
+  }
+  m_baselines = baselinesObject["baselines"].toObject();
+
+  m_tolerance = baselinesObject["tolerance"].toDouble(DEFAULT_TOLERANCE);
+  bool isValidTolerance = false;
+  double tolerance =
+      qEnvironmentVariable(TOLERANCE_VARIABLE).toDouble(&isValidTolerance);
+  if (isValidTolerance) {
+    m_tolerance = tolerance;
+  }
+}
+
+void DataFetchingBench::writeBaselines() {
+  QFile baselinesFile(ROOMBOOKER_DATA_BENCH_BASELINES);
+  QJsonObject baselinesObject;
+  if (baselinesFile.open(QIODevice::ReadOnly)) {
+    baselinesObject = QJsonDocument::fromJson(baselinesFile.readAll()).object();
+    baselinesFile.close();
+  }
+
+  // Merged into the stored ones, so recording a single function with a
+  // filter on the command line leaves the others alone.
+  QJsonObject baselines = baselinesObject["baselines"].toObject();
+  for (auto it = m_recordedBaselines.constBegin();
+       it != m_recordedBaselines.constEnd(); ++it) {
+    baselines[it.key()] = it.value();
+  }
+  baselinesObject["baselines"] = baselines;
+  if (!baselinesObject.contains("tolerance")) {
+    baselinesObject["tolerance"] = DEFAULT_TOLERANCE;
+  }
+
+  QSaveFile saveFile(ROOMBOOKER_DATA_BENCH_BASELINES);
+  if (!saveFile.open(QIODevice::WriteOnly) ||
+      saveFile.write(QJsonDocument(baselinesObject).toJson()) < 0 ||
+      !saveFile.commit()) {
+    qWarning() << "Couldn't write the benchmark baselines to"
+               << saveFile.fileName();
+    return;
+  }
+  qInfo() << "Recorded" << m_recordedBaselines.size() << "baselines to"
+          << saveFile.fileName();
+}
+
+void DataFetchingBench::startMeasurement() {
+  m_iterations = 0;
+  m_measurementTimer.start();
+}
+
+void DataFetchingBench::compareWithBaseline() {
+  // QBENCHMARK runs its body as often as it needs, every run is counted so
+  // this is the average over all of them.
+  qint64 elapsedTime = m_measurementTimer.nsecsElapsed();
+  QVERIFY(m_iterations > 0);
+  double iterationTime = double(elapsedTime) / m_iterations;
+  QString key = QString("%1/%2").arg(QTest::currentTestFunction(),
+                                     QTest::currentDataTag());
+
+  if (m_isRecordingBaselines) {
+    m_recordedBaselines[key] = qRound64(iterationTime);
+    return;
+  }
+
+  QString missingBaselineMessage =
+      QString("%1 ns per iteration, but no baseline is recorded. Record one "
+              "with %2=1.")
+          .arg(iterationTime)
+          .arg(RECORD_BASELINES_VARIABLE);
+#ifdef QT_NO_DEBUG
+  // A row without a baseline would pass no matter how slow it got.
+  QVERIFY2(m_baselines.contains(key), qPrintable(missingBaselineMessage));
+#else
+  if (!m_baselines.contains(key)) {
+    QSKIP(qPrintable(missingBaselineMessage));
+  }
+#endif
+
+  double baseline = m_baselines[key].toDouble();
+  qInfo().nospace() << key << ": " << iterationTime
+                    << " ns per iteration, baseline " << baseline << " ns";
+#ifdef QT_NO_DEBUG
+  QVERIFY2(iterationTime <= baseline * (1.0 + m_tolerance),
+           qPrintable(QString("%1 ns per iteration is more than %2% over the "
+                              "baseline of %3 ns")
+                          .arg(iterationTime)
+                          .arg(m_tolerance * 100)
+                          .arg(baseline)));
+#else
+  // Baselines are recorded with release builds, a debug build being slower
+  // says nothing.
+#endif
+}
+
+QFont DataFetchingBench::getNameFont() {
+  QFont nameFont("Zilla Slab SemiBold");
+  nameFont.setPixelSize(NAME_PIXEL_SIZE);
+  return nameFont;
+}
+
+QJsonObject DataFetchingBench::getParsedPayload(const QByteArray &payload) {
+  return m_handler->getParsedBookingDataObjectFromReplyString(
+      QString::fromUtf8(payload));
+}
+
+void DataFetchingBench::parseReply_data() { addPayloadRows(); }
+
+void DataFetchingBench::parseReply() {
+  QFETCH(QByteArray, payload);
+  // Replies are turned into a string before parsing, see
+  // onBookingDataRequestFinished.
+  QString replyString = QString::fromUtf8(payload);
+  QJsonObject parsedObject;
+
+  startMeasurement();
+  QBENCHMARK {
+    parsedObject =
+        m_handler->getParsedBookingDataObjectFromReplyString(replyString);
+    m_iterations++;
+  }
+  compareWithBaseline();
+}
+
+void DataFetchingBench::getCurrentBookingData_data() { addPayloadRows(); }
+
+void DataFetchingBench::getCurrentBookingData() {
+  QFETCH(QByteArray, payload);
+  QJsonObject parsedObject = getParsedPayload(payload);
+  CurrentBookingData currentBooking;
+
+  startMeasurement();
+  QBENCHMARK {
+    currentBooking = m_handler->getCurrentBookingData(parsedObject);
+    m_iterations++;
+  }
+  compareWithBaseline();
+}
+
+void DataFetchingBench::getUpcomingBookings_data() { addPayloadRows(); }
+
+void DataFetchingBench::getUpcomingBookings() {
+  QFETCH(QByteArray, payload);
+  QJsonObject parsedObject = getParsedPayload(payload);
+  QList<UpcomingBookingData> upcomingBookings;
+
+  startMeasurement();
+  QBENCHMARK {
+    upcomingBookings = m_handler->getUpcomingBookings(parsedObject);
+    m_iterations++;
+  }
+  QCOMPARE(upcomingBookings.size(), 3);
+  compareWithBaseline();
+}
+
+void DataFetchingBench::getTimeString_data() {
+  QTest::addColumn<qint64>("startTime");
+  QTest::addColumn<qint64>("endTime");
+
+  QTest::newRow("booking") << DAY_START_TIME << DAY_START_TIME + 30 * 60 - 1;
+  QTest::newRow("unset") << qint64(0) << qint64(0);
+  QTest::newRow("multiDay") << DAY_START_TIME
+                            << DAY_START_TIME + 3 * 24 * 60 * 60 - 1;
+  // The last second QDateTime still formats with four digit years.
+  QTest::newRow("farFuture") << qint64(253402300000)
+                             << qint64(253402300799);
+}
+
+void DataFetchingBench::getTimeString() {
+  QFETCH(qint64, startTime);
+  QFETCH(qint64, endTime);
+  QString timeString;
+
+  startMeasurement();
+  QBENCHMARK {
+    timeString = m_handler->getTimeStringFromStartEndTime(startTime, endTime);
+    m_iterations++;
+  }
+  compareWithBaseline();
+}
+
+void DataFetchingBench::compareCurrentBookingData_data() { addPayloadRows(); }
+
+void DataFetchingBench::compareCurrentBookingData() {
+  QFETCH(QByteArray, payload);
+  // Parsed twice so the strings aren't shared, like the stored state and a
+  // freshly polled booking.
+  CurrentBookingData storedBooking =
+      m_handler->getCurrentBookingData(getParsedPayload(payload));
+  CurrentBookingData polledBooking =
+      m_handler->getCurrentBookingData(getParsedPayload(payload));
+  qint64 unchangedCount = 0;
+
+  startMeasurement();
+  QBENCHMARK {
+    unchangedCount += polledBooking != storedBooking ? 0 : 1;
+    m_iterations++;
+  }
+  QCOMPARE(unchangedCount, m_iterations);
+  compareWithBaseline();
+}
+
+void DataFetchingBench::compareUpcomingBookings_data() { addPayloadRows(); }
+
+void DataFetchingBench::compareUpcomingBookings() {
+  QFETCH(QByteArray, payload);
+  QList<UpcomingBookingData> storedBookings =
+      m_handler->getUpcomingBookings(getParsedPayload(payload));
+  QList<UpcomingBookingData> polledBookings =
+      m_handler->getUpcomingBookings(getParsedPayload(payload));
+  qint64 unchangedCount = 0;
+
+  startMeasurement();
+  QBENCHMARK {
+    unchangedCount += polledBookings != storedBookings ? 0 : 1;
+    m_iterations++;
+  }
+  QCOMPARE(unchangedCount, m_iterations);
+  compareWithBaseline();
+}
+
+void DataFetchingBench::getFallbackFont_data() { addNameRows(); }
+
+void DataFetchingBench::getFallbackFont() {
+  QFETCH(QString, name);
+  QFont nameFont = getNameFont();
+  QFont fallbackFont;
+
+  startMeasurement();
+  QBENCHMARK {
+    fallbackFont =
+        FontFallbackCache::instance()->getFallbackFont(nameFont, name);
+    m_iterations++;
+  }
+  QCOMPARE(fallbackFont.family(), nameFont.family());
+  compareWithBaseline();
+}
+
+void DataFetchingBench::layoutName_data() { addNameRows(); }
+
+// What a label does with a new booking name, see PrerenderedLabel. Qt keeps
+// the fallback fonts it found per font, so its walk through the system fonts
+// mostly shows up in the first iterations and as the difference between the
+// rows with and without the chain on a machine with many fonts.
+void DataFetchingBench::layoutName() {
+  QFETCH(QString, name);
+  QFETCH(bool, usesFallbackChain);
+  QFont nameFont = getNameFont();
+  if (usesFallbackChain) {
+    nameFont = FontFallbackCache::instance()->getFallbackFont(nameFont, name);
+  }
+  int lineCount = 0;
+
+  startMeasurement();
+  QBENCHMARK {
+    QTextLayout textLayout(name, nameFont);
+    textLayout.beginLayout();
+    qreal height = 0;
+    lineCount = 0;
+    for (QTextLine line = textLayout.createLine(); line.isValid();
+         line = textLayout.createLine()) {
+      line.setLineWidth(NAME_LAYOUT_WIDTH);
+      line.setPosition(QPointF(0, height));
+      height += line.height();
+      lineCount++;
+    }
+    textLayout.endLayout();
+    m_iterations++;
+  }
+  QVERIFY(lineCount > 0);
+  compareWithBaseline();
+}
+
+// Laying out text needs a QGuiApplication, ctest runs this on the offscreen
+// platform.
+QTEST_MAIN(DataFetchingBench)
+#include "datafetchingbench.moc"
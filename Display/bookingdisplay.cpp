@@ -1,149 +1,624 @@
 #include "bookingdisplay.h"
 #include "./settings/settingspopup.h"
-#include "./widgets/clickableicon.h"
+#include "animations/pacedanimationdriver.h"
+#include "diagnostics/logging.h"
+#include "diagnostics/metricsserver.h"
+#include "diagnostics/payloadreplayer.h"
+#include "diagnostics/transitionbenchmark.h"
+#include "assets/fontfallbackcache.h"
+#include "assets/textprerenderer.h"
+#include "network/avatarstore.h"
+#include "network/relayserver.h"
 #include "settingstrings.h"
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
 #include <QFontDatabase>
-#include <QHBoxLayout>
+#include <QScreen>
 #include <QSettings>
-#include <QTimer>
-#include <QVBoxLayout>
-#include <QWidget>
+#include <QStandardPaths>
 #include <qevent.h>
 
 BookingDisplay::BookingDisplay(int &argc, char **argv)
-    : QApplication(argc, argv) {
-  configureStoredColors();
-  addFontsToDatabase();
+    : QApplication(argc, argv), m_networkManager(nullptr),
+      m_eventLoopMonitor(nullptr), m_displayMetrics(nullptr),
+      m_occupancyHistory(nullptr), m_clock(nullptr),
+      m_clockOffsetEstimator(nullptr), m_loggingThread(nullptr),
+      m_logWriter(nullptr), m_benchmarkTransitionCount(0), m_replaySpeed(1.0),
+      m_epaperFrontend(nullptr) {
+  qRegisterMetaType<DisplayState>();
+  qRegisterMetaType<ScheduleDayPage>();
+
   populateSettingsIfNeeded();
+  startLogging();
+  parseCommandLineOptions();
+  readScreenConfigurations();
+  addFontsToDatabase();
+  warmGlyphCaches();
 
-  m_bookingWidget = new BookingWidget();
-  m_bookingName = new BookingName();
-  m_bookingInfo = new BookingInfo();
-  m_bookingStatus = new BookingStatus();
-  m_dataFetchingHandler = new DataFetchingHandler();
-  m_upcomingBookings = new UpcomingBookings();
+  createClock();
+  m_displayMetrics = new DisplayMetrics(this);
+  m_dataFetchingThread = new QThread(this);
+  createOccupancyHistory();
+  createDataFetchingHandlers();
 
-  configureWidgetLayout();
-  connectSignals();
-  m_bookingWidget->show();
+  QSettings settings;
+  if (settings.value(MEASURE_EVENT_LOOP_STALLS_SETTING).toBool() ||
+      m_benchmarkTransitionCount > 0) {
+    m_eventLoopMonitor = new EventLoopMonitor(this);
+    for (DataFetchingHandler *dataFetchingHandler :
+         std::as_const(m_dataFetchingHandlers)) {
+      connect(dataFetchingHandler, &DataFetchingHandler::displayStateChanged,
+              m_eventLoopMonitor,
+              [this]() { m_eventLoopMonitor->watchTransition(4000); });
+    }
+  }
 
-  m_dataFetchingHandler->getBookingData();
+  if (m_frontendName == "quick") {
+    createQuickFrontend();
+  } else if (m_frontendName == "epaper") {
+    createEpaperFrontend();
+  } else {
+    createWidgetFrontend();
+  }
+
+  if (m_benchmarkTransitionCount > 0) {
+    startTransitionBenchmark();
+  } else if (!m_replayFilePath.isEmpty()) {
+    startMetricsServer();
+    startPayloadReplay();
+    startDataFetchingThread();
+  } else {
+    startMetricsServer();
+    startRelayServer();
+    startScheduleCaches();
+    startAvatarStore();
+    startDataFetchingThread();
+  }
   this->exec();
 }
 
+// The clock and its offset estimator are used from the data fetching thread
+// too, which is stopped on aboutToQuit, so they are safe to delete here. The
+// Qt Quick window and its scene graph have to go while the application is
+// still there, not with the rest of its children. The log writer goes last,
+// so it still writes what the rest logged on the way.
+BookingDisplay::~BookingDisplay() {
+#ifdef ROOMBOOKER_QUICK_FRONTEND
+  delete m_quickFrontend;
+#endif
+  delete m_clock;
+  delete m_clockOffsetEstimator;
+  if (m_logWriter) {
+    m_loggingThread->quit();
+    m_loggingThread->wait();
+    delete m_logWriter;
+  }
+}
+
+void BookingDisplay::startLogging() {
+  QSettings settings;
+  setLogLevel(settings.value(LOG_LEVEL_SETTING).toString());
+  QString logDirectoryPath = settings.value(LOG_DIRECTORY_SETTING).toString();
+  if (logDirectoryPath.isEmpty()) {
+    return;
+  }
+
+  // Gets a thread of its own, so a slow disk never holds up the polls or the
+  // animations. Installed right away to also catch what is logged during
+  // startup, which is written once the thread gets going.
+  m_logWriter = new LogWriter(
+      logDirectoryPath,
+      settings.value(LOG_MAX_FILE_SIZE_SETTING).toLongLong() * 1024,
+      settings.value(LOG_MAX_FILE_COUNT_SETTING).toInt(),
+      settings.value(LOG_RATE_LIMIT_SETTING).toInt());
+  m_loggingThread = new QThread(this);
+  m_logWriter->moveToThread(m_loggingThread);
+  connect(m_loggingThread, &QThread::started, m_logWriter,
+          &LogWriter::startWriting);
+  // finished is emitted from the logging thread itself, so a direct
+  // connection stops the timer there. Deleting the writer later from this
+  // thread would otherwise stop a timer of another thread.
+  connect(m_loggingThread, &QThread::finished, m_logWriter,
+          &LogWriter::stopWriting, Qt::DirectConnection);
+  m_logWriter->install();
+  m_loggingThread->start();
+  qCInfo(lcSettings) << "Using settings from" << settings.fileName();
+}
+
+void BookingDisplay::createClock() {
+  if (m_replayFilePath.isEmpty()) {
+    // Booking boundaries are the backend's, so the display runs on its clock.
+    m_clockOffsetEstimator = new ClockOffsetEstimator();
+    m_clock = new SystemClock(m_clockOffsetEstimator);
+    return;
+  }
+
+  // Replays run on a clock starting at the first recorded reply, so the time
+  // strings and everything scheduled against them match the recording.
+  qint64 firstPayloadTime =
+      PayloadReplayer::getFirstPayloadTime(m_replayFilePath);
+  m_clock = new SimulatedClock(firstPayloadTime > 0
+                                   ? firstPayloadTime
+                                   : QDateTime::currentMSecsSinceEpoch(),
+                               m_replaySpeed);
+}
+
 void BookingDisplay::addFontsToDatabase() {
   QFontDatabase::addApplicationFont(":/resources/ZillaSlabLight.ttf");
   QFontDatabase::addApplicationFont(":/resources/ZillaSlabSemiBold.ttf");
+
+  QSettings settings;
+  QStringList fallbackFamilies =
+      settings.value(FALLBACK_FONT_FAMILIES_SETTING).toString().split(',');
+#ifdef ROOMBOOKER_EMOJI_FONT
+  // Also at the end of chains configured before the font was bundled, so
+  // every display has emoji even without any installed.
+  int emojiFontId =
+      QFontDatabase::addApplicationFont(":/resources/NotoEmoji-Regular.ttf");
+  if (emojiFontId < 0) {
+    qCWarning(lcSettings) << "Could not load the bundled emoji font";
+  } else {
+    for (const QString &family :
+         QFontDatabase::applicationFontFamilies(emojiFontId)) {
+      if (!fallbackFamilies.contains(family)) {
+        fallbackFamilies.append(family);
+      }
+    }
+  }
+#endif
+
+  // Only for fonts on top of the bundled ones, like color emoji or scripts
+  // the chain should cover on a particular display.
+  const QFileInfoList fallbackFontFiles =
+      QDir(settings.value(FALLBACK_FONT_DIRECTORY_SETTING).toString())
+          .entryInfoList({"*.ttf", "*.otf", "*.ttc"}, QDir::Files);
+  for (const QFileInfo &fallbackFontFile : fallbackFontFiles) {
+    if (QFontDatabase::addApplicationFont(
+            fallbackFontFile.absoluteFilePath()) < 0) {
+      qCWarning(lcSettings) << "Could not load the fallback font"
+                            << fallbackFontFile.absoluteFilePath();
+    }
+  }
+  FontFallbackCache::instance()->setFallbackFamilies(fallbackFamilies);
 }
 
-void BookingDisplay::configureStoredColors() {
+void BookingDisplay::warmGlyphCaches() {
   QSettings settings;
-  m_unbookedColor = settings.value(UNBOOKED_COLOR_SETTING).value<QColor>();
-  m_bookedColor = settings.value(BOOKED_COLOR_SETTING).value<QColor>();
-};
+  const QStringList fontSettings = {
+      BOOKNG_NAME_FONT_SETTING, BOOKING_INFO_FONT_SETTING,
+      BOOKING_STATUS_FONT_SETTING, UPCOMING_BOOKINGS_BOLD_FONT_SETTING,
+      UPCOMING_BOOKINGS_LIGHT_FONT_SETTING};
+  for (const QString &fontSetting : fontSettings) {
+    QFont font = settings.value(fontSetting).value<QFont>();
+    TextPrerenderer::instance()->warmGlyphCache(font);
+    FontFallbackCache::instance()->precomputeCoverage(font);
+  }
+}
 
 void BookingDisplay::populateSettingsIfNeeded() {
   QSettings settings;
-  if (settings.contains(API_ADDRESS_SETTING)) {
-    return;
-  }
+  // Only filling in what's missing, so settings added in newer versions also
+  // get a sensible default on displays that were configured before.
+  auto setDefault = [&settings](const QString &key, const QVariant &value) {
+    if (!settings.contains(key)) {
+      settings.setValue(key, value);
+    }
+  };
+
+  setDefault(API_ADDRESS_SETTING, "http://127.0.0.1:37222");
+  setDefault(ROOM_ID_SETTING, 1);
+  setDefault(API_HEDGE_DELAY_SETTING, 500);
+  setDefault(API_POLL_INTERVAL_SETTING, 1000);
+  setDefault(API_ERROR_AFTER_FAILURES_SETTING, 5);
+  setDefault(API_ERROR_AFTER_TIME_SETTING, 20000);
 
-  settings.setValue(API_ADDRESS_SETTING, "http://127.0.0.1:37222");
-  settings.setValue(ROOM_ID_SETTING, 1);
+  setDefault(UNBOOKED_NAME_TEXT_SETTING, "Configure me please!");
+  setDefault(UNBOOKED_INFO_TEXT_SETTING, "Bookable through Slack");
+  setDefault(UNBOOKED_STATUS_TEXT_SETTING, "Free");
+  setDefault(BOOKED_USERNAME_PREFIX_TEXT_SETTING, "Booked by ");
+  setDefault(BOOK_NOW_NAME_TEXT_SETTING, "Walk-up booking");
+  setDefault(BOOK_NOW_USER_TEXT_SETTING, "the room display");
+  setDefault(BOOK_NOW_REFUSED_TEXT_SETTING,
+             "Sorry, the room can't be booked for that long right now.");
 
-  settings.setValue(UNBOOKED_NAME_TEXT_SETTING, "Configure me please!");
-  settings.setValue(UNBOOKED_INFO_TEXT_SETTING, "Bookable through Slack");
-  settings.setValue(UNBOOKED_STATUS_TEXT_SETTING, "Free");
-  settings.setValue(BOOKED_USERNAME_PREFIX_TEXT_SETTING, "Booked by ");
+  setDefault(BOOKING_NAME_MAX_CHARACTERS, 43);
+  setDefault(BOOKING_USERNAME_MAX_CHARACTERS, 35);
+  setDefault(UPCOMING_BOOKING_NAME_MAX_CHARACTERS, 17);
 
-  settings.setValue(BOOKING_NAME_MAX_CHARACTERS, 43);
-  settings.setValue(BOOKING_USERNAME_MAX_CHARACTERS, 35);
-  settings.setValue(UPCOMING_BOOKING_NAME_MAX_CHARACTERS, 17);
+  setDefault(BACKGROUND_COLOR_SETTING, QColor("#202030"));
+  setDefault(UNBOOKED_COLOR_SETTING, QColor("#82D173"));
+  setDefault(BOOKED_COLOR_SETTING, QColor("#2F4858"));
 
-  settings.setValue(BACKGROUND_COLOR_SETTING, QColor("#202030"));
-  settings.setValue(UNBOOKED_COLOR_SETTING, QColor("#82D173"));
-  settings.setValue(BOOKED_COLOR_SETTING, QColor("#2F4858"));
+  setDefault(BOOKNG_NAME_FONT_SETTING, QFont("Zilla Slab SemiBold", 72));
+  setDefault(BOOKING_INFO_FONT_SETTING, QFont("Zilla Slab Light", 30));
+  setDefault(BOOKING_STATUS_FONT_SETTING, QFont("Zilla Slab Light", 50));
+  setDefault(UPCOMING_BOOKINGS_BOLD_FONT_SETTING,
+             QFont("Zilla Slab SemiBold", 25));
+  setDefault(UPCOMING_BOOKINGS_LIGHT_FONT_SETTING,
+             QFont("Zilla Slab Light", 25));
+  setDefault(FALLBACK_FONT_FAMILIES_SETTING,
+             "Noto Color Emoji,Noto Emoji,Segoe UI Emoji,Apple Color Emoji,"
+             "Noto Sans,Noto Sans CJK JP,Noto Sans Arabic,Noto Sans Hebrew,"
+             "Segoe UI,Microsoft YaHei,Segoe UI Symbol");
+  setDefault(FALLBACK_FONT_DIRECTORY_SETTING,
+             QCoreApplication::applicationDirPath() + "/fonts");
 
-  settings.setValue(BOOKNG_NAME_FONT_SETTING, QFont("Zilla Slab SemiBold", 72));
-  settings.setValue(BOOKING_INFO_FONT_SETTING, QFont("Zilla Slab Light", 30));
-  settings.setValue(BOOKING_STATUS_FONT_SETTING, QFont("Zilla Slab Light", 50));
-  settings.setValue(UPCOMING_BOOKINGS_BOLD_FONT_SETTING,
-                    QFont("Zilla Slab SemiBold", 25));
-  settings.setValue(UPCOMING_BOOKINGS_LIGHT_FONT_SETTING,
-                    QFont("Zilla Slab Light", 25));
+  setDefault(ICON_FILE_PATH_SETTING, ":/resources/defaulticon.png");
+  setDefault(UNBOOKED_BACKGROUND_IMAGE_SETTING, "");
+  setDefault(BOOKED_BACKGROUND_IMAGE_SETTING, "");
+  setDefault(AVATARS_ENABLED_SETTING, true);
+  setDefault(AVATAR_DISK_CACHE_SIZE_SETTING, 8 * 1024);
 
-  settings.setValue(ICON_FILE_PATH_SETTING, ":/resources/defaulticon.png");
+  setDefault(MEASURE_EVENT_LOOP_STALLS_SETTING, false);
+  setDefault(METRICS_PORT_SETTING, 0);
+  setDefault(RECORD_PAYLOADS_PATH_SETTING, "");
+  setDefault(OCCUPANCY_HISTORY_PATH_SETTING,
+             QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+                 "/occupancyhistory.bin");
+  setDefault(LOG_DIRECTORY_SETTING,
+             QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+                 "/logs");
+  setDefault(LOG_LEVEL_SETTING, "info");
+  setDefault(LOG_MAX_FILE_SIZE_SETTING, 1024);
+  setDefault(LOG_MAX_FILE_COUNT_SETTING, 5);
+  setDefault(LOG_RATE_LIMIT_SETTING, 30);
+  setDefault(RELAY_ENABLED_SETTING, false);
+  setDefault(RELAY_PORT_SETTING, 37222);
+  setDefault(RELAY_ROOM_IDS_SETTING, "");
+  setDefault(RELAY_REFRESH_INTERVAL_SETTING, 1000);
+  setDefault(RELAY_MAX_AGE_SETTING, 2000);
+  setDefault(RELAY_MAX_STALE_AGE_SETTING, 30000);
+
+  setDefault(FRONTEND_SETTING, "widgets");
+  setDefault(MAX_TRANSITION_DURATION_SETTING, 4000);
+  setDefault(MAX_FRAME_RATE_SETTING, 60);
+  setDefault(BOOK_NOW_ENABLED_SETTING, true);
+  setDefault(BOOK_NOW_TOKEN_SETTING, "");
+  setDefault(EPAPER_WIDTH_SETTING, 800);
+  setDefault(EPAPER_HEIGHT_SETTING, 480);
+  setDefault(EPAPER_GREY_LEVELS_SETTING, 16);
+  setDefault(EPAPER_OUTPUT_PATH_SETTING,
+             QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+                 "/epaper.raw");
+  setDefault(EPAPER_FULL_REFRESH_AFTER_SETTING, 50);
+  setDefault(SCREEN_ROOM_IDS_SETTING, "");
 
   settings.sync();
 }
 
-void BookingDisplay::configureWidgetLayout() {
-  QVBoxLayout *bookingWidgetVerticalLayout = new QVBoxLayout();
+void BookingDisplay::parseCommandLineOptions() {
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  QCommandLineOption frontendOption(
+      "frontend",
+      "Frontend to render with, either widgets, quick or epaper. The epaper "
+      "frontend draws offscreen, so it can run with -platform offscreen.",
+      "frontend");
+  QCommandLineOption benchmarkOption(
+      "benchmark-transitions",
+      "Play this many synthetic transitions instead of fetching data, print "
+      "frame statistics and quit.",
+      "count");
+  QCommandLineOption replayOption(
+      "replay",
+      "Replay a payload log recorded through the recordPayloadsPath setting "
+      "instead of fetching data.",
+      "file");
+  QCommandLineOption replaySpeedOption(
+      "replay-speed", "Playback speed of --replay, 1 being real time.",
+      "factor", "1");
+  parser.addOption(frontendOption);
+  parser.addOption(benchmarkOption);
+  parser.addOption(replayOption);
+  parser.addOption(replaySpeedOption);
+  parser.process(*this);
+
+  QSettings settings;
+  m_frontendName = parser.isSet(frontendOption)
+                       ? parser.value(frontendOption)
+                       : settings.value(FRONTEND_SETTING).toString();
+  m_benchmarkTransitionCount = parser.value(benchmarkOption).toInt();
+  m_replayFilePath = parser.value(replayOption);
+  m_replaySpeed = parser.value(replaySpeedOption).toDouble();
+}
+
+void BookingDisplay::readScreenConfigurations() {
+  QSettings settings;
+  // Per screen overrides fall back to the settings every screen shares.
+  auto screenValue = [&settings](int screenIndex, const QString &key) {
+    QString overrideKey = SCREEN_OVERRIDE_PREFIX.arg(screenIndex) + key;
+    return settings.value(settings.contains(overrideKey) ? overrideKey : key);
+  };
+
+  QList<int> roomIds;
+  const QStringList roomIdStrings =
+      settings.value(SCREEN_ROOM_IDS_SETTING).toString().split(',');
+  for (const QString &roomId : roomIdStrings) {
+    bool isNumber = false;
+    int parsedRoomId = roomId.trimmed().toInt(&isNumber);
+    if (isNumber) {
+      roomIds.append(parsedRoomId);
+    }
+  }
+  if (roomIds.isEmpty()) {
+    roomIds.append(settings.value(ROOM_ID_SETTING).toInt());
+  }
+
+  for (int screenIndex = 0; screenIndex < roomIds.size(); screenIndex++) {
+    ScreenConfiguration configuration;
+    configuration.roomId = roomIds[screenIndex];
+    configuration.backgroundColor =
+        screenValue(screenIndex, BACKGROUND_COLOR_SETTING).value<QColor>();
+    configuration.unbookedColor =
+        screenValue(screenIndex, UNBOOKED_COLOR_SETTING).value<QColor>();
+    configuration.bookedColor =
+        screenValue(screenIndex, BOOKED_COLOR_SETTING).value<QColor>();
+    m_screenConfigurations.append(configuration);
+  }
+}
+
+void BookingDisplay::createDataFetchingHandlers() {
+  // A single network manager for every room, so they share its connections
+  // to the backend. Replays and benchmarks don't go over the network.
+  if (m_replayFilePath.isEmpty() && m_benchmarkTransitionCount == 0) {
+    m_networkManager = new QNetworkAccessManager();
+    m_networkManager->moveToThread(m_dataFetchingThread);
+  }
+
+  // The metrics, the occupancy history and the other diagnostics follow the
+  // primary room. The metrics have no room label, so the other rooms would
+  // overwrite its gauges and add to its counters.
+  for (const ScreenConfiguration &configuration :
+       std::as_const(m_screenConfigurations)) {
+    bool isPrimaryRoom = m_dataFetchingHandlers.isEmpty();
+    m_dataFetchingHandlers.append(new DataFetchingHandler(
+        configuration.roomId, isPrimaryRoom ? m_displayMetrics : nullptr,
+        m_clock, m_clockOffsetEstimator,
+        isPrimaryRoom ? m_occupancyHistory : nullptr, m_networkManager));
+  }
+}
+
+void BookingDisplay::createWidgetFrontend() {
+  int maxFrameRate = QSettings().value(MAX_FRAME_RATE_SETTING).toInt();
+  if (maxFrameRate > 0) {
+    PacedAnimationDriver *animationDriver =
+        new PacedAnimationDriver(maxFrameRate, m_displayMetrics, this);
+    animationDriver->install();
+  }
+
+  // Screens are assigned in the order Qt lists them, rooms without a screen
+  // of their own end up on the primary one.
+  const QList<QScreen *> screens = QGuiApplication::screens();
+  for (int screenIndex = 0; screenIndex < m_screenConfigurations.size();
+       screenIndex++) {
+    if (screenIndex >= screens.size()) {
+      qCWarning(lcSettings) << "No screen for room"
+                            << m_screenConfigurations[screenIndex].roomId
+                            << ", showing it on the primary screen.";
+    }
+    BookingScreen *bookingScreen = new BookingScreen(
+        m_screenConfigurations[screenIndex],
+        screens.value(screenIndex, QGuiApplication::primaryScreen()), m_clock,
+        this);
+    bookingScreen->connectDataFetchingHandler(
+        m_dataFetchingHandlers[screenIndex]);
+    connect(bookingScreen, &BookingScreen::settingsWindowRequested, this,
+            &BookingDisplay::openSettingsWindow);
+    m_bookingScreens.append(bookingScreen);
+  }
+}
+
+void BookingDisplay::createQuickFrontend() {
+#ifdef ROOMBOOKER_QUICK_FRONTEND
+  QuickBookingFrontend::configureSoftwareRendering();
+  m_quickFrontend = new QuickBookingFrontend(this);
+
+  // The Qt Quick frontend has a single window, showing the primary room.
+  connect(m_dataFetchingHandlers.first(),
+          &DataFetchingHandler::displayStateChanged, m_quickFrontend,
+          &QuickBookingFrontend::updateDisplayState);
+  connect(m_quickFrontend, &QuickBookingFrontend::settingsWindowRequested,
+          this, &BookingDisplay::openSettingsWindow);
+
+  // The software render loop runs on the GUI thread, so these are emitted
+  // right around the actual rasterization of a frame.
+  QQuickWindow *quickWindow = m_quickFrontend->window();
+  connect(
+      quickWindow, &QQuickWindow::beforeSynchronizing, this,
+      [this]() { m_quickFrameTimer.start(); }, Qt::DirectConnection);
+  connect(
+      quickWindow, &QQuickWindow::afterRendering, this,
+      [this]() {
+        m_displayMetrics->recordFrameTime(m_quickFrameTimer.nsecsElapsed() /
+                                          1e9);
+      },
+      Qt::DirectConnection);
+
+  m_quickFrontend->show();
+#else
+  qCWarning(lcSettings)
+      << "Built without Qt Quick, falling back to the widget frontend.";
+  createWidgetFrontend();
+#endif
+}
+
+void BookingDisplay::createEpaperFrontend() {
+  // Like the Qt Quick frontend it shows the primary room only. Nothing
+  // animates on a panel that takes a second to refresh, so there is no
+  // animation driver either.
+  QSettings settings;
+  m_epaperFrontend = new EpaperFrontend(
+      new EpaperFramebufferSink(
+          settings.value(EPAPER_OUTPUT_PATH_SETTING).toString()),
+      m_displayMetrics, m_clock, this);
+  connect(m_dataFetchingHandlers.first(),
+          &DataFetchingHandler::displayStateChanged, m_epaperFrontend,
+          &EpaperFrontend::updateDisplayState);
+}
+
+void BookingDisplay::startDataFetchingThread() {
+  // The handlers have no parent so they can be moved to the worker thread.
+  // They are owned by that thread from here on and deleted once it finishes,
+  // as is the network manager they share.
+  for (DataFetchingHandler *dataFetchingHandler :
+       std::as_const(m_dataFetchingHandlers)) {
+    dataFetchingHandler->moveToThread(m_dataFetchingThread);
+    // Without a network manager this only starts the booking boundary and
+    // day timers, replays don't poll.
+    connect(m_dataFetchingThread, &QThread::started, dataFetchingHandler,
+            &DataFetchingHandler::startDataFetching);
+    connect(m_dataFetchingThread, &QThread::finished, dataFetchingHandler,
+            &QObject::deleteLater);
+  }
+  if (m_networkManager) {
+    connect(m_dataFetchingThread, &QThread::finished, m_networkManager,
+            &QObject::deleteLater);
+  }
+  connect(this, &QApplication::aboutToQuit, this,
+          &BookingDisplay::stopDataFetchingThread);
+  m_dataFetchingThread->start();
+}
+
+void BookingDisplay::startPayloadReplay() {
+  // Takes the place of the polling, feeding the recorded replies into the
+  // handlers on their own thread. Call before starting that thread. The
+  // recording is of a single room, so every screen replays the same one.
+  PayloadReplayer *payloadReplayer =
+      new PayloadReplayer(m_replayFilePath, m_clock);
+  payloadReplayer->moveToThread(m_dataFetchingThread);
+  for (DataFetchingHandler *dataFetchingHandler :
+       std::as_const(m_dataFetchingHandlers)) {
+    connect(payloadReplayer, &PayloadReplayer::payloadReplayed,
+            dataFetchingHandler, &DataFetchingHandler::processPayload);
+  }
+  connect(m_dataFetchingThread, &QThread::started, payloadReplayer,
+          &PayloadReplayer::startReplaying);
+  connect(m_dataFetchingThread, &QThread::finished, payloadReplayer,
+          &QObject::deleteLater);
+}
+
+void BookingDisplay::startRelayServer() {
+  QSettings settings;
+  if (!settings.value(RELAY_ENABLED_SETTING).toBool()) {
+    return;
+  }
 
-  bookingWidgetVerticalLayout->setAlignment(Qt::AlignTop);
-  bookingWidgetVerticalLayout->setContentsMargins(15, 0, 0, 0);
-  m_bookingWidget->setLayout(bookingWidgetVerticalLayout);
+  // Shares the data fetching thread with the poller and the metrics endpoint.
+  // Call before starting that thread.
+  RelayServer *relayServer = new RelayServer(m_displayMetrics);
+  relayServer->moveToThread(m_dataFetchingThread);
+  connect(m_dataFetchingThread, &QThread::started, relayServer,
+          &RelayServer::startRelaying);
+  connect(m_dataFetchingThread, &QThread::finished, relayServer,
+          &QObject::deleteLater);
+}
 
-  QWidget *topSectionHorizontalDividerWidget = new QWidget();
-  QHBoxLayout *topSectionHorizontalDividerLayout =
-      new QHBoxLayout(topSectionHorizontalDividerWidget);
-  topSectionHorizontalDividerLayout->setContentsMargins(0, 0, 0, 0);
-  bookingWidgetVerticalLayout->addWidget(topSectionHorizontalDividerWidget, 4);
+void BookingDisplay::startScheduleCaches() {
+  // One per room with a week view, which only the widget frontend has. Call
+  // before starting the data fetching thread.
+  for (int screenIndex = 0; screenIndex < m_bookingScreens.size();
+       screenIndex++) {
+    ScheduleCache *scheduleCache =
+        new ScheduleCache(m_screenConfigurations[screenIndex].roomId, m_clock,
+                          m_networkManager);
+    scheduleCache->moveToThread(m_dataFetchingThread);
+    connect(m_dataFetchingThread, &QThread::started, scheduleCache,
+            &ScheduleCache::startCaching);
+    connect(m_dataFetchingThread, &QThread::finished, scheduleCache,
+            &QObject::deleteLater);
 
-  QWidget *topSectionLeftSideWidget = new QWidget();
-  QVBoxLayout *topSectionLeftSideLayout =
-      new QVBoxLayout(topSectionLeftSideWidget);
-  topSectionLeftSideLayout->addWidget(m_bookingName);
-  topSectionLeftSideLayout->addStretch();
-  topSectionLeftSideLayout->addWidget(m_bookingInfo);
-  topSectionHorizontalDividerLayout->addWidget(topSectionLeftSideWidget, 3);
+    connect(m_dataFetchingHandlers[screenIndex],
+            &DataFetchingHandler::scheduleVersionChanged, scheduleCache,
+            &ScheduleCache::setScheduleVersion);
+    m_bookingScreens[screenIndex]->connectScheduleCache(scheduleCache);
+  }
+}
 
-  topSectionHorizontalDividerLayout->addWidget(m_upcomingBookings, 1);
+void BookingDisplay::startAvatarStore() {
+  QSettings settings;
+  if (!settings.value(AVATARS_ENABLED_SETTING).toBool() ||
+      m_bookingScreens.isEmpty()) {
+    return;
+  }
 
-  QWidget *bottomSectionWidget = new QWidget();
-  QHBoxLayout *bottomSectionHorizontalLayout =
-      new QHBoxLayout(bottomSectionWidget);
-  bottomSectionHorizontalLayout->addWidget(m_bookingStatus);
-  bookingWidgetVerticalLayout->addWidget(bottomSectionWidget, 1);
-  bottomSectionHorizontalLayout->addStretch();
-  bottomSectionHorizontalLayout->setContentsMargins(9, 0, 20, 0);
+  // Shared by every screen, bookers are the same people whichever room they
+  // book. Call before starting the data fetching thread.
+  AvatarStore *avatarStore = new AvatarStore(
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+          "/avatars",
+      settings.value(AVATAR_DISK_CACHE_SIZE_SETTING).toLongLong() * 1024,
+      m_networkManager);
+  avatarStore->moveToThread(m_dataFetchingThread);
+  connect(m_dataFetchingThread, &QThread::started, avatarStore,
+          &AvatarStore::startCaching);
+  connect(m_dataFetchingThread, &QThread::finished, avatarStore,
+          &QObject::deleteLater);
+  for (BookingScreen *bookingScreen : std::as_const(m_bookingScreens)) {
+    bookingScreen->connectAvatarStore(avatarStore);
+  }
+}
 
-  ClickableIcon *clickableIcon = new ClickableIcon();
-  bottomSectionHorizontalLayout->addWidget(clickableIcon);
+void BookingDisplay::createOccupancyHistory() {
+  // Replayed and benchmarked bookings aren't this room's real occupancy.
+  if (!m_replayFilePath.isEmpty() || m_benchmarkTransitionCount > 0) {
+    return;
+  }
 
-  connect(clickableIcon, &ClickableIcon::clicked, this,
-          &BookingDisplay::openSettingsWindow);
+  QSettings settings;
+  m_occupancyHistory = new OccupancyHistory(
+      settings.value(OCCUPANCY_HISTORY_PATH_SETTING).toString());
+  m_occupancyHistory->moveToThread(m_dataFetchingThread);
+  connect(m_dataFetchingThread, &QThread::started, m_occupancyHistory,
+          &OccupancyHistory::startPersisting);
+  connect(m_dataFetchingThread, &QThread::finished, m_occupancyHistory,
+          &QObject::deleteLater);
 }
 
-void BookingDisplay::connectSignals() {
-  // Updating the current booking after a slight delay so the upcoming bookings
-  // are animated first. This looks cooler I think.
-  connect(m_dataFetchingHandler, &DataFetchingHandler::currentBookingChanged,
-          this, [this](CurrentBookingData newCurrentBooking) {
-            QTimer::singleShot(1600, this, [this, newCurrentBooking]() {
-              updateCurrentBooking(newCurrentBooking);
-            });
-          });
+void BookingDisplay::startMetricsServer() {
+  QSettings settings;
+  int metricsPort = settings.value(METRICS_PORT_SETTING).toInt();
+  if (metricsPort <= 0) {
+    return;
+  }
 
-  connect(m_dataFetchingHandler, &DataFetchingHandler::currentBookingChanged,
-          m_upcomingBookings, &UpcomingBookings::updateCurrentBooking);
-  connect(m_dataFetchingHandler, &DataFetchingHandler::upcomingBookingsChanged,
-          m_upcomingBookings, &UpcomingBookings::updateUpcomingBookings);
+  // Runs on the data fetching thread, so scraping never competes with the
+  // animations for the GUI event loop. Call before starting that thread.
+  MetricsServer *metricsServer =
+      new MetricsServer(m_displayMetrics, m_occupancyHistory, metricsPort);
+  metricsServer->moveToThread(m_dataFetchingThread);
+  connect(m_dataFetchingThread, &QThread::started, metricsServer,
+          &MetricsServer::startListening);
+  connect(m_dataFetchingThread, &QThread::finished, metricsServer,
+          &QObject::deleteLater);
 }
 
-void BookingDisplay::updateCurrentBooking(
-    CurrentBookingData newCurrentBooking) {
-  if (newCurrentBooking.state == CurrentBookingState::ERROR) {
-    m_bookingWidget->changeStatusColor(QColor(0, 0, 0));
-  } else if (newCurrentBooking.state == CurrentBookingState::UNBOOKED) {
-    m_bookingWidget->changeStatusColor(m_unbookedColor);
-  } else if (newCurrentBooking.state == CurrentBookingState::BOOKED) {
-    m_bookingWidget->changeStatusColor(m_bookedColor);
+void BookingDisplay::stopDataFetchingThread() {
+  if (!m_dataFetchingThread->isRunning()) {
+    return;
+  }
+  for (DataFetchingHandler *dataFetchingHandler :
+       std::as_const(m_dataFetchingHandlers)) {
+    QMetaObject::invokeMethod(dataFetchingHandler,
+                              &DataFetchingHandler::stopDataFetching,
+                              Qt::BlockingQueuedConnection);
   }
+  m_dataFetchingThread->quit();
+  m_dataFetchingThread->wait();
+}
 
-  m_bookingName->changeBookingName(newCurrentBooking.name);
-  m_bookingStatus->changeBookingStatus(newCurrentBooking.status);
-  m_bookingInfo->changeBookingInfo(newCurrentBooking.info);
+void BookingDisplay::startTransitionBenchmark() {
+  // The benchmark takes the place of the data fetching thread, forwarding its
+  // synthetic bookings through the handler's own signals.
+  TransitionBenchmark *transitionBenchmark = new TransitionBenchmark(
+      m_benchmarkTransitionCount, m_displayMetrics, m_eventLoopMonitor, this);
+  for (DataFetchingHandler *dataFetchingHandler :
+       std::as_const(m_dataFetchingHandlers)) {
+    connect(transitionBenchmark, &TransitionBenchmark::displayStateChanged,
+            dataFetchingHandler, &DataFetchingHandler::displayStateChanged);
+  }
+  transitionBenchmark->start();
 }
 
 void BookingDisplay::openSettingsWindow() {
@@ -151,7 +626,27 @@ void BookingDisplay::openSettingsWindow() {
   settingsPopup.exec();
 }
 
+bool BookingDisplay::isBookingWidget(const QObject *object) const {
+  for (const BookingScreen *bookingScreen : m_bookingScreens) {
+    if (bookingScreen->bookingWidget() == object) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool BookingDisplay::notify(QObject *receiver, QEvent *event) {
+  // An update request on the top level widget repaints the whole (dirty)
+  // widget tree, so timing it gives us the cost of a frame.
+  if (event->type() == QEvent::UpdateRequest && m_displayMetrics &&
+      isBookingWidget(receiver)) {
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    bool result = QApplication::notify(receiver, event);
+    m_displayMetrics->recordFrameTime(frameTimer.nsecsElapsed() / 1e9);
+    return result;
+  }
+
   if (event->type() == QEvent::KeyPress) {
     QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
     if (keyEvent->key() == Qt::Key_Escape) {
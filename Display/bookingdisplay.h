@@ -2,38 +2,78 @@
 #define BOOKINGDISPLAY_H
 
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QThread>
+#include <QtNetwork/QNetworkAccessManager>
 
+#include "bookingscreen.h"
 #include "datafetchinghandler.h"
-#include "widgets/bookinginfo.h"
-#include "widgets/bookingname.h"
-#include "widgets/bookingstatus.h"
-#include "widgets/bookingwidget.h"
-#include "widgets/upcomingbookings.h"
+#include "diagnostics/displaymetrics.h"
+#include "diagnostics/eventloopmonitor.h"
+#include "diagnostics/logwriter.h"
+#include "epaper/epaperfrontend.h"
+#include "timing/clock.h"
+
+#ifdef ROOMBOOKER_QUICK_FRONTEND
+#include "quick/quickbookingfrontend.h"
+#endif
 
 class BookingDisplay : public QApplication {
 public:
   BookingDisplay(int &argc, char **argv);
+  ~BookingDisplay();
 
 protected:
   bool notify(QObject *receiver, QEvent *event) override;
 
 private:
-  BookingWidget *m_bookingWidget;
-  BookingName *m_bookingName;
-  BookingInfo *m_bookingInfo;
-  BookingStatus *m_bookingStatus;
-  DataFetchingHandler *m_dataFetchingHandler;
-  UpcomingBookings *m_upcomingBookings;
-  QColor m_unbookedColor;
-  QColor m_bookedColor;
+  // One per configured screen, with the handler for the same room at the same
+  // index. The first one is the primary room, which the diagnostics follow.
+  QList<ScreenConfiguration> m_screenConfigurations;
+  QList<DataFetchingHandler *> m_dataFetchingHandlers;
+  QList<BookingScreen *> m_bookingScreens;
+  QThread *m_dataFetchingThread;
+  QNetworkAccessManager *m_networkManager;
+  EventLoopMonitor *m_eventLoopMonitor;
+  DisplayMetrics *m_displayMetrics;
+  OccupancyHistory *m_occupancyHistory;
+  Clock *m_clock;
+  ClockOffsetEstimator *m_clockOffsetEstimator;
+  QThread *m_loggingThread;
+  LogWriter *m_logWriter;
+  QString m_frontendName;
+  int m_benchmarkTransitionCount;
+  QString m_replayFilePath;
+  double m_replaySpeed;
+  EpaperFrontend *m_epaperFrontend;
+#ifdef ROOMBOOKER_QUICK_FRONTEND
+  QuickBookingFrontend *m_quickFrontend = nullptr;
+  QElapsedTimer m_quickFrameTimer;
+#endif
 
   void addFontsToDatabase();
+  void warmGlyphCaches();
   void populateSettingsIfNeeded();
-  void configureStoredColors();
-  void configureWidgetLayout();
-  void connectSignals();
-  void updateCurrentBooking(CurrentBookingData newCurrentBooking);
+  void startLogging();
+  void parseCommandLineOptions();
+  void readScreenConfigurations();
+  void createClock();
+  void createDataFetchingHandlers();
+  void createWidgetFrontend();
+  void createQuickFrontend();
+  void createEpaperFrontend();
+  void startTransitionBenchmark();
+  void startDataFetchingThread();
+  void startPayloadReplay();
+  void createOccupancyHistory();
+  void startMetricsServer();
+  void startRelayServer();
+  void startScheduleCaches();
+  void startAvatarStore();
+  void stopDataFetchingThread();
   void openSettingsWindow();
+  bool isBookingWidget(const QObject *object) const;
 };
 
 #endif // BOOKINGDISPLAY_H
@@ -0,0 +1,233 @@
+#include "bookingscreen.h"
+#include "./widgets/clickableicon.h"
+#include "settingstrings.h"
+#include <QHBoxLayout>
+#include <QSettings>
+#include <QVBoxLayout>
+#include <QWidget>
+
+namespace {
+// How long before a booking boundary the next state's texts get rasterized.
+const qint64 PRERENDER_LEAD_TIME = 60 * 1000;
+// The current booking changes after the upcoming bookings have started to
+// animate when both change at once. This looks cooler I think.
+const int CURRENT_BOOKING_TRANSITION_DELAY = 1600;
+} // namespace
+
+BookingScreen::BookingScreen(const ScreenConfiguration &configuration,
+                             QScreen *screen, const Clock *clock,
+                             QObject *parent)
+    : QObject{parent}, m_clock(clock), m_bookerAvatar(nullptr),
+      m_bookNowPanel(nullptr),
+      m_unbookedColor(configuration.unbookedColor),
+      m_bookedColor(configuration.bookedColor), m_displayedSequenceNumber(0) {
+  m_bookingWidget = new BookingWidget(configuration, screen);
+  m_bookingName = new BookingName();
+  m_bookingInfo = new BookingInfo();
+  if (QSettings().value(AVATARS_ENABLED_SETTING).toBool()) {
+    m_bookerAvatar = new BookerAvatar();
+  }
+  m_bookingStatus = new BookingStatus();
+  m_upcomingBookings = new UpcomingBookings();
+  if (QSettings().value(BOOK_NOW_ENABLED_SETTING).toBool() &&
+      !QSettings().value(BOOK_NOW_TOKEN_SETTING).toString().isEmpty()) {
+    m_bookNowPanel = new BookNowPanel(m_clock);
+  }
+  m_weekView = new WeekView(configuration.backgroundColor, m_bookingWidget);
+  m_transitionTimeline = new TransitionTimeline(this);
+  m_transitionTimeline->setMaximumDuration(
+      QSettings().value(MAX_TRANSITION_DURATION_SETTING).toInt());
+
+  configureWidgetLayout();
+  connect(m_upcomingBookings, &UpcomingBookings::clicked, m_weekView,
+          &WeekView::open);
+  m_bookingWidget->show();
+
+  m_prerenderTimer = new QTimer(this);
+  m_prerenderTimer->setSingleShot(true);
+  connect(m_prerenderTimer, &QTimer::timeout, this,
+          [this]() { prerenderBooking(m_nextBooking); });
+
+  // The unbooked texts are what most transitions end up on, so those are
+  // prepared as soon as the labels have their final size.
+  QTimer::singleShot(0, this, [this]() {
+    CurrentBookingData unbookedBooking;
+    QSettings settings;
+    unbookedBooking.name =
+        settings.value(UNBOOKED_NAME_TEXT_SETTING).toString();
+    unbookedBooking.info =
+        settings.value(UNBOOKED_INFO_TEXT_SETTING).toString();
+    unbookedBooking.status =
+        settings.value(UNBOOKED_STATUS_TEXT_SETTING).toString();
+    prerenderBooking(unbookedBooking);
+  });
+}
+
+BookingWidget *BookingScreen::bookingWidget() const { return m_bookingWidget; }
+
+void BookingScreen::connectDataFetchingHandler(
+    DataFetchingHandler *dataFetchingHandler) {
+  connect(dataFetchingHandler, &DataFetchingHandler::displayStateChanged, this,
+          &BookingScreen::updateDisplayState);
+
+  if (m_bookNowPanel) {
+    connect(m_bookNowPanel, &BookNowPanel::bookingRequested,
+            dataFetchingHandler, &DataFetchingHandler::bookRoom);
+    connect(dataFetchingHandler, &DataFetchingHandler::bookingRequestIgnored,
+            m_bookNowPanel, &BookNowPanel::showRefusal);
+  }
+}
+
+void BookingScreen::connectScheduleCache(ScheduleCache *scheduleCache) {
+  connect(m_weekView, &WeekView::dayRequested, scheduleCache,
+          &ScheduleCache::requestDay);
+  connect(scheduleCache, &ScheduleCache::dayPageChanged, m_weekView,
+          &WeekView::showDayPage);
+}
+
+void BookingScreen::connectAvatarStore(AvatarStore *avatarStore) {
+  if (!m_bookerAvatar) {
+    return;
+  }
+  connect(m_bookerAvatar, &BookerAvatar::avatarRequested, avatarStore,
+          &AvatarStore::requestAvatar);
+  connect(avatarStore, &AvatarStore::avatarAvailable, m_bookerAvatar,
+          &BookerAvatar::showAvatar);
+}
+
+void BookingScreen::configureWidgetLayout() {
+  QVBoxLayout *bookingWidgetVerticalLayout = new QVBoxLayout();
+
+  bookingWidgetVerticalLayout->setAlignment(Qt::AlignTop);
+  bookingWidgetVerticalLayout->setContentsMargins(15, 0, 0, 0);
+  m_bookingWidget->setLayout(bookingWidgetVerticalLayout);
+
+  QWidget *topSectionHorizontalDividerWidget = new QWidget();
+  QHBoxLayout *topSectionHorizontalDividerLayout =
+      new QHBoxLayout(topSectionHorizontalDividerWidget);
+  topSectionHorizontalDividerLayout->setContentsMargins(0, 0, 0, 0);
+  bookingWidgetVerticalLayout->addWidget(topSectionHorizontalDividerWidget, 4);
+
+  QWidget *topSectionLeftSideWidget = new QWidget();
+  QVBoxLayout *topSectionLeftSideLayout =
+      new QVBoxLayout(topSectionLeftSideWidget);
+  topSectionLeftSideLayout->addWidget(m_bookingName);
+  topSectionLeftSideLayout->addStretch();
+  if (m_bookerAvatar) {
+    QWidget *bookerWidget = new QWidget();
+    QHBoxLayout *bookerLayout = new QHBoxLayout(bookerWidget);
+    bookerLayout->setContentsMargins(0, 0, 0, 0);
+    bookerLayout->addWidget(m_bookerAvatar, 0, Qt::AlignVCenter);
+    bookerLayout->addWidget(m_bookingInfo, 1);
+    topSectionLeftSideLayout->addWidget(bookerWidget);
+  } else {
+    topSectionLeftSideLayout->addWidget(m_bookingInfo);
+  }
+  topSectionHorizontalDividerLayout->addWidget(topSectionLeftSideWidget, 3);
+
+  topSectionHorizontalDividerLayout->addWidget(m_upcomingBookings, 1);
+
+  QWidget *bottomSectionWidget = new QWidget();
+  QHBoxLayout *bottomSectionHorizontalLayout =
+      new QHBoxLayout(bottomSectionWidget);
+  bottomSectionHorizontalLayout->addWidget(m_bookingStatus);
+  bookingWidgetVerticalLayout->addWidget(bottomSectionWidget, 1);
+  bottomSectionHorizontalLayout->addStretch();
+  bottomSectionHorizontalLayout->setContentsMargins(9, 0, 20, 0);
+  if (m_bookNowPanel) {
+    bottomSectionHorizontalLayout->addWidget(m_bookNowPanel);
+  }
+
+  ClickableIcon *clickableIcon = new ClickableIcon();
+  bottomSectionHorizontalLayout->addWidget(clickableIcon);
+
+  connect(clickableIcon, &ClickableIcon::clicked, this,
+          &BookingScreen::settingsWindowRequested);
+}
+
+void BookingScreen::updateDisplayState(const DisplayState &displayState) {
+  if (displayState.sequenceNumber() <= m_displayedSequenceNumber) {
+    return;
+  }
+  m_displayedSequenceNumber = displayState.sequenceNumber();
+  schedulePrerendering(displayState.nextBooking());
+  m_bookingWidget->setStale(displayState.isStale());
+
+  bool upcomingBookingsChanged = displayState.upcomingBookingsChanged();
+  bool currentBookingChanged = displayState.currentBookingChanged();
+  if (!upcomingBookingsChanged && !currentBookingChanged) {
+    return;
+  }
+
+  // A state arriving mid-transition first settles the previous one, so the
+  // widgets never end up between two states.
+  m_transitionTimeline->fastForward();
+
+  if (upcomingBookingsChanged) {
+    m_upcomingBookings->changeUpcomingBookings(displayState,
+                                               m_transitionTimeline, 0);
+  }
+  int currentBookingStartTime =
+      upcomingBookingsChanged ? CURRENT_BOOKING_TRANSITION_DELAY : 0;
+  if (currentBookingChanged) {
+    updateCurrentBooking(displayState.currentBooking(),
+                         currentBookingStartTime);
+  }
+  if (m_bookNowPanel) {
+    m_transitionTimeline->addAction(
+        currentBookingStartTime, [this, displayState]() {
+          m_bookNowPanel->updateAvailability(displayState);
+        });
+  }
+  m_transitionTimeline->start();
+}
+
+void BookingScreen::updateCurrentBooking(
+    const CurrentBookingData &newCurrentBooking, int startTime) {
+  QColor statusColor;
+  if (newCurrentBooking.state == CurrentBookingState::ERROR) {
+    statusColor = QColor(0, 0, 0);
+  } else if (newCurrentBooking.state == CurrentBookingState::UNBOOKED) {
+    statusColor = m_unbookedColor;
+  } else if (newCurrentBooking.state == CurrentBookingState::BOOKED) {
+    statusColor = m_bookedColor;
+  }
+  m_bookingWidget->changeStatus(newCurrentBooking.state, statusColor,
+                                m_transitionTimeline, startTime);
+
+  m_bookingName->changeBookingName(newCurrentBooking.name,
+                                   m_transitionTimeline, startTime);
+  m_bookingStatus->changeBookingStatus(newCurrentBooking.status,
+                                       m_transitionTimeline, startTime);
+  m_bookingInfo->changeBookingInfo(newCurrentBooking.info,
+                                   m_transitionTimeline, startTime);
+  if (m_bookerAvatar) {
+    m_bookerAvatar->changeAvatar(newCurrentBooking.userId,
+                                 m_transitionTimeline, startTime);
+  }
+}
+
+void BookingScreen::schedulePrerendering(
+    const CurrentBookingData &nextBooking) {
+  if (nextBooking.startTime <= 0) {
+    m_prerenderTimer->stop();
+    return;
+  }
+
+  // Close enough to the boundary that the label sizes won't change anymore,
+  // but far enough ahead that the work never overlaps the transition itself.
+  m_nextBooking = nextBooking;
+  qint64 timeUntilPrerender =
+      (nextBooking.startTime - m_clock->currentSecsSinceEpoch()) * 1000 -
+      PRERENDER_LEAD_TIME;
+  m_prerenderTimer->start(m_clock->toWallClockInterval(timeUntilPrerender));
+}
+
+void BookingScreen::prerenderBooking(const CurrentBookingData &booking) {
+  m_bookingName->prerenderBookingName(booking.name);
+  m_bookingInfo->prerenderBookingInfo(booking.info);
+  m_bookingStatus->prerenderBookingStatus(booking.status);
+  if (m_bookerAvatar) {
+    m_bookerAvatar->prepareAvatar(booking.userId);
+  }
+}
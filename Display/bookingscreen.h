@@ -0,0 +1,63 @@
+#ifndef BOOKINGSCREEN_H
+#define BOOKINGSCREEN_H
+
+#include <QObject>
+#include <QScreen>
+#include <QTimer>
+
+#include "animations/transitiontimeline.h"
+#include "datafetchinghandler.h"
+#include "network/avatarstore.h"
+#include "network/schedulecache.h"
+#include "timing/clock.h"
+#include "widgets/bookeravatar.h"
+#include "widgets/bookinginfo.h"
+#include "widgets/booknowpanel.h"
+#include "widgets/bookingname.h"
+#include "widgets/bookingstatus.h"
+#include "widgets/bookingwidget.h"
+#include "widgets/upcomingbookings.h"
+#include "widgets/weekview.h"
+
+// The widget frontend of one room on one physical screen. A process drives
+// one of these per configured screen, all fed from the same data fetching
+// thread and sharing the fonts and asset caches of the application.
+class BookingScreen : public QObject {
+  Q_OBJECT
+public:
+  BookingScreen(const ScreenConfiguration &configuration, QScreen *screen,
+                const Clock *clock, QObject *parent = nullptr);
+  BookingWidget *bookingWidget() const;
+  void connectDataFetchingHandler(DataFetchingHandler *dataFetchingHandler);
+  void connectScheduleCache(ScheduleCache *scheduleCache);
+  void connectAvatarStore(AvatarStore *avatarStore);
+  void updateDisplayState(const DisplayState &displayState);
+
+signals:
+  void settingsWindowRequested();
+
+private:
+  const Clock *m_clock;
+  BookingWidget *m_bookingWidget;
+  BookingName *m_bookingName;
+  BookingInfo *m_bookingInfo;
+  BookerAvatar *m_bookerAvatar;
+  BookingStatus *m_bookingStatus;
+  UpcomingBookings *m_upcomingBookings;
+  BookNowPanel *m_bookNowPanel;
+  WeekView *m_weekView;
+  TransitionTimeline *m_transitionTimeline;
+  QColor m_unbookedColor;
+  QColor m_bookedColor;
+  quint64 m_displayedSequenceNumber;
+  QTimer *m_prerenderTimer;
+  CurrentBookingData m_nextBooking;
+
+  void configureWidgetLayout();
+  void updateCurrentBooking(const CurrentBookingData &newCurrentBooking,
+                            int startTime);
+  void schedulePrerendering(const CurrentBookingData &nextBooking);
+  void prerenderBooking(const CurrentBookingData &booking);
+};
+
+#endif // BOOKINGSCREEN_H
@@ -1,32 +1,121 @@
 #include "datafetchinghandler.h"
+#include "diagnostics/logging.h"
 #include "settingstrings.h"
-#include <QApplication>
-#include <QDebug>
+#include <QDateTime>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QRandomGenerator>
 #include <QSettings>
 #include <QTimeZone>
 #include <QTimer>
+#include <QUrlQuery>
 #include <QtNetwork/QNetworkReply>
-
-DataFetchingHandler::DataFetchingHandler(QObject *parent)
-    : QObject{parent}, m_networkManager(new QNetworkAccessManager()),
-      m_getRequest(new QNetworkRequest()) {
+#include <algorithm>
+
+namespace {
+const quint64 PROBE_INTERVAL_POLLS = 10;
+const QString PENDING_BOOKING_ID = "pending";
+const int UPCOMING_BOOKING_COUNT = 3;
+const int BOOK_NOW_REQUEST_TIMEOUT = 10 * 1000;
+// Without a timeout a poll into a network that silently drops packets never
+// finishes, not even with an error.
+const int POLL_REQUEST_TIMEOUT = 10 * 1000;
+// Polls that were already underway when the backend confirmed the booking
+// don't know about it yet, this covers those plus a few slow ones.
+const qint64 OPTIMISTIC_BOOKING_CONFIRMATION_TIMEOUT = 10 * 1000;
+// Timers can fire a little early, this makes sure the booking has started by
+// the time the schedule is looked at again.
+const qint64 BOOKING_BOUNDARY_MARGIN = 20;
+const QByteArray SERVER_TIME_HEADER = "X-Server-Time";
+// Tomorrow is prefetched at a random moment in this window before midnight,
+// spreading the requests of all displays over most of an hour.
+const qint64 DAY_PREFETCH_WINDOW_START = 60 * 60 * 1000;
+const qint64 DAY_PREFETCH_WINDOW_END = 5 * 60 * 1000;
+} // namespace
+
+DataFetchingHandler::DataFetchingHandler(
+    int roomId, DisplayMetrics *displayMetrics, const Clock *clock,
+    ClockOffsetEstimator *clockOffsetEstimator,
+    OccupancyHistory *occupancyHistory, QNetworkAccessManager *networkManager,
+    QObject *parent)
+    : QObject{parent}, m_networkManager(networkManager),
+      m_getRequestTimer(nullptr), m_hedgeTimer(nullptr),
+      m_boundaryTimer(nullptr), m_connectionTimeoutTimer(nullptr),
+      m_displayMetrics(displayMetrics),
+      m_clock(clock), m_clockOffsetEstimator(clockOffsetEstimator),
+      m_occupancyHistory(occupancyHistory),
+      m_payloadLogWriter(nullptr), m_endpointSelector(nullptr),
+      m_connectionMonitor(nullptr),
+      m_pollNumber(0), m_lastAnsweredPollNumber(0), m_hedgedPollNumber(0),
+      m_dayPrefetchTimer(nullptr), m_dayRolloverTimer(nullptr),
+      m_optimisticBookingDeadline(0), m_roomId(roomId) {
   retrieveSettings();
-  QTimer *m_getRequestTimer = new QTimer(this);
+}
+
+DataFetchingHandler::~DataFetchingHandler() {
+  delete m_payloadLogWriter;
+  delete m_endpointSelector;
+  delete m_connectionMonitor;
+}
+
+void DataFetchingHandler::startDataFetching() {
+  // Created here instead of in the constructor so they end up living on the
+  // worker thread this handler was moved to.
+  m_getRequestTimer = new QTimer(this);
   connect(m_getRequestTimer, &QTimer::timeout, this,
           &DataFetchingHandler::getBookingData);
-  connect(m_networkManager, &QNetworkAccessManager::finished, this,
-          &DataFetchingHandler::onBookingDataRequestFinished);
-  connect(qApp, &QApplication::aboutToQuit, this,
-          &DataFetchingHandler::stopDataFetching);
-  m_getRequestTimer->start(1000);
+  m_requestClock.start();
+  if (!m_recordPayloadsPath.isEmpty()) {
+    m_payloadLogWriter = new PayloadLogWriter(m_recordPayloadsPath);
+  }
+  // Hedging is about network latency, so this one runs on wall clock time.
+  m_hedgeTimer = new QTimer(this);
+  m_hedgeTimer->setSingleShot(true);
+  connect(m_hedgeTimer, &QTimer::timeout, this,
+          &DataFetchingHandler::sendHedgedRequest);
+  // Bookings start and end exactly on time instead of with the next poll.
+  m_boundaryTimer = new QTimer(this);
+  m_boundaryTimer->setSingleShot(true);
+  m_boundaryTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_boundaryTimer, &QTimer::timeout, this,
+          &DataFetchingHandler::onBookingBoundary);
+  // Runs from the last successful poll, failed polls alone can't be relied on
+  // to notice an outage.
+  m_connectionTimeoutTimer = new QTimer(this);
+  m_connectionTimeoutTimer->setSingleShot(true);
+  connect(m_connectionTimeoutTimer, &QTimer::timeout, this,
+          &DataFetchingHandler::onConnectionTimeout);
+  m_dayPrefetchTimer = new QTimer(this);
+  m_dayPrefetchTimer->setSingleShot(true);
+  connect(m_dayPrefetchTimer, &QTimer::timeout, this,
+          &DataFetchingHandler::prefetchNextDay);
+  m_dayRolloverTimer = new QTimer(this);
+  m_dayRolloverTimer->setSingleShot(true);
+  m_dayRolloverTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_dayRolloverTimer, &QTimer::timeout, this,
+          &DataFetchingHandler::onDayRollover);
+  scheduleDayPrefetch();
+  scheduleDayRollover();
+  // Replays and tests feed the replies in themselves, they only need the
+  // timers that act on the schedule.
+  if (!m_networkManager) {
+    return;
+  }
+  m_getRequestTimer->start(
+      qMax(1, m_clock->toWallClockInterval(m_pollInterval)));
+  getBookingData();
 }
 
 void DataFetchingHandler::retrieveSettings() {
   QSettings settings;
-  m_apiAddress = settings.value(API_ADDRESS_SETTING).toString();
-  m_roomId = settings.value(ROOM_ID_SETTING).toInt();
+  m_endpointSelector = new EndpointSelector(
+      settings.value(API_ADDRESS_SETTING).toString().split(','));
+  m_connectionMonitor = new ConnectionMonitor(
+      settings.value(API_ERROR_AFTER_FAILURES_SETTING).toInt(),
+      settings.value(API_ERROR_AFTER_TIME_SETTING).toLongLong());
+  m_hedgeDelay = settings.value(API_HEDGE_DELAY_SETTING).toInt();
+  m_pollInterval = qMax(1, settings.value(API_POLL_INTERVAL_SETTING).toInt());
   m_timeZoneText = getSystemTimezoneId();
   m_unbookedNameText = settings.value(UNBOOKED_NAME_TEXT_SETTING).toString();
   m_unbookedInfoText = settings.value(UNBOOKED_INFO_TEXT_SETTING).toString();
@@ -34,63 +123,679 @@ void DataFetchingHandler::retrieveSettings() {
       settings.value(UNBOOKED_STATUS_TEXT_SETTING).toString();
   m_bookedUsernamePrefixText =
       settings.value(BOOKED_USERNAME_PREFIX_TEXT_SETTING).toString();
-
-  m_constructedURL = m_apiAddress + "/rooms/" + QString::number(m_roomId) +
-                     "/" + m_timeZoneText;
+  m_bookNowNameText = settings.value(BOOK_NOW_NAME_TEXT_SETTING).toString();
+  m_bookNowUserText = settings.value(BOOK_NOW_USER_TEXT_SETTING).toString();
+  m_bookNowToken = settings.value(BOOK_NOW_TOKEN_SETTING).toString();
+  m_recordPayloadsPath =
+      settings.value(RECORD_PAYLOADS_PATH_SETTING).toString();
 }
 
 void DataFetchingHandler::getBookingData() {
-  m_getRequest->setUrl(QUrl(m_constructedURL));
-  m_networkManager->get(*m_getRequest);
+  if (!m_networkManager) {
+    return;
+  }
+  m_pollNumber++;
+  sendBookingDataRequest(m_endpointSelector->selectedIndex(), m_pollNumber);
+  if (m_hedgeDelay > 0 && m_endpointSelector->alternativeIndex() >= 0) {
+    m_hedgeTimer->start(m_hedgeDelay);
+  }
+
+  // Endpoints that aren't polled still need fresh numbers, both to notice the
+  // primary is back and to know where to go when the selected one fails.
+  if (m_pollNumber % PROBE_INTERVAL_POLLS == 0) {
+    for (int index = 0; index < m_endpointSelector->endpointCount(); index++) {
+      if (index != m_endpointSelector->selectedIndex()) {
+        sendBookingDataRequest(index, 0);
+      }
+    }
+  }
+}
+
+void DataFetchingHandler::sendBookingDataRequest(int endpointIndex,
+                                                 quint64 pollNumber) {
+  if (m_scheduleDate != getCurrentDate()) {
+    rollOverScheduleDay();
+  }
+
+  QUrl url(m_endpointSelector->address(endpointIndex) + "/rooms/" +
+           QString::number(m_roomId) + "/" + m_timeZoneText);
+  if (!m_scheduleVersion.isEmpty()) {
+    QUrlQuery query;
+    query.addQueryItem("since", m_scheduleVersion);
+    url.setQuery(query);
+  }
+  QNetworkRequest request(url);
+  request.setTransferTimeout(POLL_REQUEST_TIMEOUT);
+  QNetworkReply *reply = m_networkManager->get(request);
+  watchReply(reply);
+  reply->setProperty("requestSentAt", m_requestClock.elapsed());
+  reply->setProperty("requestSentAtSystemTime",
+                     QDateTime::currentMSecsSinceEpoch());
+  reply->setProperty("endpointIndex", endpointIndex);
+  reply->setProperty("pollNumber", pollNumber);
+  if (pollNumber > 0) {
+    m_outstandingReplies.append(reply);
+  }
+}
+
+void DataFetchingHandler::sendHedgedRequest() {
+  int alternativeIndex = m_endpointSelector->alternativeIndex();
+  if (m_lastAnsweredPollNumber >= m_pollNumber ||
+      m_hedgedPollNumber == m_pollNumber || alternativeIndex < 0) {
+    return;
+  }
+
+  m_hedgedPollNumber = m_pollNumber;
+  if (m_displayMetrics) {
+    m_displayMetrics->recordHedgedRequest();
+  }
+  sendBookingDataRequest(alternativeIndex, m_pollNumber);
+}
+
+bool DataFetchingHandler::hasOutstandingReply(quint64 pollNumber) {
+  for (const QPointer<QNetworkReply> &reply : m_outstandingReplies) {
+    if (reply && reply->property("pollNumber").toULongLong() == pollNumber) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DataFetchingHandler::cancelOutstandingReplies(quint64 upToPollNumber) {
+  // Aborting finishes the reply right away, which modifies the list.
+  const QList<QPointer<QNetworkReply>> outstandingReplies =
+      m_outstandingReplies;
+  for (const QPointer<QNetworkReply> &reply : outstandingReplies) {
+    if (reply &&
+        reply->property("pollNumber").toULongLong() <= upToPollNumber) {
+      reply->setProperty("cancelled", true);
+      reply->abort();
+    }
+  }
+}
+
+double DataFetchingHandler::getRoundTripTime(QNetworkReply *reply) {
+  qint64 requestSentAt = reply->property("requestSentAt").toLongLong();
+  return (m_requestClock.elapsed() - requestSentAt) / 1000.0;
+}
+
+void DataFetchingHandler::recordServerTime(QNetworkReply *reply) {
+  // Standbys have clocks of their own, which the estimator would take for the
+  // primary's clock jumping back and forth with every probe and hedge.
+  if (!m_clockOffsetEstimator ||
+      !reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid() ||
+      reply->property("endpointIndex").toInt() !=
+          m_endpointSelector->selectedIndex()) {
+    return;
+  }
+
+  // The backend's own timestamp is exact to the millisecond, the Date header
+  // every HTTP server sends only to the second.
+  qint64 serverTime = 0;
+  qint64 serverTimeResolution = 0;
+  bool hasServerTime = false;
+  if (reply->hasRawHeader(SERVER_TIME_HEADER)) {
+    serverTime =
+        reply->rawHeader(SERVER_TIME_HEADER).toLongLong(&hasServerTime);
+  } else if (reply->hasRawHeader("Date")) {
+    QDateTime date = QDateTime::fromString(
+        QString::fromLatin1(reply->rawHeader("Date")), Qt::RFC2822Date);
+    hasServerTime = date.isValid();
+    serverTime = date.toMSecsSinceEpoch();
+    serverTimeResolution = 1000;
+  }
+  if (!hasServerTime) {
+    return;
+  }
+
+  m_clockOffsetEstimator->addSample(
+      reply->property("requestSentAtSystemTime").toLongLong(),
+      QDateTime::currentMSecsSinceEpoch(), serverTime, serverTimeResolution);
+  if (m_displayMetrics) {
+    m_displayMetrics->setClockOffset(
+        m_clockOffsetEstimator->offset() / 1000.0,
+        m_clockOffsetEstimator->uncertainty() / 1000.0);
+  }
+}
+
+void DataFetchingHandler::watchReply(QNetworkReply *reply) {
+  // The network manager's own finished signal would also hand us the replies
+  // of the other rooms' handlers sharing it.
+  connect(reply, &QNetworkReply::finished, this,
+          [this, reply]() { onBookingDataRequestFinished(reply); });
 }
 
 void DataFetchingHandler::onBookingDataRequestFinished(
     QNetworkReply *getRequestReply) {
+  if (getRequestReply->property("isBookNowRequest").toBool()) {
+    onBookNowRequestFinished(getRequestReply);
+    return;
+  }
+  if (getRequestReply->property("isDayPrefetchRequest").toBool()) {
+    onDayPrefetchRequestFinished(getRequestReply);
+    return;
+  }
 
-  CurrentBookingData newCurrentBookingData;
+  getRequestReply->deleteLater();
+  m_outstandingReplies.removeAll(getRequestReply);
+  if (getRequestReply->property("cancelled").toBool()) {
+    return;
+  }
+
+  int endpointIndex = getRequestReply->property("endpointIndex").toInt();
+  double roundTripTime = getRoundTripTime(getRequestReply);
+  recordServerTime(getRequestReply);
+  if (getRequestReply->error()) {
+    m_endpointSelector->recordError(endpointIndex);
+  } else {
+    m_endpointSelector->recordSuccess(endpointIndex, roundTripTime);
+  }
+  if (m_displayMetrics) {
+    m_displayMetrics->setEndpointHealth(m_endpointSelector->health());
+  }
+
+  // Probes only feed the health scores. Answers to polls that were already
+  // answered (by a hedged request or a newer poll) are dropped.
+  quint64 pollNumber = getRequestReply->property("pollNumber").toULongLong();
+  if (pollNumber == 0 || pollNumber <= m_lastAnsweredPollNumber) {
+    return;
+  }
 
+  // An error isn't shown while another endpoint may still answer this poll,
+  // and a failed current poll is retried on another endpoint right away.
   if (getRequestReply->error()) {
-    newCurrentBookingData = getErrorCurrentBookingData();
+    if (pollNumber == m_pollNumber && m_hedgedPollNumber != m_pollNumber &&
+        m_endpointSelector->alternativeIndex() >= 0) {
+      sendHedgedRequest();
+      return;
+    }
+    if (hasOutstandingReply(pollNumber)) {
+      return;
+    }
+  }
+
+  m_lastAnsweredPollNumber = pollNumber;
+  cancelOutstandingReplies(pollNumber);
+  if (pollNumber == m_pollNumber) {
+    m_hedgeTimer->stop();
+  }
+
+  RecordedPayload payload;
+  payload.receivedAt = m_clock->currentMSecsSinceEpoch();
+  payload.networkError = getRequestReply->error();
+  payload.httpStatusCode =
+      getRequestReply->attribute(QNetworkRequest::HttpStatusCodeAttribute)
+          .toInt();
+  payload.body = getRequestReply->readAll();
+
+  if (getRequestReply->error()) {
+    qCWarning(lcNetwork) << "Poll of room" << m_roomId
+                         << "failed:" << getRequestReply->errorString();
+    if (m_displayMetrics) {
+      m_displayMetrics->recordPollError(getRequestReply->error(),
+                                        roundTripTime);
+    }
+  } else {
+    qCDebug(lcNetwork) << "Poll of room" << m_roomId << "answered in"
+                       << roundTripTime << "s";
+    if (m_displayMetrics) {
+      m_displayMetrics->recordPollSuccess(roundTripTime);
+    }
+  }
 
-    if (getRequestReply->error() == QNetworkReply::ContentNotFoundError) {
+  if (m_payloadLogWriter) {
+    m_payloadLogWriter->append(payload);
+  }
+  processPayload(payload);
+}
+
+void DataFetchingHandler::processPayload(const RecordedPayload &payload) {
+
+  if (payload.networkError != QNetworkReply::NoError) {
+    if (payload.networkError == QNetworkReply::ContentNotFoundError) {
+      m_connectionMonitor->recordPermanentFailure();
+    } else {
+      m_connectionMonitor->recordFailure(payload.receivedAt);
+    }
+    if (m_displayMetrics) {
+      m_displayMetrics->setConnectionState(m_connectionMonitor->state());
+    }
+    // A blip only marks what is shown as stale, instead of fading out the
+    // whole screen to the error and back again with the next poll.
+    if (m_connectionMonitor->state() == ConnectionState::DEGRADED) {
+      processNewBookingData(m_displayState.currentBooking(),
+                            m_displayState.upcomingBookings(),
+                            m_displayState.nextBooking());
+      return;
+    }
+
+    CurrentBookingData newCurrentBookingData = getErrorCurrentBookingData();
+
+    if (payload.networkError == QNetworkReply::ContentNotFoundError) {
       newCurrentBookingData.name = QString("ERROR: Room ID not found");
       newCurrentBookingData.info = QString("Please provide a valid room ID.");
     }
 
-    if (newCurrentBookingData != m_storedCurrentBookingData) {
-      m_storedCurrentBookingData = newCurrentBookingData;
+    processPolledBookingData(newCurrentBookingData,
+                             m_displayState.upcomingBookings());
+    return;
+  }
 
-      emit currentBookingChanged(m_storedCurrentBookingData);
+  bool suppressedFlap = m_connectionMonitor->recordSuccess(payload.receivedAt);
+  if (m_connectionTimeoutTimer) {
+    m_connectionTimeoutTimer->start(m_clock->toWallClockInterval(
+        m_connectionMonitor->maxTimeWithoutSuccess()));
+  }
+  if (m_displayMetrics) {
+    if (suppressedFlap) {
+      m_displayMetrics->recordSuppressedConnectionFlap();
     }
+    m_displayMetrics->setConnectionState(m_connectionMonitor->state());
+  }
+  QString replyString = QString::fromUtf8(payload.body);
+  processBookingDataObject(applyScheduleUpdate(
+      getParsedBookingDataObjectFromReplyString(replyString)));
+}
+
+void DataFetchingHandler::onConnectionTimeout() {
+  if (!m_connectionMonitor->recordSilence(m_clock->currentMSecsSinceEpoch())) {
     return;
   }
 
-  QString replyString = getRequestReply->readAll();
-  QJsonObject parsedBookingDataObject =
-      getParsedBookingDataObjectFromReplyString(replyString);
+  qCWarning(lcNetwork) << "No successful poll of room" << m_roomId << "in"
+                       << m_connectionMonitor->maxTimeWithoutSuccess()
+                       << "ms, showing the error.";
+  if (m_displayMetrics) {
+    m_displayMetrics->setConnectionState(m_connectionMonitor->state());
+  }
+  processPolledBookingData(getErrorCurrentBookingData(),
+                           m_displayState.upcomingBookings());
+}
 
-  newCurrentBookingData = getCurrentBookingData(parsedBookingDataObject);
+void DataFetchingHandler::processBookingDataObject(
+    const QJsonObject &bookingDataObject) {
+  CurrentBookingData currentBooking = getCurrentBookingData(bookingDataObject);
+  processPolledBookingData(
+      currentBooking, getUpcomingBookings(bookingDataObject),
+      getNextBookingData(bookingDataObject, currentBooking));
+}
 
-  if (newCurrentBookingData != m_storedCurrentBookingData) {
-    m_storedCurrentBookingData = newCurrentBookingData;
-    emit currentBookingChanged(m_storedCurrentBookingData);
+void DataFetchingHandler::scheduleBoundaryUpdate(
+    const CurrentBookingData &nextBooking) {
+  if (!m_boundaryTimer) {
+    return;
+  }
+  if (nextBooking.startTime <= 0) {
+    m_boundaryTimer->stop();
+    return;
   }
 
-  QList<UpcomingBookingData> upcomingBookings =
-      getUpcomingBookings(parsedBookingDataObject);
-  processUpcomingBookings(upcomingBookings);
+  qint64 timeUntilBoundary = nextBooking.startTime * 1000 -
+                             m_clock->currentMSecsSinceEpoch() +
+                             BOOKING_BOUNDARY_MARGIN;
+  m_boundaryTimer->start(
+      m_clock->toWallClockInterval(qMax<qint64>(0, timeUntilBoundary)));
+}
 
-  getRequestReply->deleteLater();
+void DataFetchingHandler::onBookingBoundary() {
+  // With a synced schedule the display knows what comes next by itself,
+  // otherwise the backend is asked right away instead of at the next poll.
+  if (!m_scheduleVersion.isEmpty()) {
+    processBookingDataObject(getBookingDataObjectFromSchedule());
+  } else {
+    getBookingData();
+  }
+}
+
+void DataFetchingHandler::bookRoom(int durationMinutes) {
+  // Replays have nothing to post to.
+  if (!m_networkManager ||
+      m_displayState.currentBooking().state != CurrentBookingState::UNBOOKED ||
+      !m_optimisticBooking.id.isEmpty()) {
+    emit bookingRequestIgnored();
+    return;
+  }
+
+  CurrentBookingData booking;
+  booking.state = CurrentBookingState::BOOKED;
+  booking.id = PENDING_BOOKING_ID;
+  booking.name = m_bookNowNameText;
+  booking.info = m_bookedUsernamePrefixText + m_bookNowUserText;
+  booking.startTime = m_clock->currentSecsSinceEpoch();
+  booking.endTime = booking.startTime + durationMinutes * 60 - 1;
+  booking.status =
+      getTimeStringFromStartEndTime(booking.startTime, booking.endTime);
+
+  CurrentBookingData nextBooking = getNextBookingAfter(booking);
+  if (nextBooking.state == CurrentBookingState::BOOKED &&
+      nextBooking.startTime <= booking.endTime) {
+    qCWarning(lcNetwork) << "Not booking" << durationMinutes
+                         << "minutes, it would run into the next booking.";
+    emit bookingRequestIgnored();
+    return;
+  }
+
+  m_optimisticBooking = booking;
+  m_optimisticBookingDeadline =
+      m_requestClock.elapsed() + BOOK_NOW_REQUEST_TIMEOUT +
+      OPTIMISTIC_BOOKING_CONFIRMATION_TIMEOUT;
+  processNewBookingData(booking, m_displayState.upcomingBookings(),
+                        nextBooking);
+
+  QNetworkRequest request(
+      QUrl(m_endpointSelector->address(m_endpointSelector->selectedIndex()) +
+           "/rooms/" + QString::number(m_roomId) + "/book"));
+  request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+  request.setRawHeader("Authorization", "Bearer " + m_bookNowToken.toLatin1());
+  request.setTransferTimeout(BOOK_NOW_REQUEST_TIMEOUT);
+  QJsonObject requestBody;
+  requestBody["duration_minutes"] = durationMinutes;
+  requestBody["name"] = m_bookNowNameText;
+  requestBody["user"] = m_bookNowUserText;
+  QNetworkReply *reply = m_networkManager->post(
+      request, QJsonDocument(requestBody).toJson(QJsonDocument::Compact));
+  reply->setProperty("isBookNowRequest", true);
+  watchReply(reply);
+}
+
+void DataFetchingHandler::onBookNowRequestFinished(QNetworkReply *reply) {
+  reply->deleteLater();
+  if (m_optimisticBooking.id != PENDING_BOOKING_ID) {
+    return;
+  }
+
+  if (reply->error()) {
+    qCWarning(lcNetwork) << "Booking from the display failed:"
+                         << reply->errorString() << reply->readAll();
+    rollBackOptimisticBooking();
+    return;
+  }
+
+  QJsonObject replyObject = getParsedBookingDataObjectFromReplyString(
+      QString::fromUtf8(reply->readAll()));
+  CurrentBookingData confirmedBooking =
+      getBookedBookingData(replyObject.value("booking").toObject());
+  m_optimisticBooking = confirmedBooking;
+  m_optimisticBookingDeadline =
+      m_requestClock.elapsed() + OPTIMISTIC_BOOKING_CONFIRMATION_TIMEOUT;
+
+  const CurrentBookingData &shownBooking = m_displayState.currentBooking();
+  if (confirmedBooking.name == shownBooking.name &&
+      confirmedBooking.info == shownBooking.info &&
+      confirmedBooking.status == shownBooking.status) {
+    // Only the ID changed, which isn't worth a transition. It is swapped in
+    // silently so the poll that includes the booking compares equal.
+    m_displayState = DisplayState(
+        m_displayState.sequenceNumber(), confirmedBooking,
+        m_displayState.upcomingBookings(), false, false,
+        m_displayState.nextBooking(), m_displayState.isStale());
+    return;
+  }
+  processNewBookingData(confirmedBooking, m_displayState.upcomingBookings(),
+                        getNextBookingAfter(confirmedBooking));
+}
+
+void DataFetchingHandler::rollBackOptimisticBooking() {
+  m_optimisticBooking = CurrentBookingData();
+  processNewBookingData(m_polledCurrentBooking, m_polledUpcomingBookings,
+                        m_polledNextBooking);
+}
+
+void DataFetchingHandler::processPolledBookingData(
+    const CurrentBookingData &currentBooking,
+    const QList<UpcomingBookingData> &upcomingBookings,
+    const CurrentBookingData &nextBooking) {
+  m_polledCurrentBooking = currentBooking;
+  m_polledUpcomingBookings = upcomingBookings;
+  m_polledNextBooking = nextBooking;
+  scheduleBoundaryUpdate(nextBooking);
+  // Only what the backend said goes into the history, bookings made on this
+  // display are recorded once a poll includes them.
+  if (m_occupancyHistory) {
+    m_occupancyHistory->record(m_clock->currentSecsSinceEpoch(),
+                               currentBooking);
+  }
+
+  if (!m_optimisticBooking.id.isEmpty()) {
+    bool isIncludedInPoll = currentBooking.id == m_optimisticBooking.id;
+    if (!isIncludedInPoll &&
+        m_requestClock.elapsed() < m_optimisticBookingDeadline) {
+      processNewBookingData(m_optimisticBooking, upcomingBookings,
+                            getNextBookingAfter(m_optimisticBooking));
+      return;
+    }
+    if (!isIncludedInPoll) {
+      qCWarning(lcNetwork)
+          << "Booking from the display never showed up in a poll.";
+    }
+    m_optimisticBooking = CurrentBookingData();
+  }
+
+  processNewBookingData(currentBooking, upcomingBookings, nextBooking);
 }
 
 QJsonObject DataFetchingHandler::getParsedBookingDataObjectFromReplyString(
     QString replyString) {
+  QJsonParseError parseError;
   QJsonDocument parsedBookingDataDocument =
-      QJsonDocument::fromJson(replyString.toUtf8());
+      QJsonDocument::fromJson(replyString.toUtf8(), &parseError);
+  if (parseError.error != QJsonParseError::NoError) {
+    qCWarning(lcParse) << "Could not parse reply at offset" << parseError.offset
+                       << ":" << parseError.errorString();
+  } else if (!parsedBookingDataDocument.isObject()) {
+    qCWarning(lcParse) << "Reply is not a JSON object";
+  }
   QJsonObject parsedBookingDataObject = parsedBookingDataDocument.object();
   return parsedBookingDataObject;
 }
 
+QJsonObject
+DataFetchingHandler::applyScheduleUpdate(const QJsonObject &replyObject) {
+  // Backends (and relays in front of them) without versioning always send
+  // the bookings to show as they are.
+  if (!replyObject.contains("version")) {
+    m_scheduleVersion.clear();
+    return replyObject;
+  }
+
+  if (replyObject.contains("bookings")) {
+    m_scheduleBookings.clear();
+    m_prefetchedDate = QDate();
+    const QJsonArray bookings = replyObject["bookings"].toArray();
+    for (const QJsonValue &booking : bookings) {
+      m_scheduleBookings.insert(booking["id"].toString(), booking.toObject());
+    }
+    m_scheduleDate = getCurrentDate();
+  } else if (replyObject.contains("changes")) {
+    // Changes carry the whole booking, so applying them twice (an older poll
+    // asking since an older version) does no harm.
+    const QJsonArray changes = replyObject["changes"].toArray();
+    for (const QJsonValue &change : changes) {
+      if (change["removed"].toBool()) {
+        m_scheduleBookings.remove(change["id"].toString());
+      } else {
+        m_scheduleBookings.insert(change["id"].toString(),
+                                  change["booking"].toObject());
+      }
+    }
+  } else if (!replyObject["unchanged"].toBool()) {
+    return replyObject;
+  }
+
+  QString scheduleVersion = replyObject["version"].toString();
+  if (scheduleVersion != m_scheduleVersion) {
+    m_scheduleVersion = scheduleVersion;
+    emit scheduleVersionChanged(m_scheduleVersion);
+  }
+  return getBookingDataObjectFromSchedule();
+}
+
+QJsonObject DataFetchingHandler::getBookingDataObjectFromSchedule() {
+  // Picks the bookings to show the same way the backend does, so it has to
+  // stay in line with get_room_display_dict.
+  qint64 now = m_clock->currentSecsSinceEpoch();
+  qint64 dayEndTime =
+      QDateTime(getCurrentDate(), QTime(23, 59, 59), m_clock->timeZone())
+          .toSecsSinceEpoch();
+
+  QList<QJsonObject> bookings;
+  for (auto it = m_scheduleBookings.begin(); it != m_scheduleBookings.end();) {
+    if (it.value().value("end_time").toInteger() < now) {
+      it = m_scheduleBookings.erase(it);
+      continue;
+    }
+    bookings.append(it.value());
+    ++it;
+  }
+  std::sort(bookings.begin(), bookings.end(),
+            [](const QJsonObject &first, const QJsonObject &second) {
+              return first["start_time"].toInteger() <
+                     second["start_time"].toInteger();
+            });
+
+  QJsonObject noBooking{{"id", ""},
+                        {"name", ""},
+                        {"user", ""},
+                        {"start_time", 0},
+                        {"end_time", 0}};
+  QJsonObject currentBooking = noBooking;
+  QList<QJsonObject> upcomingBookings;
+  for (const QJsonObject &booking : std::as_const(bookings)) {
+    qint64 startTime = booking["start_time"].toInteger();
+    if (startTime <= now && booking["end_time"].toInteger() >= now) {
+      currentBooking = booking;
+    }
+    if (startTime >= now && startTime <= dayEndTime &&
+        upcomingBookings.size() < UPCOMING_BOOKING_COUNT) {
+      upcomingBookings.append(booking);
+    }
+  }
+  while (upcomingBookings.size() < UPCOMING_BOOKING_COUNT) {
+    upcomingBookings.append(noBooking);
+  }
+
+  QJsonObject bookingDataObject;
+  bookingDataObject["current_booking"] = currentBooking;
+  bookingDataObject["first_upcoming_booking"] = upcomingBookings[0];
+  bookingDataObject["second_upcoming_booking"] = upcomingBookings[1];
+  bookingDataObject["third_upcoming_booking"] = upcomingBookings[2];
+  return bookingDataObject;
+}
+
+QDate DataFetchingHandler::getCurrentDate() const {
+  return m_clock->toDateTime(m_clock->currentSecsSinceEpoch()).date();
+}
+
+qint64 DataFetchingHandler::getNextMidnight() const {
+  return QDateTime(getCurrentDate().addDays(1), QTime(0, 0),
+                   m_clock->timeZone())
+      .toMSecsSinceEpoch();
+}
+
+void DataFetchingHandler::scheduleDayPrefetch() {
+  qint64 now = m_clock->currentMSecsSinceEpoch();
+  qint64 windowStart =
+      qMax(now, getNextMidnight() - DAY_PREFETCH_WINDOW_START);
+  qint64 windowEnd = getNextMidnight() - DAY_PREFETCH_WINDOW_END;
+  if (windowStart >= windowEnd) {
+    // Too late for today, the switch falls back to a full poll.
+    m_dayPrefetchTimer->stop();
+    return;
+  }
+
+  qint64 prefetchTime = windowStart + QRandomGenerator::global()->bounded(
+                                         windowEnd - windowStart);
+  m_dayPrefetchTimer->start(m_clock->toWallClockInterval(prefetchTime - now));
+}
+
+void DataFetchingHandler::prefetchNextDay() {
+  // Only a synced schedule can take the bookings of another day.
+  if (!m_networkManager || m_scheduleVersion.isEmpty()) {
+    return;
+  }
+
+  QDate nextDate = getCurrentDate().addDays(1);
+  QNetworkRequest request(
+      QUrl(m_endpointSelector->address(m_endpointSelector->selectedIndex()) +
+           "/rooms/" + QString::number(m_roomId) + "/" + m_timeZoneText +
+           "/days/" + nextDate.toString(Qt::ISODate)));
+  QNetworkReply *reply = m_networkManager->get(request);
+  reply->setProperty("isDayPrefetchRequest", true);
+  reply->setProperty("date", nextDate);
+  watchReply(reply);
+}
+
+void DataFetchingHandler::onDayPrefetchRequestFinished(QNetworkReply *reply) {
+  reply->deleteLater();
+  if (reply->error()) {
+    qCWarning(lcNetwork) << "Could not prefetch tomorrow's schedule:"
+                         << reply->errorString();
+    return;
+  }
+
+  QJsonObject dayObject = getParsedBookingDataObjectFromReplyString(
+      QString::fromUtf8(reply->readAll()));
+  QString dayVersion = dayObject["version"].toString();
+  QDate date = reply->property("date").toDate();
+  // A schedule from another run of the backend is replaced by a full one at
+  // the next poll anyway, and one that is already past midnight doesn't
+  // need tomorrow anymore.
+  if (m_scheduleVersion.isEmpty() || dayVersion.isEmpty() ||
+      dayVersion.section('.', 0, 0) != m_scheduleVersion.section('.', 0, 0) ||
+      date != getCurrentDate().addDays(1)) {
+    return;
+  }
+
+  const QJsonArray bookings = dayObject["bookings"].toArray();
+  for (const QJsonValue &booking : bookings) {
+    m_scheduleBookings.insert(booking["id"].toString(), booking.toObject());
+  }
+  m_prefetchedDate = date;
+  // The day is as of its own version. Changes between the two versions are
+  // asked for again when it is the older one, applying them twice is fine.
+  if (isOlderScheduleVersion(dayVersion, m_scheduleVersion)) {
+    m_scheduleVersion = dayVersion;
+  }
+}
+
+void DataFetchingHandler::scheduleDayRollover() {
+  qint64 timeUntilMidnight = getNextMidnight() -
+                             m_clock->currentMSecsSinceEpoch() +
+                             BOOKING_BOUNDARY_MARGIN;
+  m_dayRolloverTimer->start(
+      m_clock->toWallClockInterval(qMax<qint64>(0, timeUntilMidnight)));
+}
+
+void DataFetchingHandler::onDayRollover() {
+  if (m_scheduleDate != getCurrentDate()) {
+    rollOverScheduleDay();
+    if (!m_scheduleVersion.isEmpty()) {
+      processBookingDataObject(getBookingDataObjectFromSchedule());
+    }
+    scheduleDayPrefetch();
+  }
+  scheduleDayRollover();
+}
+
+void DataFetchingHandler::rollOverScheduleDay() {
+  // Without tomorrow's bookings only a full schedule will do.
+  if (m_prefetchedDate == getCurrentDate()) {
+    m_scheduleDate = m_prefetchedDate;
+  } else {
+    m_scheduleVersion.clear();
+  }
+  m_prefetchedDate = QDate();
+}
+
+bool DataFetchingHandler::isOlderScheduleVersion(
+    const QString &scheduleVersion, const QString &otherScheduleVersion) {
+  // Versions are "epoch.counter", see schedule_versions.py in the backend.
+  return scheduleVersion.section('.', 0, 0) ==
+             otherScheduleVersion.section('.', 0, 0) &&
+         scheduleVersion.section('.', 1).toLongLong() <
+             otherScheduleVersion.section('.', 1).toLongLong();
+}
+
 CurrentBookingData DataFetchingHandler::getErrorCurrentBookingData() {
   CurrentBookingData errorCurrentBookingData;
   errorCurrentBookingData.state = CurrentBookingState::ERROR;
@@ -111,8 +816,34 @@ CurrentBookingData DataFetchingHandler::getCurrentBookingData(
   if (id == "") {
     return getUnbookedBookingData();
   } else {
-    return getBookedBookingData(parsedBookingDataObject);
+    return getBookedBookingData(
+        parsedBookingDataObject[QString("current_booking")].toObject());
+  }
+}
+
+CurrentBookingData DataFetchingHandler::getNextBookingData(
+    QJsonObject parsedBookingDataObject,
+    const CurrentBookingData &currentBooking) {
+  QJsonObject firstUpcomingBooking =
+      parsedBookingDataObject[QString("first_upcoming_booking")].toObject();
+  bool hasUpcomingBooking =
+      firstUpcomingBooking[QString("id")].toString() != "";
+
+  if (currentBooking.state == CurrentBookingState::UNBOOKED) {
+    return hasUpcomingBooking ? getBookedBookingData(firstUpcomingBooking)
+                              : CurrentBookingData();
+  }
+
+  // End times are the last second of a booking, so a booking starting right
+  // after it is back to back with the current one.
+  if (hasUpcomingBooking &&
+      firstUpcomingBooking[QString("start_time")].toInteger() <=
+          currentBooking.endTime + 1) {
+    return getBookedBookingData(firstUpcomingBooking);
   }
+  CurrentBookingData nextBooking = getUnbookedBookingData();
+  nextBooking.startTime = currentBooking.endTime + 1;
+  return nextBooking;
 }
 
 CurrentBookingData DataFetchingHandler::getUnbookedBookingData() {
@@ -127,37 +858,59 @@ CurrentBookingData DataFetchingHandler::getUnbookedBookingData() {
   return currentBookingData;
 }
 
+CurrentBookingData DataFetchingHandler::getNextBookingAfter(
+    const CurrentBookingData &booking) {
+  // While the room is free the polled next booking is the first upcoming
+  // one, which follows a booking made in the meantime when back to back.
+  if (m_polledNextBooking.state == CurrentBookingState::BOOKED &&
+      m_polledNextBooking.startTime <= booking.endTime + 1) {
+    return m_polledNextBooking;
+  }
+  CurrentBookingData nextBooking = getUnbookedBookingData();
+  nextBooking.startTime = booking.endTime + 1;
+  return nextBooking;
+}
+
 CurrentBookingData
-DataFetchingHandler::getBookedBookingData(QJsonObject parsedBookingDataObject) {
+DataFetchingHandler::getBookedBookingData(QJsonObject bookingObject) {
   CurrentBookingData currentBookingData;
 
   currentBookingData.state = CurrentBookingState::BOOKED;
-  currentBookingData.id =
-      parsedBookingDataObject[QString("current_booking")][QString("id")]
-          .toString();
-  currentBookingData.name =
-      parsedBookingDataObject[QString("current_booking")][QString("name")]
-          .toString();
+  currentBookingData.id = bookingObject[QString("id")].toString();
+  currentBookingData.name = bookingObject[QString("name")].toString();
   currentBookingData.info =
-      m_bookedUsernamePrefixText +
-      parsedBookingDataObject[QString("current_booking")][QString("user")]
-          .toString();
+      m_bookedUsernamePrefixText + bookingObject[QString("user")].toString();
+  currentBookingData.userId = bookingObject[QString("user_id")].toString();
+  currentBookingData.startTime =
+      bookingObject[QString("start_time")].toInteger();
+  currentBookingData.endTime = bookingObject[QString("end_time")].toInteger();
   currentBookingData.status = getTimeStringFromStartEndTime(
-      parsedBookingDataObject[QString("current_booking")][QString("start_time")]
-          .toInt(),
-      parsedBookingDataObject[QString("current_booking")][QString("end_time")]
-          .toInt());
+      currentBookingData.startTime, currentBookingData.endTime);
 
   return currentBookingData;
 }
 
-void DataFetchingHandler::processUpcomingBookings(
-    QList<UpcomingBookingData> upcomingBookings) {
+void DataFetchingHandler::processNewBookingData(
+    const CurrentBookingData &newCurrentBooking,
+    const QList<UpcomingBookingData> &upcomingBookings,
+    const CurrentBookingData &nextBooking) {
+  bool currentBookingChanged =
+      newCurrentBooking != m_displayState.currentBooking();
+  bool upcomingBookingsChanged =
+      upcomingBookings != m_displayState.upcomingBookings();
+  bool isStale = m_connectionMonitor->state() == ConnectionState::DEGRADED;
+  if (!currentBookingChanged && !upcomingBookingsChanged &&
+      isStale == m_displayState.isStale()) {
+    return;
+  }
 
-  if (upcomingBookings != m_storedUpcomingBookings) {
-    emit upcomingBookingsChanged(upcomingBookings);
-    m_storedUpcomingBookings = upcomingBookings;
+  m_displayState = DisplayState(
+      m_displayState.sequenceNumber() + 1, newCurrentBooking, upcomingBookings,
+      currentBookingChanged, upcomingBookingsChanged, nextBooking, isStale);
+  if (m_displayMetrics) {
+    m_displayMetrics->setCurrentState(newCurrentBooking.state);
   }
+  emit displayStateChanged(m_displayState);
 }
 
 QList<UpcomingBookingData>
@@ -180,11 +933,14 @@ DataFetchingHandler::getUpcomingBookingData(QJsonObject parsedBookingDataObject,
       parsedBookingDataObject[upcomingBookingText][QString("id")].toString();
   upcomingBooking.name =
       parsedBookingDataObject[upcomingBookingText][QString("name")].toString();
-  upcomingBooking.timeString = getTimeStringFromStartEndTime(
+  upcomingBooking.startTime =
       parsedBookingDataObject[upcomingBookingText][QString("start_time")]
-          .toInt(),
+          .toInteger();
+  upcomingBooking.endTime =
       parsedBookingDataObject[upcomingBookingText][QString("end_time")]
-          .toInt());
+          .toInteger();
+  upcomingBooking.timeString = getTimeStringFromStartEndTime(
+      upcomingBooking.startTime, upcomingBooking.endTime);
 
   return upcomingBooking;
 }
@@ -196,18 +952,19 @@ QString DataFetchingHandler::getSystemTimezoneId() {
   return id;
 }
 
-QString DataFetchingHandler::getTimeStringFromStartEndTime(int startTime,
-                                                           int endTime) {
+QString DataFetchingHandler::getTimeStringFromStartEndTime(qint64 startTime,
+                                                           qint64 endTime) {
   if (startTime == 0) {
     return QString("");
   }
 
-  QDateTime start = QDateTime::fromSecsSinceEpoch(startTime);
-  QDateTime end = QDateTime::fromSecsSinceEpoch(endTime + 1);
+  QDateTime start = m_clock->toDateTime(startTime);
+  QDateTime end = m_clock->toDateTime(endTime + 1);
   return start.toString("hh:mm") + " - " + end.toString("hh:mm");
 }
 
 void DataFetchingHandler::stopDataFetching() {
-  m_getRequestTimer->stop();
-  delete m_getRequestTimer;
+  if (m_getRequestTimer) {
+    m_getRequestTimer->stop();
+  }
 }
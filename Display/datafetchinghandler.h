@@ -2,58 +2,171 @@
 #define DATAFETCHINGHANDLER_H
 
 #include "datatypes.h"
+#include "diagnostics/displaymetrics.h"
+#include "diagnostics/occupancyhistory.h"
+#include "diagnostics/payloadlog.h"
+#include "network/connectionmonitor.h"
+#include "network/endpointselector.h"
+#include "timing/clock.h"
+#include <QDate>
+#include <QElapsedTimer>
+#include <QJsonObject>
 #include <QList>
+#include <QMap>
 #include <QObject>
+#include <QPointer>
 #include <QTimer>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkRequest>
 
+// Lives on its own worker thread (see BookingDisplay). Everything it creates
+// is parented to itself so it gets cleaned up together with the thread, and
+// the GUI only ever sees the data through queued signals.
 class DataFetchingHandler : public QObject {
   Q_OBJECT
+  // Times the parsing functions every poll goes through.
+  friend class DataFetchingBench;
+
 public:
-  explicit DataFetchingHandler(QObject *parent = nullptr);
+  // The clock offset estimator and the occupancy history are optional,
+  // replays leave them out. The metrics are optional as well, only one room
+  // reports to them. The network manager is shared by everything on the data
+  // fetching thread, replays don't have one.
+  DataFetchingHandler(int roomId, DisplayMetrics *displayMetrics,
+                      const Clock *clock,
+                      ClockOffsetEstimator *clockOffsetEstimator,
+                      OccupancyHistory *occupancyHistory,
+                      QNetworkAccessManager *networkManager,
+                      QObject *parent = nullptr);
+  ~DataFetchingHandler();
+  void startDataFetching();
+  void stopDataFetching();
   void getBookingData();
+  // The whole pipeline from raw reply to DisplayState, shared with replays.
+  void processPayload(const RecordedPayload &payload);
+  // Shows the booking right away and posts it to the backend afterwards,
+  // rolling it back if the backend rejects it.
+  void bookRoom(int durationMinutes);
+  static QString getSystemTimezoneId();
 
 signals:
-  void currentBookingChanged(CurrentBookingData);
-  void upcomingBookingsChanged(QList<UpcomingBookingData>);
+  void displayStateChanged(const DisplayState &displayState);
+  // The booking wasn't even attempted, so no state change will follow.
+  void bookingRequestIgnored();
+  void scheduleVersionChanged(const QString &scheduleVersion);
 
 private:
   QNetworkAccessManager *m_networkManager;
-  QNetworkRequest *m_getRequest;
-  CurrentBookingData m_storedCurrentBookingData;
-  QList<UpcomingBookingData> m_storedUpcomingBookings;
+  DisplayState m_displayState;
   QTimer *m_getRequestTimer;
+  QTimer *m_hedgeTimer;
+  QTimer *m_boundaryTimer;
+  QTimer *m_connectionTimeoutTimer;
+  DisplayMetrics *m_displayMetrics;
+  const Clock *m_clock;
+  ClockOffsetEstimator *m_clockOffsetEstimator;
+  OccupancyHistory *m_occupancyHistory;
+  QElapsedTimer m_requestClock;
+  PayloadLogWriter *m_payloadLogWriter;
+  QString m_recordPayloadsPath;
+  EndpointSelector *m_endpointSelector;
+  ConnectionMonitor *m_connectionMonitor;
+  int m_hedgeDelay;
+  int m_pollInterval;
+
+  // Every poll gets a number, shared by its hedged request. Only the first
+  // answer to a poll newer than the last answered one is processed.
+  quint64 m_pollNumber;
+  quint64 m_lastAnsweredPollNumber;
+  quint64 m_hedgedPollNumber;
+  QList<QPointer<QNetworkReply>> m_outstandingReplies;
+
+  // The rest of today's schedule as last synced with the backend, which then
+  // only sends what changed since this version. Cleared when the day changes,
+  // since only a full reply has the new day's bookings.
+  QString m_scheduleVersion;
+  QDate m_scheduleDate;
+  QMap<QString, QJsonObject> m_scheduleBookings;
+  // Tomorrow's bookings are merged into the schedule at a random moment
+  // before midnight, so the displays switch days by themselves instead of
+  // all asking for a full schedule at midnight. Invalid when not prefetched.
+  QDate m_prefetchedDate;
+  QTimer *m_dayPrefetchTimer;
+  QTimer *m_dayRolloverTimer;
+
+  // A booking made on this display is shown instead of the polled current
+  // booking until a poll includes it, the backend rejects it or the deadline
+  // passes. Its ID is empty when there is none.
+  CurrentBookingData m_optimisticBooking;
+  qint64 m_optimisticBookingDeadline;
+  CurrentBookingData m_polledCurrentBooking;
+  QList<UpcomingBookingData> m_polledUpcomingBookings;
+  CurrentBookingData m_polledNextBooking;
 
-  QString m_apiAddress;
   int m_roomId;
-  QString m_constructedURL;
   QString m_unbookedNameText;
   QString m_unbookedInfoText;
   QString m_unbookedStatusText;
   QString m_bookedUsernamePrefixText;
   QString m_timeZoneText;
+  QString m_bookNowNameText;
+  QString m_bookNowUserText;
+  QString m_bookNowToken;
 
   void retrieveSettings();
+  void sendBookingDataRequest(int endpointIndex, quint64 pollNumber);
+  void sendHedgedRequest();
+  bool hasOutstandingReply(quint64 pollNumber);
+  void cancelOutstandingReplies(quint64 upToPollNumber);
+  void watchReply(QNetworkReply *reply);
   void onBookingDataRequestFinished(QNetworkReply *reply);
+  double getRoundTripTime(QNetworkReply *reply);
+  void recordServerTime(QNetworkReply *reply);
+  void scheduleBoundaryUpdate(const CurrentBookingData &nextBooking);
+  void onBookingBoundary();
+  void onConnectionTimeout();
+  void processBookingDataObject(const QJsonObject &bookingDataObject);
   QJsonObject getParsedBookingDataObjectFromReplyString(QString replyString);
+  QJsonObject applyScheduleUpdate(const QJsonObject &replyObject);
+  QJsonObject getBookingDataObjectFromSchedule();
+  QDate getCurrentDate() const;
+  qint64 getNextMidnight() const;
+  void scheduleDayPrefetch();
+  void prefetchNextDay();
+  void onDayPrefetchRequestFinished(QNetworkReply *reply);
+  void scheduleDayRollover();
+  void onDayRollover();
+  void rollOverScheduleDay();
+  static bool isOlderScheduleVersion(const QString &scheduleVersion,
+                                     const QString &otherScheduleVersion);
+  void onBookNowRequestFinished(QNetworkReply *reply);
+  void rollBackOptimisticBooking();
 
   CurrentBookingData getErrorCurrentBookingData();
   CurrentBookingData getCurrentBookingData(QJsonObject parsedBookingDataObject);
-  CurrentBookingData getBookedBookingData(QJsonObject parsedBookingDataObject);
+  CurrentBookingData getBookedBookingData(QJsonObject bookingObject);
+  CurrentBookingData
+  getNextBookingData(QJsonObject parsedBookingDataObject,
+                     const CurrentBookingData &currentBooking);
   CurrentBookingData getUnbookedBookingData();
+  CurrentBookingData getNextBookingAfter(const CurrentBookingData &booking);
+
+  void processPolledBookingData(
+      const CurrentBookingData &currentBooking,
+      const QList<UpcomingBookingData> &upcomingBookings,
+      const CurrentBookingData &nextBooking = CurrentBookingData());
 
-  void processUpcomingBookings(QList<UpcomingBookingData> upcomingBookings);
+  void processNewBookingData(
+      const CurrentBookingData &newCurrentBooking,
+      const QList<UpcomingBookingData> &upcomingBookings,
+      const CurrentBookingData &nextBooking = CurrentBookingData());
   QList<UpcomingBookingData>
   getUpcomingBookings(QJsonObject parsedBookingDataObject);
   UpcomingBookingData
   getUpcomingBookingData(QJsonObject parsedBookingDataObject,
                          QString upcomingBookingText);
 
-  QString getSystemTimezoneId();
-  QString getTimeStringFromStartEndTime(int startTime, int endTime);
-
-  void stopDataFetching();
+  QString getTimeStringFromStartEndTime(qint64 startTime, qint64 endTime);
 };
 
 #endif // DATAFETCHINGHANDLER_H
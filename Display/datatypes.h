@@ -1,6 +1,12 @@
 #ifndef DATATYPES_H
 #define DATATYPES_H
 
+#include <QColor>
+#include <QDate>
+#include <QExplicitlySharedDataPointer>
+#include <QList>
+#include <QMetaType>
+#include <QSharedData>
 #include <QString>
 
 enum class CurrentBookingState { UNBOOKED, BOOKED, ERROR };
@@ -11,6 +17,9 @@ struct CurrentBookingData {
   QString name = "";
   QString info = "";
   QString status = "";
+  QString userId = "";
+  qint64 startTime = 0;
+  qint64 endTime = 0;
 
   bool operator==(const CurrentBookingData &other) const {
     return id == other.id && status == other.status;
@@ -25,6 +34,8 @@ struct UpcomingBookingData {
   QString id = "";
   QString name = "";
   QString timeString = "";
+  qint64 startTime = 0;
+  qint64 endTime = 0;
 
   bool operator==(const UpcomingBookingData &other) const {
     return id == other.id && timeString == other.timeString;
@@ -35,4 +46,79 @@ struct UpcomingBookingData {
   }
 };
 
+struct DisplayStateData : public QSharedData {
+  quint64 sequenceNumber = 0;
+  CurrentBookingData currentBooking;
+  QList<UpcomingBookingData> upcomingBookings;
+  bool currentBookingChanged = false;
+  bool upcomingBookingsChanged = false;
+  CurrentBookingData nextBooking;
+  bool isStale = false;
+};
+
+// Immutable snapshot of everything the display shows, emitted once per change.
+// Copies only share the data, so it can be passed around (and across threads)
+// freely. Consumers can drop snapshots with an older sequence number. The next
+// booking is what the display will most likely show from its start time on, so
+// it can be prepared in advance. Its start time is 0 when there is none. A
+// stale state is the last one received, kept while the backend can't be
+// reached for a moment.
+class DisplayState {
+public:
+  DisplayState() : d(new DisplayStateData()) {}
+  DisplayState(quint64 sequenceNumber, const CurrentBookingData &currentBooking,
+               const QList<UpcomingBookingData> &upcomingBookings,
+               bool currentBookingChanged, bool upcomingBookingsChanged,
+               const CurrentBookingData &nextBooking = CurrentBookingData(),
+               bool isStale = false) {
+    DisplayStateData *data = new DisplayStateData();
+    data->sequenceNumber = sequenceNumber;
+    data->currentBooking = currentBooking;
+    data->upcomingBookings = upcomingBookings;
+    data->currentBookingChanged = currentBookingChanged;
+    data->upcomingBookingsChanged = upcomingBookingsChanged;
+    data->nextBooking = nextBooking;
+    data->isStale = isStale;
+    d.reset(data);
+  }
+
+  quint64 sequenceNumber() const { return d->sequenceNumber; }
+  const CurrentBookingData &currentBooking() const { return d->currentBooking; }
+  const QList<UpcomingBookingData> &upcomingBookings() const {
+    return d->upcomingBookings;
+  }
+  bool currentBookingChanged() const { return d->currentBookingChanged; }
+  bool upcomingBookingsChanged() const { return d->upcomingBookingsChanged; }
+  const CurrentBookingData &nextBooking() const { return d->nextBooking; }
+  bool isStale() const { return d->isStale; }
+
+private:
+  QExplicitlySharedDataPointer<const DisplayStateData> d;
+};
+
+// All bookings of one day, as shown by the week view. The version is the
+// schedule version the page was fetched at, the date is invalid for a page
+// that was never fetched.
+struct ScheduleDayPage {
+  QDate date;
+  QString version;
+  qint64 fetchedAt = 0;
+  bool isStale = false;
+  QList<UpcomingBookingData> bookings;
+};
+
+// What one physical screen shows. A host between two rooms drives a panel for
+// each from the same process.
+struct ScreenConfiguration {
+  int roomId = 0;
+  QColor backgroundColor;
+  QColor unbookedColor;
+  QColor bookedColor;
+};
+
+Q_DECLARE_METATYPE(CurrentBookingData)
+Q_DECLARE_METATYPE(UpcomingBookingData)
+Q_DECLARE_METATYPE(DisplayState)
+Q_DECLARE_METATYPE(ScheduleDayPage)
+
 #endif // DATATYPES_H
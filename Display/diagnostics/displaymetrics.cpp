@@ -0,0 +1,419 @@
+#include "displaymetrics.h"
+#include <QFile>
+#include <QMetaEnum>
+#include <QMutexLocker>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+
+#include <psapi.h>
+#endif
+
+DisplayMetrics::DisplayMetrics(QObject *parent)
+    : QObject{parent},
+      m_pollRoundTripTimes(
+          {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0}),
+      m_frameTimes({0.002, 0.004, 0.008, 0.016, 0.033, 0.05, 0.1, 0.25}),
+      m_epaperRenderTimes({0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5}),
+      m_successfulPolls(0), m_lastSuccessfulUpdate(-1),
+      m_currentState(static_cast<int>(CurrentBookingState::ERROR)),
+      m_relayRequests{0, 0, 0, 0}, m_relayUpstreamRequests(0),
+      m_hedgedRequests(0), m_targetAnimationFrameRate(0),
+      m_animationFrameRate(-1), m_droppedAnimationFrames(0),
+      m_clockOffset(0), m_clockOffsetUncertainty(-1),
+      m_connectionState(static_cast<int>(ConnectionState::DISCONNECTED)),
+      m_suppressedConnectionFlaps(0), m_epaperRefreshedPixels(0),
+      m_epaperPartialRefreshes(0), m_epaperFullRefreshes(0),
+      m_epaperPixelsRefreshedToday(0) {
+  m_uptime.start();
+}
+
+void DisplayMetrics::recordPollSuccess(double roundTripTime) {
+  m_pollRoundTripTimes.observe(roundTripTime);
+  m_successfulPolls.fetch_add(1, std::memory_order_relaxed);
+  m_lastSuccessfulUpdate.store(m_uptime.elapsed(), std::memory_order_relaxed);
+}
+
+void DisplayMetrics::recordPollError(QNetworkReply::NetworkError error,
+                                     double roundTripTime) {
+  m_pollRoundTripTimes.observe(roundTripTime);
+  QMutexLocker locker(&m_pollErrorsMutex);
+  m_pollErrors[static_cast<int>(error)]++;
+}
+
+void DisplayMetrics::setCurrentState(CurrentBookingState state) {
+  m_currentState.store(static_cast<int>(state), std::memory_order_relaxed);
+}
+
+void DisplayMetrics::recordFrameTime(double frameTime) {
+  m_frameTimes.observe(frameTime);
+}
+
+void DisplayMetrics::recordRelayRequest(RelayRequestResult result) {
+  m_relayRequests[static_cast<int>(result)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::recordRelayUpstreamRequest() {
+  m_relayUpstreamRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::setEndpointHealth(
+    const QList<EndpointHealth> &endpointHealth) {
+  QMutexLocker locker(&m_endpointHealthMutex);
+  m_endpointHealth = endpointHealth;
+}
+
+void DisplayMetrics::recordHedgedRequest() {
+  m_hedgedRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::setTargetAnimationFrameRate(int frameRate) {
+  m_targetAnimationFrameRate.store(frameRate, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::setAnimationFrameRate(double frameRate) {
+  m_animationFrameRate.store(frameRate, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::recordDroppedAnimationFrames(quint64 droppedFrames) {
+  m_droppedAnimationFrames.fetch_add(droppedFrames, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::setClockOffset(double offset, double uncertainty) {
+  m_clockOffset.store(offset, std::memory_order_relaxed);
+  m_clockOffsetUncertainty.store(uncertainty, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::setConnectionState(ConnectionState state) {
+  m_connectionState.store(static_cast<int>(state), std::memory_order_relaxed);
+}
+
+void DisplayMetrics::recordSuppressedConnectionFlap() {
+  m_suppressedConnectionFlaps.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::recordEpaperRenderTime(double renderTime) {
+  m_epaperRenderTimes.observe(renderTime);
+}
+
+void DisplayMetrics::recordEpaperRefresh(quint64 refreshedPixels,
+                                         bool isFullRefresh) {
+  m_epaperRefreshedPixels.fetch_add(refreshedPixels, std::memory_order_relaxed);
+  (isFullRefresh ? m_epaperFullRefreshes : m_epaperPartialRefreshes)
+      .fetch_add(1, std::memory_order_relaxed);
+}
+
+void DisplayMetrics::setEpaperPixelsRefreshedToday(quint64 refreshedPixels) {
+  m_epaperPixelsRefreshedToday.store(refreshedPixels,
+                                     std::memory_order_relaxed);
+}
+
+quint64 DisplayMetrics::frameCount() const { return m_frameTimes.count(); }
+
+double DisplayMetrics::totalFrameTime() const { return m_frameTimes.sum(); }
+
+QByteArray DisplayMetrics::toPrometheusText() const {
+  QByteArray text;
+
+  text += m_pollRoundTripTimes.toPrometheusText(
+      "roombooker_poll_round_trip_time_seconds",
+      "Round trip time of booking data requests.");
+
+  text += "# HELP roombooker_polls_succeeded_total Successful booking data "
+          "requests.\n";
+  text += "# TYPE roombooker_polls_succeeded_total counter\n";
+  text += "roombooker_polls_succeeded_total " +
+          QByteArray::number(m_successfulPolls.load(std::memory_order_relaxed)) +
+          "\n";
+
+  text += "# HELP roombooker_poll_errors_total Failed booking data requests "
+          "by QNetworkReply::NetworkError.\n";
+  text += "# TYPE roombooker_poll_errors_total counter\n";
+  {
+    QMutexLocker locker(&m_pollErrorsMutex);
+    QMetaEnum networkErrorEnum =
+        QMetaEnum::fromType<QNetworkReply::NetworkError>();
+    for (auto it = m_pollErrors.constBegin(); it != m_pollErrors.constEnd();
+         ++it) {
+      const char *errorName = networkErrorEnum.valueToKey(it.key());
+      QByteArray label = errorName ? QByteArray(errorName)
+                                   : QByteArray::number(it.key());
+      text += "roombooker_poll_errors_total{error=\"" + label + "\"} " +
+              QByteArray::number(it.value()) + "\n";
+    }
+  }
+
+  text += "# HELP roombooker_seconds_since_last_successful_update Time since "
+          "the backend last answered successfully.\n";
+  text += "# TYPE roombooker_seconds_since_last_successful_update gauge\n";
+  qint64 lastSuccessfulUpdate =
+      m_lastSuccessfulUpdate.load(std::memory_order_relaxed);
+  text += "roombooker_seconds_since_last_successful_update " +
+          (lastSuccessfulUpdate < 0
+               ? QByteArray("+Inf")
+               : QByteArray::number(
+                     (m_uptime.elapsed() - lastSuccessfulUpdate) / 1000.0, 'f',
+                     3)) +
+          "\n";
+
+  text += "# HELP roombooker_current_state Booking state currently shown.\n";
+  text += "# TYPE roombooker_current_state gauge\n";
+  int currentState = m_currentState.load(std::memory_order_relaxed);
+  const QList<QPair<CurrentBookingState, QByteArray>> stateNames = {
+      {CurrentBookingState::UNBOOKED, "unbooked"},
+      {CurrentBookingState::BOOKED, "booked"},
+      {CurrentBookingState::ERROR, "error"}};
+  for (const QPair<CurrentBookingState, QByteArray> &stateName : stateNames) {
+    text += "roombooker_current_state{state=\"" + stateName.second + "\"} " +
+            (currentState == static_cast<int>(stateName.first) ? "1" : "0") +
+            "\n";
+  }
+
+  text += "# HELP roombooker_connection_state Connection to the backend as "
+          "the display sees it.\n";
+  text += "# TYPE roombooker_connection_state gauge\n";
+  int connectionState = m_connectionState.load(std::memory_order_relaxed);
+  const QList<QPair<ConnectionState, QByteArray>> connectionStateNames = {
+      {ConnectionState::CONNECTED, "connected"},
+      {ConnectionState::DEGRADED, "degraded"},
+      {ConnectionState::DISCONNECTED, "disconnected"}};
+  for (const QPair<ConnectionState, QByteArray> &connectionStateName :
+       connectionStateNames) {
+    text += "roombooker_connection_state{state=\"" +
+            connectionStateName.second + "\"} " +
+            (connectionState == static_cast<int>(connectionStateName.first)
+                 ? "1"
+                 : "0") +
+            "\n";
+  }
+
+  text += "# HELP roombooker_connection_flaps_suppressed_total Runs of failed "
+          "polls that recovered before the error was shown.\n";
+  text += "# TYPE roombooker_connection_flaps_suppressed_total counter\n";
+  text += "roombooker_connection_flaps_suppressed_total " +
+          QByteArray::number(
+              m_suppressedConnectionFlaps.load(std::memory_order_relaxed)) +
+          "\n";
+
+  double clockOffsetUncertainty =
+      m_clockOffsetUncertainty.load(std::memory_order_relaxed);
+  if (clockOffsetUncertainty >= 0) {
+    text += "# HELP roombooker_clock_offset_seconds Correction applied to the "
+            "local clock to match the backend's.\n";
+    text += "# TYPE roombooker_clock_offset_seconds gauge\n";
+    text += "roombooker_clock_offset_seconds " +
+            QByteArray::number(m_clockOffset.load(std::memory_order_relaxed),
+                               'f', 3) +
+            "\n";
+    text += "# HELP roombooker_clock_offset_uncertainty_seconds How far the "
+            "clock offset can be off at most.\n";
+    text += "# TYPE roombooker_clock_offset_uncertainty_seconds gauge\n";
+    text += "roombooker_clock_offset_uncertainty_seconds " +
+            QByteArray::number(clockOffsetUncertainty, 'f', 3) + "\n";
+  }
+
+  {
+    QMutexLocker locker(&m_endpointHealthMutex);
+    if (!m_endpointHealth.isEmpty()) {
+      text += "# HELP roombooker_api_endpoint_selected Backend endpoint "
+              "currently polled.\n";
+      text += "# TYPE roombooker_api_endpoint_selected gauge\n";
+      for (const EndpointHealth &endpoint : m_endpointHealth) {
+        text += "roombooker_api_endpoint_selected{endpoint=\"" +
+                getEscapedLabelValue(endpoint.address) + "\"} " +
+                (endpoint.selected ? "1" : "0") + "\n";
+      }
+
+      text += "# HELP roombooker_api_endpoint_round_trip_time_seconds "
+              "Smoothed round trip time per backend endpoint.\n";
+      text += "# TYPE roombooker_api_endpoint_round_trip_time_seconds "
+              "gauge\n";
+      for (const EndpointHealth &endpoint : m_endpointHealth) {
+        if (endpoint.smoothedRoundTripTime >= 0) {
+          text += "roombooker_api_endpoint_round_trip_time_seconds"
+                  "{endpoint=\"" +
+                  getEscapedLabelValue(endpoint.address) + "\"} " +
+                  QByteArray::number(endpoint.smoothedRoundTripTime, 'f', 4) +
+                  "\n";
+        }
+      }
+
+      text += "# HELP roombooker_api_endpoint_error_rate Smoothed share of "
+              "failed requests per backend endpoint.\n";
+      text += "# TYPE roombooker_api_endpoint_error_rate gauge\n";
+      for (const EndpointHealth &endpoint : m_endpointHealth) {
+        text += "roombooker_api_endpoint_error_rate{endpoint=\"" +
+                getEscapedLabelValue(endpoint.address) + "\"} " +
+                QByteArray::number(endpoint.errorRate, 'f', 4) + "\n";
+      }
+    }
+  }
+
+  text += "# HELP roombooker_hedged_requests_total Requests repeated on "
+          "another endpoint because the selected one was slow or failed.\n";
+  text += "# TYPE roombooker_hedged_requests_total counter\n";
+  text += "roombooker_hedged_requests_total " +
+          QByteArray::number(m_hedgedRequests.load(std::memory_order_relaxed)) +
+          "\n";
+
+  text += m_frameTimes.toPrometheusText(
+      "roombooker_frame_time_seconds",
+      "Time spent painting a frame of the booking display.");
+
+  int targetAnimationFrameRate =
+      m_targetAnimationFrameRate.load(std::memory_order_relaxed);
+  if (targetAnimationFrameRate > 0) {
+    text += "# HELP roombooker_animation_target_frames_per_second Frame rate "
+            "cap of the display animations.\n";
+    text += "# TYPE roombooker_animation_target_frames_per_second gauge\n";
+    text += "roombooker_animation_target_frames_per_second " +
+            QByteArray::number(targetAnimationFrameRate) + "\n";
+
+    double animationFrameRate =
+        m_animationFrameRate.load(std::memory_order_relaxed);
+    if (animationFrameRate >= 0) {
+      text += "# HELP roombooker_animation_frames_per_second Frame rate "
+              "reached during the last measured stretch of animation.\n";
+      text += "# TYPE roombooker_animation_frames_per_second gauge\n";
+      text += "roombooker_animation_frames_per_second " +
+              QByteArray::number(animationFrameRate, 'f', 1) + "\n";
+    }
+
+    text += "# HELP roombooker_animation_dropped_frames_total Animation "
+            "frames skipped because the previous one was late.\n";
+    text += "# TYPE roombooker_animation_dropped_frames_total counter\n";
+    text += "roombooker_animation_dropped_frames_total " +
+            QByteArray::number(
+                m_droppedAnimationFrames.load(std::memory_order_relaxed)) +
+            "\n";
+  }
+
+  // Kept apart from the frame times, an e-paper frame is drawn and quantized
+  // offscreen once per refresh and takes far longer than an animation frame.
+  if (m_epaperRenderTimes.count() > 0) {
+    text += m_epaperRenderTimes.toPrometheusText(
+        "roombooker_epaper_render_seconds",
+        "Time spent drawing and quantizing a frame for the e-paper panel.");
+  }
+
+  quint64 epaperFullRefreshes =
+      m_epaperFullRefreshes.load(std::memory_order_relaxed);
+  if (epaperFullRefreshes > 0) {
+    text += "# HELP roombooker_epaper_refreshes_total Refreshes sent to the "
+            "e-paper panel, by kind.\n";
+    text += "# TYPE roombooker_epaper_refreshes_total counter\n";
+    text += "roombooker_epaper_refreshes_total{kind=\"full\"} " +
+            QByteArray::number(epaperFullRefreshes) + "\n";
+    text += "roombooker_epaper_refreshes_total{kind=\"partial\"} " +
+            QByteArray::number(
+                m_epaperPartialRefreshes.load(std::memory_order_relaxed)) +
+            "\n";
+
+    text += "# HELP roombooker_epaper_refreshed_pixels_total Pixels "
+            "refreshed on the e-paper panel.\n";
+    text += "# TYPE roombooker_epaper_refreshed_pixels_total counter\n";
+    text += "roombooker_epaper_refreshed_pixels_total " +
+            QByteArray::number(
+                m_epaperRefreshedPixels.load(std::memory_order_relaxed)) +
+            "\n";
+
+    text += "# HELP roombooker_epaper_refreshed_pixels_today Pixels "
+            "refreshed on the e-paper panel since midnight.\n";
+    text += "# TYPE roombooker_epaper_refreshed_pixels_today gauge\n";
+    text += "roombooker_epaper_refreshed_pixels_today " +
+            QByteArray::number(
+                m_epaperPixelsRefreshedToday.load(std::memory_order_relaxed)) +
+            "\n";
+  }
+
+  quint64 relayUpstreamRequests =
+      m_relayUpstreamRequests.load(std::memory_order_relaxed);
+  if (relayUpstreamRequests > 0) {
+    text += "# HELP roombooker_relay_requests_total Requests served by the "
+            "relay, by how they were answered.\n";
+    text += "# TYPE roombooker_relay_requests_total counter\n";
+    const QList<QPair<RelayRequestResult, QByteArray>> resultNames = {
+        {RelayRequestResult::HIT, "hit"},
+        {RelayRequestResult::MISS, "miss"},
+        {RelayRequestResult::STALE, "stale"},
+        {RelayRequestResult::FAILED, "failed"}};
+    quint64 totalRelayRequests = 0;
+    for (const QPair<RelayRequestResult, QByteArray> &resultName :
+         resultNames) {
+      quint64 count = m_relayRequests[static_cast<int>(resultName.first)].load(
+          std::memory_order_relaxed);
+      totalRelayRequests += count;
+      text += "roombooker_relay_requests_total{result=\"" + resultName.second +
+              "\"} " + QByteArray::number(count) + "\n";
+    }
+
+    text += "# HELP roombooker_relay_hit_ratio Share of relay requests "
+            "answered straight from the cache.\n";
+    text += "# TYPE roombooker_relay_hit_ratio gauge\n";
+    quint64 relayHits =
+        m_relayRequests[static_cast<int>(RelayRequestResult::HIT)].load(
+            std::memory_order_relaxed);
+    text += "roombooker_relay_hit_ratio " +
+            QByteArray::number(totalRelayRequests == 0
+                                   ? 0.0
+                                   : double(relayHits) / totalRelayRequests,
+                               'f', 4) +
+            "\n";
+
+    text += "# HELP roombooker_relay_upstream_requests_total Batched requests "
+            "the relay sent to the backend.\n";
+    text += "# TYPE roombooker_relay_upstream_requests_total counter\n";
+    text += "roombooker_relay_upstream_requests_total " +
+            QByteArray::number(relayUpstreamRequests) + "\n";
+  }
+
+  text += "# HELP roombooker_uptime_seconds Time since the display started.\n";
+  text += "# TYPE roombooker_uptime_seconds gauge\n";
+  text += "roombooker_uptime_seconds " +
+          QByteArray::number(m_uptime.elapsed() / 1000.0, 'f', 3) + "\n";
+
+  qint64 residentMemoryBytes = getResidentMemoryBytes();
+  if (residentMemoryBytes >= 0) {
+    text += "# HELP process_resident_memory_bytes Resident memory size in "
+            "bytes.\n";
+    text += "# TYPE process_resident_memory_bytes gauge\n";
+    text += "process_resident_memory_bytes " +
+            QByteArray::number(residentMemoryBytes) + "\n";
+  }
+
+  return text;
+}
+
+QByteArray DisplayMetrics::getEscapedLabelValue(const QString &value) {
+  QByteArray escapedValue = value.toUtf8();
+  escapedValue.replace("\\", "\\\\");
+  escapedValue.replace("\"", "\\\"");
+  escapedValue.replace("\n", "\\n");
+  return escapedValue;
+}
+
+qint64 DisplayMetrics::getResidentMemoryBytes() {
+#if defined(Q_OS_LINUX)
+  QFile statmFile("/proc/self/statm");
+  if (!statmFile.open(QIODevice::ReadOnly)) {
+    return -1;
+  }
+  QList<QByteArray> statmFields = statmFile.readAll().split(' ');
+  if (statmFields.size() < 2) {
+    return -1;
+  }
+  return statmFields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#elif defined(Q_OS_WIN)
+  PROCESS_MEMORY_COUNTERS memoryCounters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters,
+                            sizeof(memoryCounters))) {
+    return -1;
+  }
+  return static_cast<qint64>(memoryCounters.WorkingSetSize);
+#else
+  return -1;
+#endif
+}
@@ -0,0 +1,80 @@
+#ifndef DISPLAYMETRICS_H
+#define DISPLAYMETRICS_H
+
+#include "../datatypes.h"
+#include "../network/connectionmonitor.h"
+#include "../network/endpointselector.h"
+#include "metricshistogram.h"
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QtNetwork/QNetworkReply>
+#include <atomic>
+
+enum class RelayRequestResult { HIT, MISS, STALE, FAILED };
+
+// Health numbers of this display. Written from both the GUI thread (frame
+// times) and the data fetching thread (polls), read by the metrics endpoint.
+class DisplayMetrics : public QObject {
+  Q_OBJECT
+public:
+  explicit DisplayMetrics(QObject *parent = nullptr);
+
+  void recordPollSuccess(double roundTripTime);
+  void recordPollError(QNetworkReply::NetworkError error,
+                       double roundTripTime);
+  void setCurrentState(CurrentBookingState state);
+  void recordFrameTime(double frameTime);
+  void recordRelayRequest(RelayRequestResult result);
+  void recordRelayUpstreamRequest();
+  void setEndpointHealth(const QList<EndpointHealth> &endpointHealth);
+  void recordHedgedRequest();
+  void setTargetAnimationFrameRate(int frameRate);
+  void setAnimationFrameRate(double frameRate);
+  void recordDroppedAnimationFrames(quint64 droppedFrames);
+  void setClockOffset(double offset, double uncertainty);
+  void setConnectionState(ConnectionState state);
+  void recordSuppressedConnectionFlap();
+  void recordEpaperRenderTime(double renderTime);
+  void recordEpaperRefresh(quint64 refreshedPixels, bool isFullRefresh);
+  void setEpaperPixelsRefreshedToday(quint64 refreshedPixels);
+  quint64 frameCount() const;
+  double totalFrameTime() const;
+
+  QByteArray toPrometheusText() const;
+
+private:
+  QElapsedTimer m_uptime;
+  MetricsHistogram m_pollRoundTripTimes;
+  MetricsHistogram m_frameTimes;
+  MetricsHistogram m_epaperRenderTimes;
+  std::atomic<quint64> m_successfulPolls;
+  std::atomic<qint64> m_lastSuccessfulUpdate;
+  std::atomic<int> m_currentState;
+  std::atomic<quint64> m_relayRequests[4];
+  std::atomic<quint64> m_relayUpstreamRequests;
+  std::atomic<quint64> m_hedgedRequests;
+  std::atomic<int> m_targetAnimationFrameRate;
+  std::atomic<double> m_animationFrameRate;
+  std::atomic<quint64> m_droppedAnimationFrames;
+  std::atomic<double> m_clockOffset;
+  std::atomic<double> m_clockOffsetUncertainty;
+  std::atomic<int> m_connectionState;
+  std::atomic<quint64> m_suppressedConnectionFlaps;
+  std::atomic<quint64> m_epaperRefreshedPixels;
+  std::atomic<quint64> m_epaperPartialRefreshes;
+  std::atomic<quint64> m_epaperFullRefreshes;
+  std::atomic<quint64> m_epaperPixelsRefreshedToday;
+
+  mutable QMutex m_endpointHealthMutex;
+  QList<EndpointHealth> m_endpointHealth;
+
+  mutable QMutex m_pollErrorsMutex;
+  QMap<int, quint64> m_pollErrors;
+
+  static qint64 getResidentMemoryBytes();
+  static QByteArray getEscapedLabelValue(const QString &value);
+};
+
+#endif // DISPLAYMETRICS_H
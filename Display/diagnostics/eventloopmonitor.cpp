@@ -0,0 +1,55 @@
+#include "eventloopmonitor.h"
+#include "logging.h"
+
+namespace {
+const int TICK_INTERVAL = 5;
+}
+
+EventLoopMonitor::EventLoopMonitor(QObject *parent)
+    : QObject{parent}, m_tickTimer(new QTimer(this)), m_transitionDuration(0),
+      m_watchingTransition(false), m_maxStall(0), m_transitionMaxStall(0),
+      m_lastTransitionMaxStall(0) {
+  m_tickTimer->setTimerType(Qt::PreciseTimer);
+  m_tickTimer->setInterval(TICK_INTERVAL);
+  connect(m_tickTimer, &QTimer::timeout, this, &EventLoopMonitor::onTick);
+  m_sinceLastTick.start();
+  m_tickTimer->start();
+}
+
+void EventLoopMonitor::watchTransition(int transitionDuration) {
+  m_transitionDuration = transitionDuration;
+  m_transitionMaxStall = 0;
+  m_watchingTransition = true;
+  m_sinceTransitionStart.start();
+}
+
+qint64 EventLoopMonitor::maxStall() const { return m_maxStall; }
+
+qint64 EventLoopMonitor::lastTransitionMaxStall() const {
+  return m_lastTransitionMaxStall;
+}
+
+void EventLoopMonitor::onTick() {
+  qint64 stall = m_sinceLastTick.restart() - TICK_INTERVAL;
+  if (stall < 0) {
+    stall = 0;
+  }
+  m_maxStall = qMax(m_maxStall, stall);
+
+  if (!m_watchingTransition) {
+    return;
+  }
+
+  m_transitionMaxStall = qMax(m_transitionMaxStall, stall);
+  if (m_sinceTransitionStart.elapsed() >= m_transitionDuration) {
+    finishTransition();
+  }
+}
+
+void EventLoopMonitor::finishTransition() {
+  m_watchingTransition = false;
+  m_lastTransitionMaxStall = m_transitionMaxStall;
+  qCInfo(lcAnimation) << "Max event loop stall during transition:"
+                      << m_lastTransitionMaxStall << "ms";
+  emit transitionStallMeasured(m_lastTransitionMaxStall);
+}
@@ -0,0 +1,36 @@
+#ifndef EVENTLOOPMONITOR_H
+#define EVENTLOOPMONITOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+// Measures how long the event loop of the thread it lives on gets blocked, by
+// checking how late a short precise timer fires. While a transition is being
+// watched the largest stall is kept and reported once the transition is over.
+class EventLoopMonitor : public QObject {
+  Q_OBJECT
+public:
+  explicit EventLoopMonitor(QObject *parent = nullptr);
+  void watchTransition(int transitionDuration);
+  qint64 maxStall() const;
+  qint64 lastTransitionMaxStall() const;
+
+signals:
+  void transitionStallMeasured(qint64 maxStall);
+
+private:
+  QTimer *m_tickTimer;
+  QElapsedTimer m_sinceLastTick;
+  QElapsedTimer m_sinceTransitionStart;
+  int m_transitionDuration;
+  bool m_watchingTransition;
+  qint64 m_maxStall;
+  qint64 m_transitionMaxStall;
+  qint64 m_lastTransitionMaxStall;
+
+  void onTick();
+  void finishTransition();
+};
+
+#endif // EVENTLOOPMONITOR_H
@@ -0,0 +1,24 @@
+#include "logging.h"
+
+Q_LOGGING_CATEGORY(lcNetwork, "roombooker.network")
+Q_LOGGING_CATEGORY(lcParse, "roombooker.parse")
+Q_LOGGING_CATEGORY(lcAnimation, "roombooker.animation")
+Q_LOGGING_CATEGORY(lcSettings, "roombooker.settings")
+Q_LOGGING_CATEGORY(lcDiagnostics, "roombooker.diagnostics")
+
+void setLogLevel(const QString &level) {
+  const QStringList levels = {"debug", "info", "warning", "critical"};
+  QStringList rules;
+  for (const QString &disabledLevel : levels) {
+    if (disabledLevel == level) {
+      break;
+    }
+    rules.append(QString("*.%1=false").arg(disabledLevel));
+  }
+  // An unknown level would otherwise turn off everything, this is the
+  // default instead.
+  if (rules.size() == levels.size()) {
+    rules = QStringList{"*.debug=false"};
+  }
+  QLoggingCategory::setFilterRules(rules.join('\n'));
+}
@@ -0,0 +1,20 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QLoggingCategory>
+#include <QString>
+
+// One category per subsystem, so a single one can be turned up to debug with
+// QT_LOGGING_RULES while looking into a problem in the field.
+Q_DECLARE_LOGGING_CATEGORY(lcNetwork)
+Q_DECLARE_LOGGING_CATEGORY(lcParse)
+Q_DECLARE_LOGGING_CATEGORY(lcAnimation)
+Q_DECLARE_LOGGING_CATEGORY(lcSettings)
+Q_DECLARE_LOGGING_CATEGORY(lcDiagnostics)
+
+// Turns off everything below the given level ("debug", "info", "warning" or
+// "critical") for all categories, unknown levels count as "info".
+// QT_LOGGING_RULES still overrides this.
+void setLogLevel(const QString &level);
+
+#endif // LOGGING_H
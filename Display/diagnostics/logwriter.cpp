@@ -0,0 +1,289 @@
+#include "logwriter.h"
+#include "logging.h"
+#include <QDateTime>
+#include <QDir>
+#include <QHash>
+#include <chrono>
+
+namespace {
+// Room for a few seconds of a flood, past that messages are dropped and
+// counted instead of waiting for the writer.
+const int QUEUE_CAPACITY = 4096;
+const int WRITE_INTERVAL = 250;
+const qint64 RATE_LIMIT_WINDOW = 60 * 1000;
+const QString LOG_FILE_BASE_NAME = "display";
+
+qint64 getMonotonicTime() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+QByteArray getTypeName(QtMsgType type) {
+  switch (type) {
+  case QtDebugMsg:
+    return "DEBUG";
+  case QtInfoMsg:
+    return "INFO";
+  case QtWarningMsg:
+    return "WARNING";
+  case QtCriticalMsg:
+    return "CRITICAL";
+  case QtFatalMsg:
+    return "FATAL";
+  }
+  return "UNKNOWN";
+}
+
+QByteArray getLogLine(const LogEntry &entry) {
+  QByteArray line = QDateTime::fromMSecsSinceEpoch(entry.loggedAt)
+                        .toString(Qt::ISODateWithMs)
+                        .toUtf8();
+  line += ' ';
+  line += getTypeName(entry.type);
+  line += ' ';
+  line += entry.category;
+  line += ": ";
+  line += entry.message.toUtf8();
+  line += '\n';
+  return line;
+}
+} // namespace
+
+// The bounded queue of Dmitry Vyukov: every slot has a sequence number that
+// tells whether it is free for the push at a position or filled for the pop.
+LogQueue::LogQueue(int capacity)
+    : m_slots(new Slot[capacity]), m_indexMask(capacity - 1),
+      m_pushPosition(0), m_popPosition(0) {
+  Q_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+  for (int index = 0; index < capacity; index++) {
+    m_slots[index].sequence.store(index, std::memory_order_relaxed);
+  }
+}
+
+bool LogQueue::tryPush(LogEntry &&entry) {
+  quint64 position = m_pushPosition.load(std::memory_order_relaxed);
+  while (true) {
+    Slot &slot = m_slots[position & m_indexMask];
+    quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+    qint64 difference = qint64(sequence) - qint64(position);
+    if (difference == 0) {
+      if (m_pushPosition.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+        slot.entry = std::move(entry);
+        slot.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (difference < 0) {
+      return false;
+    } else {
+      position = m_pushPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool LogQueue::tryPop(LogEntry &entry) {
+  quint64 position = m_popPosition.load(std::memory_order_relaxed);
+  Slot &slot = m_slots[position & m_indexMask];
+  quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+  if (qint64(sequence) - qint64(position + 1) < 0) {
+    return false;
+  }
+  m_popPosition.store(position + 1, std::memory_order_relaxed);
+  entry = std::move(slot.entry);
+  slot.entry = LogEntry();
+  slot.sequence.store(position + m_indexMask + 1, std::memory_order_release);
+  return true;
+}
+
+LogRateLimiter::LogRateLimiter(int maxMessagesPerWindow)
+    : m_maxMessagesPerWindow(maxMessagesPerWindow) {}
+
+bool LogRateLimiter::allow(const char *category, QtMsgType type,
+                           int &suppressedCount) {
+  suppressedCount = 0;
+  if (m_maxMessagesPerWindow <= 0 || type == QtFatalMsg) {
+    return true;
+  }
+
+  Bucket &bucket =
+      m_buckets[(qHash(QByteArrayView(category)) ^ uint(type)) % BUCKET_COUNT];
+  qint64 now = getMonotonicTime();
+  qint64 windowStart = bucket.windowStart.load(std::memory_order_relaxed);
+  // Only the thread that moves the window on resets it. Messages counted by
+  // others in the meantime are off by a few, which is fine for a limit.
+  if (now - windowStart >= RATE_LIMIT_WINDOW &&
+      bucket.windowStart.compare_exchange_strong(windowStart, now,
+                                                 std::memory_order_relaxed)) {
+    bucket.messageCount.store(0, std::memory_order_relaxed);
+    suppressedCount =
+        bucket.suppressedCount.exchange(0, std::memory_order_relaxed);
+  }
+
+  if (bucket.messageCount.fetch_add(1, std::memory_order_relaxed) <
+      m_maxMessagesPerWindow) {
+    return true;
+  }
+  bucket.suppressedCount.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+std::atomic<LogWriter *> LogWriter::s_installedWriter(nullptr);
+QtMessageHandler LogWriter::s_previousHandler = nullptr;
+
+LogWriter::LogWriter(const QString &directoryPath, qint64 maxFileSize,
+                     int maxFileCount, int maxMessagesPerMinute,
+                     QObject *parent)
+    : QObject{parent}, m_directoryPath(directoryPath),
+      m_maxFileSize(maxFileSize), m_maxFileCount(qMax(1, maxFileCount)),
+      m_queue(QUEUE_CAPACITY), m_rateLimiter(maxMessagesPerMinute),
+      m_droppedCount(0), m_fileSize(0), m_writeTimer(nullptr) {}
+
+LogWriter::~LogWriter() {
+  if (s_installedWriter.load() == this) {
+    qInstallMessageHandler(s_previousHandler);
+    s_installedWriter.store(nullptr);
+  }
+  writeQueuedEntries();
+}
+
+void LogWriter::install() {
+  s_installedWriter.store(this, std::memory_order_release);
+  s_previousHandler = qInstallMessageHandler(&LogWriter::handleMessage);
+}
+
+void LogWriter::startWriting() {
+  // Created here so the timer lives on the thread this writer was moved to.
+  QDir().mkpath(m_directoryPath);
+  if (!openFile()) {
+    qCWarning(lcDiagnostics) << "Could not open log file" << getFilePath(0);
+  }
+  m_writeTimer = new QTimer(this);
+  connect(m_writeTimer, &QTimer::timeout, this,
+          &LogWriter::writeQueuedEntries);
+  m_writeTimer->start(WRITE_INTERVAL);
+}
+
+void LogWriter::stopWriting() {
+  delete m_writeTimer;
+  m_writeTimer = nullptr;
+}
+
+void LogWriter::handleMessage(QtMsgType type,
+                              const QMessageLogContext &context,
+                              const QString &message) {
+  LogWriter *writer = s_installedWriter.load(std::memory_order_acquire);
+  if (writer) {
+    writer->enqueue(type, context.category, message);
+  }
+  // Debug messages can come by the hundred, writing those to the console
+  // from the GUI thread is exactly what would show in the frame times. A
+  // fatal message aborts before the writer gets to it, so it ends up here.
+  if (s_previousHandler && type != QtDebugMsg) {
+    s_previousHandler(type, context, message);
+  }
+}
+
+void LogWriter::enqueue(QtMsgType type, const char *category,
+                        const QString &message) {
+  const char *categoryName = category ? category : "default";
+  int suppressedCount = 0;
+  bool isAllowed = m_rateLimiter.allow(categoryName, type, suppressedCount);
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  // Reported with the first message of the next window, so a category that
+  // went quiet after a flood keeps its count until it logs again.
+  if (suppressedCount > 0) {
+    LogEntry suppressedEntry;
+    suppressedEntry.loggedAt = now;
+    suppressedEntry.type = type;
+    suppressedEntry.category = categoryName;
+    suppressedEntry.message =
+        QString("Suppressed %1 similar messages in the last minute")
+            .arg(suppressedCount);
+    if (!m_queue.tryPush(std::move(suppressedEntry))) {
+      m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (!isAllowed) {
+    return;
+  }
+
+  LogEntry entry;
+  entry.loggedAt = now;
+  entry.type = type;
+  entry.category = categoryName;
+  entry.message = message;
+  if (!m_queue.tryPush(std::move(entry))) {
+    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void LogWriter::writeQueuedEntries() {
+  // A log directory on a disk that was full or not mounted yet gets another
+  // chance every time, the entries in between are lost.
+  if (!m_file.isOpen()) {
+    openFile();
+  }
+
+  quint64 droppedCount = m_droppedCount.exchange(0, std::memory_order_relaxed);
+  if (droppedCount > 0) {
+    LogEntry droppedEntry;
+    droppedEntry.loggedAt = QDateTime::currentMSecsSinceEpoch();
+    droppedEntry.type = QtWarningMsg;
+    droppedEntry.category = lcDiagnostics().categoryName();
+    droppedEntry.message =
+        QString("Dropped %1 messages, the log queue was full")
+            .arg(droppedCount);
+    writeLine(getLogLine(droppedEntry));
+  }
+
+  LogEntry entry;
+  while (m_queue.tryPop(entry)) {
+    writeLine(getLogLine(entry));
+  }
+  if (m_file.isOpen()) {
+    m_file.flush();
+  }
+}
+
+void LogWriter::writeLine(const QByteArray &line) {
+  if (!m_file.isOpen()) {
+    return;
+  }
+  if (m_fileSize > 0 && m_fileSize + line.size() > m_maxFileSize) {
+    rotateFiles();
+    if (!m_file.isOpen()) {
+      return;
+    }
+  }
+  m_file.write(line);
+  m_fileSize += line.size();
+}
+
+bool LogWriter::openFile() {
+  m_file.setFileName(getFilePath(0));
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    return false;
+  }
+  m_fileSize = m_file.size();
+  return true;
+}
+
+void LogWriter::rotateFiles() {
+  m_file.close();
+  QFile::remove(getFilePath(m_maxFileCount - 1));
+  for (int index = m_maxFileCount - 2; index >= 0; index--) {
+    QFile::rename(getFilePath(index), getFilePath(index + 1));
+  }
+  openFile();
+}
+
+QString LogWriter::getFilePath(int index) const {
+  // display.log is the one being written, display.1.log the one before it.
+  QString fileName = index == 0 ? LOG_FILE_BASE_NAME + ".log"
+                                : QString("%1.%2.log")
+                                      .arg(LOG_FILE_BASE_NAME)
+                                      .arg(index);
+  return QDir(m_directoryPath).filePath(fileName);
+}
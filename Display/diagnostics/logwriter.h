@@ -0,0 +1,104 @@
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+
+struct LogEntry {
+  qint64 loggedAt = 0; // Milliseconds since epoch.
+  QtMsgType type = QtDebugMsg;
+  QByteArray category;
+  QString message;
+};
+
+// Bounded queue that any number of threads can push to without locking, for
+// a single thread to take from. Pushing fails instead of waiting when full.
+class LogQueue {
+public:
+  explicit LogQueue(int capacity);
+  bool tryPush(LogEntry &&entry);
+  bool tryPop(LogEntry &entry);
+
+private:
+  struct Slot {
+    std::atomic<quint64> sequence;
+    LogEntry entry;
+  };
+
+  std::unique_ptr<Slot[]> m_slots;
+  quint64 m_indexMask;
+  std::atomic<quint64> m_pushPosition;
+  std::atomic<quint64> m_popPosition;
+};
+
+// Lets through a fixed number of messages per category and level every
+// window, without locking. Categories share a small fixed table, so two of
+// them can end up sharing a budget.
+class LogRateLimiter {
+public:
+  explicit LogRateLimiter(int maxMessagesPerWindow);
+  // Sets suppressedCount to the messages of this bucket dropped during the
+  // previous window when this one is the first of a new window.
+  bool allow(const char *category, QtMsgType type, int &suppressedCount);
+
+private:
+  static const int BUCKET_COUNT = 64;
+  struct Bucket {
+    std::atomic<qint64> windowStart{0};
+    std::atomic<int> messageCount{0};
+    std::atomic<int> suppressedCount{0};
+  };
+
+  int m_maxMessagesPerWindow;
+  Bucket m_buckets[BUCKET_COUNT];
+};
+
+// Takes over Qt's message handler and writes every message to size-capped
+// rotating files in the given directory. Logging only costs the caller a
+// rate limit check and a push to a queue, the file is written from the
+// thread this writer is moved to. Info and up still go to the previous
+// handler (the console) as well.
+class LogWriter : public QObject {
+  Q_OBJECT
+public:
+  LogWriter(const QString &directoryPath, qint64 maxFileSize,
+            int maxFileCount, int maxMessagesPerMinute,
+            QObject *parent = nullptr);
+  // Puts the previous handler back and writes what is still queued, so only
+  // delete this once its thread has finished.
+  ~LogWriter();
+  void install();
+  void startWriting();
+  // Must run on the writer's thread, which owns the write timer.
+  void stopWriting();
+
+private:
+  static std::atomic<LogWriter *> s_installedWriter;
+  static QtMessageHandler s_previousHandler;
+
+  QString m_directoryPath;
+  qint64 m_maxFileSize;
+  int m_maxFileCount;
+  LogQueue m_queue;
+  LogRateLimiter m_rateLimiter;
+  std::atomic<quint64> m_droppedCount;
+  QFile m_file;
+  qint64 m_fileSize;
+  QTimer *m_writeTimer;
+
+  static void handleMessage(QtMsgType type, const QMessageLogContext &context,
+                            const QString &message);
+  void enqueue(QtMsgType type, const char *category, const QString &message);
+  void writeQueuedEntries();
+  void writeLine(const QByteArray &line);
+  bool openFile();
+  void rotateFiles();
+  QString getFilePath(int index) const;
+};
+
+#endif // LOGWRITER_H
@@ -0,0 +1,57 @@
+#include "metricshistogram.h"
+
+MetricsHistogram::MetricsHistogram(const QList<double> &bucketBounds)
+    : m_bucketBounds(bucketBounds),
+      m_bucketCounts(new std::atomic<quint64>[bucketBounds.size() + 1]),
+      m_count(0), m_sumInMicroseconds(0) {
+  for (int i = 0; i <= m_bucketBounds.size(); i++) {
+    m_bucketCounts[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void MetricsHistogram::observe(double value) {
+  int bucketIndex = 0;
+  while (bucketIndex < m_bucketBounds.size() &&
+         value > m_bucketBounds[bucketIndex]) {
+    bucketIndex++;
+  }
+
+  m_bucketCounts[bucketIndex].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sumInMicroseconds.fetch_add(static_cast<quint64>(value * 1000000.0),
+                                std::memory_order_relaxed);
+}
+
+quint64 MetricsHistogram::count() const {
+  return m_count.load(std::memory_order_relaxed);
+}
+
+double MetricsHistogram::sum() const {
+  return m_sumInMicroseconds.load(std::memory_order_relaxed) / 1000000.0;
+}
+
+QByteArray MetricsHistogram::toPrometheusText(const QByteArray &name,
+                                              const QByteArray &help) const {
+  QByteArray text = "# HELP " + name + " " + help + "\n";
+  text += "# TYPE " + name + " histogram\n";
+
+  // Prometheus buckets are cumulative, ours are not.
+  quint64 cumulativeCount = 0;
+  for (int i = 0; i < m_bucketBounds.size(); i++) {
+    cumulativeCount += m_bucketCounts[i].load(std::memory_order_relaxed);
+    text += name + "_bucket{le=\"" +
+            QByteArray::number(m_bucketBounds[i], 'g', 6) + "\"} " +
+            QByteArray::number(cumulativeCount) + "\n";
+  }
+  cumulativeCount +=
+      m_bucketCounts[m_bucketBounds.size()].load(std::memory_order_relaxed);
+  text += name + "_bucket{le=\"+Inf\"} " + QByteArray::number(cumulativeCount) +
+          "\n";
+  text += name + "_sum " +
+          QByteArray::number(
+              m_sumInMicroseconds.load(std::memory_order_relaxed) / 1000000.0,
+              'f', 6) +
+          "\n";
+  text += name + "_count " + QByteArray::number(cumulativeCount) + "\n";
+  return text;
+}
@@ -0,0 +1,27 @@
+#ifndef METRICSHISTOGRAM_H
+#define METRICSHISTOGRAM_H
+
+#include <QByteArray>
+#include <QList>
+#include <atomic>
+#include <memory>
+
+// Fixed-bucket histogram that can be observed from any thread without
+// locking. Values are in seconds, the way Prometheus expects them.
+class MetricsHistogram {
+public:
+  explicit MetricsHistogram(const QList<double> &bucketBounds);
+  void observe(double value);
+  quint64 count() const;
+  double sum() const;
+  QByteArray toPrometheusText(const QByteArray &name,
+                              const QByteArray &help) const;
+
+private:
+  QList<double> m_bucketBounds;
+  std::unique_ptr<std::atomic<quint64>[]> m_bucketCounts;
+  std::atomic<quint64> m_count;
+  std::atomic<quint64> m_sumInMicroseconds;
+};
+
+#endif // METRICSHISTOGRAM_H
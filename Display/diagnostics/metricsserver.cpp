@@ -0,0 +1,37 @@
+#include "metricsserver.h"
+#include "logging.h"
+#include <QTcpSocket>
+#include <QUrlQuery>
+
+MetricsServer::MetricsServer(DisplayMetrics *displayMetrics,
+                             OccupancyHistory *occupancyHistory, quint16 port,
+                             QObject *parent)
+    : QObject{parent}, m_displayMetrics(displayMetrics),
+      m_occupancyHistory(occupancyHistory), m_port(port),
+      m_httpServer(nullptr) {}
+
+void MetricsServer::startListening() {
+  m_httpServer = new LocalHttpServer(this);
+  m_httpServer->addRoute("/metrics", [this](QTcpSocket *socket,
+                                             const LocalHttpServer::Request &) {
+    LocalHttpServer::sendResponse(socket, 200,
+                                  "text/plain; version=0.0.4; charset=utf-8",
+                                  m_displayMetrics->toPrometheusText());
+  });
+  if (m_occupancyHistory) {
+    m_httpServer->addRoute(
+        "/occupancy",
+        [this](QTcpSocket *socket, const LocalHttpServer::Request &request) {
+          qint64 since =
+              QUrlQuery(request.url).queryItemValue("since").toLongLong();
+          LocalHttpServer::sendResponse(socket, 200,
+                                        "text/csv; charset=utf-8",
+                                        m_occupancyHistory->toCsv(since));
+        });
+  }
+
+  if (!m_httpServer->listen(m_port)) {
+    qCWarning(lcDiagnostics) << "Could not start metrics endpoint on port"
+                             << m_port;
+  }
+}
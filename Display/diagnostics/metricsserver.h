@@ -0,0 +1,28 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include "../network/localhttpserver.h"
+#include "displaymetrics.h"
+#include "occupancyhistory.h"
+#include <QObject>
+
+// Serves the DisplayMetrics in Prometheus text format on /metrics and the
+// occupancy history as CSV on /occupancy (optionally ?since=<unix seconds>).
+// Meant to be moved to the data fetching thread so scrapes never touch the
+// GUI thread.
+class MetricsServer : public QObject {
+  Q_OBJECT
+public:
+  MetricsServer(DisplayMetrics *displayMetrics,
+                OccupancyHistory *occupancyHistory, quint16 port,
+                QObject *parent = nullptr);
+  void startListening();
+
+private:
+  DisplayMetrics *m_displayMetrics;
+  OccupancyHistory *m_occupancyHistory;
+  quint16 m_port;
+  LocalHttpServer *m_httpServer;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,186 @@
+#include "occupancyhistory.h"
+#include "logging.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace {
+const quint32 OCCUPANCY_HISTORY_MAGIC = 0x52424f31; // "RBO1"
+const QDataStream::Version OCCUPANCY_HISTORY_STREAM_VERSION =
+    QDataStream::Qt_6_0;
+const int PERSIST_INTERVAL = 5 * 60 * 1000;
+} // namespace
+
+OccupancyHistory::OccupancyHistory(const QString &filePath, QObject *parent)
+    : QObject{parent}, m_records(), m_firstIndex(0), m_count(0),
+      m_firstChangedAt(0), m_lastChangedAt(0), m_hasUnsavedRecords(false),
+      m_filePath(filePath), m_persistTimer(nullptr) {
+  load();
+}
+
+OccupancyHistory::~OccupancyHistory() { save(); }
+
+void OccupancyHistory::startPersisting() {
+  // Created here so the timer lives on the thread this history was moved to.
+  m_persistTimer = new QTimer(this);
+  connect(m_persistTimer, &QTimer::timeout, this, &OccupancyHistory::save);
+  m_persistTimer->start(PERSIST_INTERVAL);
+}
+
+void OccupancyHistory::record(qint64 changedAt,
+                              const CurrentBookingData &currentBooking) {
+  OccupancyRecord newRecord;
+  newRecord.changedAt = changedAt;
+  newRecord.state = currentBooking.state;
+  // Backend booking IDs are positive integers, anything else (unbooked, an
+  // error) is stored as 0.
+  newRecord.bookingId = currentBooking.id.toInt();
+
+  if (m_count > 0) {
+    const PackedRecord &lastRecord =
+        m_records[(m_firstIndex + m_count - 1) % CAPACITY];
+    if (lastRecord.state == static_cast<quint8>(newRecord.state) &&
+        lastRecord.bookingId == newRecord.bookingId) {
+      return;
+    }
+  }
+  append(newRecord);
+  m_hasUnsavedRecords = true;
+}
+
+void OccupancyHistory::append(const OccupancyRecord &record) {
+  // Deltas can't be negative, so a clock that jumped back is treated as if
+  // the change happened at the same time as the previous one.
+  qint64 changedAt = m_count > 0 ? qMax(record.changedAt, m_lastChangedAt)
+                                 : record.changedAt;
+
+  if (m_count == CAPACITY) {
+    m_firstIndex = (m_firstIndex + 1) % CAPACITY;
+    m_count--;
+    m_firstChangedAt += m_records[m_firstIndex].secondsSincePrevious;
+  }
+  if (m_count == 0) {
+    m_firstChangedAt = changedAt;
+  }
+
+  PackedRecord &packedRecord = m_records[(m_firstIndex + m_count) % CAPACITY];
+  packedRecord.secondsSincePrevious =
+      m_count > 0 ? static_cast<quint32>(changedAt - m_lastChangedAt) : 0;
+  packedRecord.bookingId = record.bookingId;
+  packedRecord.state = static_cast<quint8>(record.state);
+  m_count++;
+  m_lastChangedAt = changedAt;
+}
+
+QList<OccupancyRecord> OccupancyHistory::records(qint64 since) const {
+  QList<OccupancyRecord> unpackedRecords;
+  qint64 changedAt = m_firstChangedAt;
+  for (int offset = 0; offset < m_count; offset++) {
+    const PackedRecord &packedRecord =
+        m_records[(m_firstIndex + offset) % CAPACITY];
+    if (offset > 0) {
+      changedAt += packedRecord.secondsSincePrevious;
+    }
+    if (changedAt < since) {
+      continue;
+    }
+
+    OccupancyRecord record;
+    record.changedAt = changedAt;
+    record.state = static_cast<CurrentBookingState>(packedRecord.state);
+    record.bookingId = packedRecord.bookingId;
+    unpackedRecords.append(record);
+  }
+  return unpackedRecords;
+}
+
+QByteArray OccupancyHistory::toCsv(qint64 since) const {
+  QByteArray csv = "changed_at,state,booking_id\n";
+  const QList<OccupancyRecord> exportedRecords = records(since);
+  for (const OccupancyRecord &record : exportedRecords) {
+    QByteArray stateName = "error";
+    if (record.state == CurrentBookingState::UNBOOKED) {
+      stateName = "unbooked";
+    } else if (record.state == CurrentBookingState::BOOKED) {
+      stateName = "booked";
+    }
+    csv += QByteArray::number(record.changedAt) + "," + stateName + "," +
+           QByteArray::number(record.bookingId) + "\n";
+  }
+  return csv;
+}
+
+void OccupancyHistory::load() {
+  if (m_filePath.isEmpty() || !QFile::exists(m_filePath)) {
+    return;
+  }
+
+  QFile file(m_filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qCWarning(lcDiagnostics) << "Could not open occupancy history"
+                             << m_filePath;
+    return;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(OCCUPANCY_HISTORY_STREAM_VERSION);
+
+  quint32 magic = 0;
+  qint32 count = 0;
+  qint64 changedAt = 0;
+  stream >> magic >> count >> changedAt;
+  if (magic != OCCUPANCY_HISTORY_MAGIC || count < 0) {
+    qCWarning(lcDiagnostics) << m_filePath << "is not an occupancy history";
+    return;
+  }
+
+  for (qint32 index = 0; index < count; index++) {
+    quint32 secondsSincePrevious = 0;
+    OccupancyRecord record;
+    quint8 state = 0;
+    stream >> secondsSincePrevious >> record.bookingId >> state;
+    if (stream.status() != QDataStream::Ok) {
+      qCWarning(lcDiagnostics)
+          << "Occupancy history" << m_filePath << "is cut off";
+      break;
+    }
+    changedAt += index > 0 ? secondsSincePrevious : 0;
+    record.changedAt = changedAt;
+    record.state = static_cast<CurrentBookingState>(state);
+    append(record);
+  }
+}
+
+void OccupancyHistory::save() {
+  if (m_filePath.isEmpty() || !m_hasUnsavedRecords) {
+    return;
+  }
+
+  QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+  // Written to a temporary file first, so a power cut while saving can't
+  // leave a half written history behind.
+  QSaveFile file(m_filePath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qCWarning(lcDiagnostics) << "Could not save occupancy history to"
+                             << m_filePath;
+    return;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(OCCUPANCY_HISTORY_STREAM_VERSION);
+  stream << OCCUPANCY_HISTORY_MAGIC << static_cast<qint32>(m_count)
+         << m_firstChangedAt;
+  for (int offset = 0; offset < m_count; offset++) {
+    const PackedRecord &packedRecord =
+        m_records[(m_firstIndex + offset) % CAPACITY];
+    stream << packedRecord.secondsSincePrevious << packedRecord.bookingId
+           << packedRecord.state;
+  }
+
+  if (file.commit()) {
+    m_hasUnsavedRecords = false;
+  } else {
+    qCWarning(lcDiagnostics) << "Could not save occupancy history to"
+                             << m_filePath;
+  }
+}
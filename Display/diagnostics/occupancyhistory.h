@@ -0,0 +1,59 @@
+#ifndef OCCUPANCYHISTORY_H
+#define OCCUPANCYHISTORY_H
+
+#include "../datatypes.h"
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <array>
+
+struct OccupancyRecord {
+  qint64 changedAt = 0; // Seconds since epoch.
+  CurrentBookingState state = CurrentBookingState::ERROR;
+  qint32 bookingId = 0; // 0 when unbooked or unknown.
+};
+
+// The last state changes of the room, for utilization stats that don't need
+// the backend. Records are delta encoded into a fixed size ring buffer, so
+// memory use stays the same however long the display runs, and the oldest
+// ones are dropped once it is full. Saved to a small file every few minutes
+// and on exit. Lives on the data fetching thread, shared by the handler that
+// records and the metrics server that exports.
+class OccupancyHistory : public QObject {
+  Q_OBJECT
+public:
+  explicit OccupancyHistory(const QString &filePath, QObject *parent = nullptr);
+  ~OccupancyHistory();
+
+  void startPersisting();
+  void record(qint64 changedAt, const CurrentBookingData &currentBooking);
+  QList<OccupancyRecord> records(qint64 since = 0) const;
+  // One "changed_at,state,booking_id" line per record, oldest first.
+  QByteArray toCsv(qint64 since = 0) const;
+
+private:
+  static const int CAPACITY = 8192;
+
+  struct PackedRecord {
+    quint32 secondsSincePrevious;
+    qint32 bookingId;
+    quint8 state;
+  };
+
+  std::array<PackedRecord, CAPACITY> m_records;
+  int m_firstIndex;
+  int m_count;
+  qint64 m_firstChangedAt;
+  qint64 m_lastChangedAt;
+  bool m_hasUnsavedRecords;
+  QString m_filePath;
+  QTimer *m_persistTimer;
+
+  void append(const OccupancyRecord &record);
+  void load();
+  void save();
+};
+
+#endif // OCCUPANCYHISTORY_H
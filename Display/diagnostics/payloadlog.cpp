@@ -0,0 +1,85 @@
+#include "payloadlog.h"
+#include "logging.h"
+
+namespace {
+const quint32 PAYLOAD_LOG_MAGIC = 0x52425031; // "RBP1"
+const QDataStream::Version PAYLOAD_LOG_STREAM_VERSION = QDataStream::Qt_6_0;
+
+enum class RecordType : quint8 { FULL_BODY = 0, SAME_BODY = 1 };
+} // namespace
+
+PayloadLogWriter::PayloadLogWriter(const QString &filePath)
+    : m_file(filePath) {
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qCWarning(lcDiagnostics) << "Could not open payload log" << filePath
+                             << "for writing";
+    return;
+  }
+  m_stream.setDevice(&m_file);
+  m_stream.setVersion(PAYLOAD_LOG_STREAM_VERSION);
+  if (m_file.size() == 0) {
+    m_stream << PAYLOAD_LOG_MAGIC;
+  }
+}
+
+bool PayloadLogWriter::isOpen() const { return m_file.isOpen(); }
+
+void PayloadLogWriter::append(const RecordedPayload &payload) {
+  if (!isOpen()) {
+    return;
+  }
+
+  // The first record after opening always has its body, so appending to an
+  // existing log never depends on what was written before.
+  bool sameBody = !m_previousBody.isNull() && payload.body == m_previousBody;
+  m_stream << static_cast<quint8>(sameBody ? RecordType::SAME_BODY
+                                           : RecordType::FULL_BODY)
+           << payload.receivedAt << static_cast<qint32>(payload.networkError)
+           << static_cast<qint32>(payload.httpStatusCode);
+  if (!sameBody) {
+    m_stream << payload.body;
+    m_previousBody = payload.body.isNull() ? QByteArray("") : payload.body;
+  }
+  m_file.flush();
+}
+
+PayloadLogReader::PayloadLogReader(const QString &filePath)
+    : m_file(filePath) {
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    qCWarning(lcDiagnostics) << "Could not open payload log" << filePath;
+    return;
+  }
+  m_stream.setDevice(&m_file);
+  m_stream.setVersion(PAYLOAD_LOG_STREAM_VERSION);
+
+  quint32 magic = 0;
+  m_stream >> magic;
+  if (magic != PAYLOAD_LOG_MAGIC) {
+    qCWarning(lcDiagnostics) << filePath << "is not a payload log";
+    m_file.close();
+  }
+}
+
+bool PayloadLogReader::isOpen() const { return m_file.isOpen(); }
+
+bool PayloadLogReader::readNext(RecordedPayload &payload) {
+  if (!isOpen() || m_stream.atEnd()) {
+    return false;
+  }
+
+  quint8 recordType = 0;
+  qint32 networkError = 0;
+  qint32 httpStatusCode = 0;
+  m_stream >> recordType >> payload.receivedAt >> networkError >>
+      httpStatusCode;
+  if (recordType == static_cast<quint8>(RecordType::SAME_BODY)) {
+    payload.body = m_previousBody;
+  } else {
+    m_stream >> payload.body;
+    m_previousBody = payload.body;
+  }
+  payload.networkError = networkError;
+  payload.httpStatusCode = httpStatusCode;
+
+  return m_stream.status() == QDataStream::Ok;
+}
@@ -0,0 +1,44 @@
+#ifndef PAYLOADLOG_H
+#define PAYLOADLOG_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QString>
+
+struct RecordedPayload {
+  qint64 receivedAt = 0; // Milliseconds since epoch.
+  int networkError = 0;  // QNetworkReply::NetworkError
+  int httpStatusCode = 0;
+  QByteArray body;
+};
+
+// Append-only binary log of backend replies, used to reproduce what a display
+// did in production. Polls mostly return the same bytes as the previous one,
+// so those records leave the body out and only cost a few bytes each.
+class PayloadLogWriter {
+public:
+  explicit PayloadLogWriter(const QString &filePath);
+  bool isOpen() const;
+  void append(const RecordedPayload &payload);
+
+private:
+  QFile m_file;
+  QDataStream m_stream;
+  QByteArray m_previousBody;
+};
+
+class PayloadLogReader {
+public:
+  explicit PayloadLogReader(const QString &filePath);
+  bool isOpen() const;
+  // False at the end of the log, or at a record cut off by a crash.
+  bool readNext(RecordedPayload &payload);
+
+private:
+  QFile m_file;
+  QDataStream m_stream;
+  QByteArray m_previousBody;
+};
+
+#endif // PAYLOADLOG_H
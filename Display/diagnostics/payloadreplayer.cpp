@@ -0,0 +1,47 @@
+#include "payloadreplayer.h"
+#include "logging.h"
+
+PayloadReplayer::PayloadReplayer(const QString &filePath, const Clock *clock,
+                                 QObject *parent)
+    : QObject{parent}, m_filePath(filePath), m_clock(clock),
+      m_logReader(nullptr), m_replayTimer(nullptr), m_replayedPayloads(0) {}
+
+PayloadReplayer::~PayloadReplayer() { delete m_logReader; }
+
+qint64 PayloadReplayer::getFirstPayloadTime(const QString &filePath) {
+  PayloadLogReader logReader(filePath);
+  RecordedPayload firstPayload;
+  return logReader.readNext(firstPayload) ? firstPayload.receivedAt : 0;
+}
+
+void PayloadReplayer::startReplaying() {
+  m_logReader = new PayloadLogReader(m_filePath);
+  m_replayTimer = new QTimer(this);
+  m_replayTimer->setSingleShot(true);
+  m_replayTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_replayTimer, &QTimer::timeout, this,
+          &PayloadReplayer::replayNextPayload);
+
+  if (!m_logReader->readNext(m_nextPayload)) {
+    qCWarning(lcDiagnostics) << "Nothing to replay in" << m_filePath;
+    return;
+  }
+  qCInfo(lcDiagnostics) << "Replaying" << m_filePath;
+  replayNextPayload();
+}
+
+void PayloadReplayer::replayNextPayload() {
+  RecordedPayload payload = m_nextPayload;
+  emit payloadReplayed(payload);
+  m_replayedPayloads++;
+
+  if (!m_logReader->readNext(m_nextPayload)) {
+    qCInfo(lcDiagnostics) << "Replay finished after" << m_replayedPayloads
+                          << "payloads";
+    return;
+  }
+
+  qint64 recordedGap = qMax<qint64>(0, m_nextPayload.receivedAt -
+                                           payload.receivedAt);
+  m_replayTimer->start(m_clock->toWallClockInterval(recordedGap));
+}
@@ -0,0 +1,36 @@
+#ifndef PAYLOADREPLAYER_H
+#define PAYLOADREPLAYER_H
+
+#include "../timing/clock.h"
+#include "payloadlog.h"
+#include <QObject>
+#include <QTimer>
+
+// Feeds a recorded payload log back into the DataFetchingHandler with the
+// original spacing between replies in clock time, so a simulated clock started
+// at the first reply sets the playback speed. Takes the place of the network
+// polling, so it lives on the data fetching thread.
+class PayloadReplayer : public QObject {
+  Q_OBJECT
+public:
+  explicit PayloadReplayer(const QString &filePath, const Clock *clock,
+                           QObject *parent = nullptr);
+  static qint64 getFirstPayloadTime(const QString &filePath);
+  ~PayloadReplayer();
+  void startReplaying();
+
+signals:
+  void payloadReplayed(const RecordedPayload &payload);
+
+private:
+  QString m_filePath;
+  const Clock *m_clock;
+  PayloadLogReader *m_logReader;
+  QTimer *m_replayTimer;
+  RecordedPayload m_nextPayload;
+  int m_replayedPayloads;
+
+  void replayNextPayload();
+};
+
+#endif // PAYLOADREPLAYER_H
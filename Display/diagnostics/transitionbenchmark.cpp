@@ -0,0 +1,110 @@
+#include "transitionbenchmark.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QTimer>
+
+namespace {
+// Long enough for the slowest transition (upcoming fade plus the delayed
+// current booking fade) to fully finish before the next one starts.
+const int TRANSITION_INTERVAL = 5000;
+} // namespace
+
+TransitionBenchmark::TransitionBenchmark(int transitionCount,
+                                         DisplayMetrics *displayMetrics,
+                                         EventLoopMonitor *eventLoopMonitor,
+                                         QObject *parent)
+    : QObject{parent}, m_transitionCount(transitionCount),
+      m_playedTransitions(0), m_worstTransitionStall(0),
+      m_displayMetrics(displayMetrics), m_eventLoopMonitor(eventLoopMonitor) {
+  connect(m_eventLoopMonitor, &EventLoopMonitor::transitionStallMeasured, this,
+          [this](qint64 maxStall) {
+            m_worstTransitionStall = qMax(m_worstTransitionStall, maxStall);
+          });
+}
+
+void TransitionBenchmark::start() {
+  QTimer::singleShot(TRANSITION_INTERVAL, this,
+                     &TransitionBenchmark::playNextTransition);
+}
+
+void TransitionBenchmark::playNextTransition() {
+  if (m_playedTransitions == m_transitionCount) {
+    printResults();
+    QCoreApplication::quit();
+    return;
+  }
+
+  // Cycles through unbooked -> booked (first upcoming booking starts) ->
+  // error, which covers every animation the frontends have.
+  int step = m_playedTransitions % 3;
+  CurrentBookingData currentBooking;
+  CurrentBookingData nextBooking;
+  QList<UpcomingBookingData> upcomingBookings;
+
+  if (step == 0) {
+    currentBooking.state = CurrentBookingState::UNBOOKED;
+    currentBooking.name = "Benchmark room";
+    currentBooking.info = "Bookable through Slack";
+    currentBooking.status = "Free";
+    upcomingBookings = {getUpcomingBooking(1), getUpcomingBooking(2),
+                        getUpcomingBooking(3)};
+    // Announced like the backend would, so the booked texts get prerendered.
+    nextBooking = getStartedBooking();
+    nextBooking.startTime =
+        QDateTime::currentSecsSinceEpoch() + TRANSITION_INTERVAL / 1000;
+  } else if (step == 1) {
+    currentBooking = getStartedBooking();
+    upcomingBookings = {getUpcomingBooking(2), getUpcomingBooking(3),
+                        UpcomingBookingData()};
+  } else {
+    currentBooking.state = CurrentBookingState::ERROR;
+    currentBooking.id = "error";
+    currentBooking.name = "Connection problem!";
+    currentBooking.info = "Is the backend running properly?";
+    currentBooking.status = "???";
+    upcomingBookings = {UpcomingBookingData(), UpcomingBookingData(),
+                        UpcomingBookingData()};
+  }
+
+  m_playedTransitions++;
+  emit displayStateChanged(DisplayState(m_playedTransitions, currentBooking,
+                                        upcomingBookings, true, true,
+                                        nextBooking));
+  QTimer::singleShot(TRANSITION_INTERVAL, this,
+                     &TransitionBenchmark::playNextTransition);
+}
+
+void TransitionBenchmark::printResults() {
+  quint64 frameCount = m_displayMetrics->frameCount();
+  double meanFrameTime =
+      frameCount > 0 ? m_displayMetrics->totalFrameTime() / frameCount : 0.0;
+
+  qInfo().noquote() << QString("Transitions played: %1").arg(m_playedTransitions);
+  qInfo().noquote() << QString("Frames rendered: %1").arg(frameCount);
+  qInfo().noquote()
+      << QString("Mean frame time: %1 ms").arg(meanFrameTime * 1000.0, 0, 'f', 3);
+  qInfo().noquote()
+      << QString("Worst event loop stall during a transition: %1 ms")
+             .arg(m_worstTransitionStall);
+}
+
+CurrentBookingData TransitionBenchmark::getStartedBooking() {
+  UpcomingBookingData startedBooking = getUpcomingBooking(1);
+  CurrentBookingData currentBooking;
+  currentBooking.state = CurrentBookingState::BOOKED;
+  currentBooking.id = startedBooking.id;
+  currentBooking.name = startedBooking.name;
+  currentBooking.info = "Booked by Benchmark User";
+  currentBooking.status = startedBooking.timeString;
+  return currentBooking;
+}
+
+UpcomingBookingData TransitionBenchmark::getUpcomingBooking(int index) {
+  UpcomingBookingData upcomingBooking;
+  upcomingBooking.id = QString::number(index);
+  upcomingBooking.name = QString("Benchmark meeting %1").arg(index);
+  upcomingBooking.timeString =
+      QString("%1:00 - %1:30").arg(9 + index, 2, 10, QChar('0'));
+  return upcomingBooking;
+}
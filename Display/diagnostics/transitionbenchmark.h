@@ -0,0 +1,38 @@
+#ifndef TRANSITIONBENCHMARK_H
+#define TRANSITIONBENCHMARK_H
+
+#include "../datatypes.h"
+#include "displaymetrics.h"
+#include "eventloopmonitor.h"
+#include <QList>
+#include <QObject>
+
+// Plays a fixed cycle of booking changes instead of fetching real data, so
+// both frontends can be compared on exactly the same transitions. Prints the
+// frame and event loop numbers and quits once all transitions have played.
+class TransitionBenchmark : public QObject {
+  Q_OBJECT
+public:
+  explicit TransitionBenchmark(int transitionCount,
+                               DisplayMetrics *displayMetrics,
+                               EventLoopMonitor *eventLoopMonitor,
+                               QObject *parent = nullptr);
+  void start();
+
+signals:
+  void displayStateChanged(const DisplayState &displayState);
+
+private:
+  int m_transitionCount;
+  int m_playedTransitions;
+  qint64 m_worstTransitionStall;
+  DisplayMetrics *m_displayMetrics;
+  EventLoopMonitor *m_eventLoopMonitor;
+
+  void playNextTransition();
+  void printResults();
+  static CurrentBookingData getStartedBooking();
+  static UpcomingBookingData getUpcomingBooking(int index);
+};
+
+#endif // TRANSITIONBENCHMARK_H
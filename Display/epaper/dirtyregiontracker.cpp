@@ -0,0 +1,109 @@
+#include "dirtyregiontracker.h"
+#include <cstring>
+
+DirtyRegionTracker::DirtyRegionTracker(int tileSize,
+                                       qint64 refreshOverheadPixels)
+    : m_tileSize(tileSize), m_refreshOverheadPixels(refreshOverheadPixels) {}
+
+QList<QRect> DirtyRegionTracker::getDirtyRegions(const QImage &previousFrame,
+                                                 const QImage &frame) const {
+  if (previousFrame.size() != frame.size() ||
+      previousFrame.format() != frame.format()) {
+    return {frame.rect()};
+  }
+  return mergeNearby(mergeVertically(getDirtyRuns(previousFrame, frame)));
+}
+
+bool DirtyRegionTracker::isTileDirty(const QImage &previousFrame,
+                                     const QImage &frame,
+                                     const QRect &tile) const {
+  const int bytesPerPixel = frame.depth() / 8;
+  const int offset = tile.left() * bytesPerPixel;
+  const size_t length = size_t(tile.width()) * bytesPerPixel;
+  for (int y = tile.top(); y <= tile.bottom(); y++) {
+    if (std::memcmp(previousFrame.constScanLine(y) + offset,
+                    frame.constScanLine(y) + offset, length) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Every row of tiles becomes a list of runs of dirty tiles next to each
+// other, in the order they appear on the panel.
+QList<QRect> DirtyRegionTracker::getDirtyRuns(const QImage &previousFrame,
+                                              const QImage &frame) const {
+  QList<QRect> runs;
+  const QRect frameRectangle = frame.rect();
+  for (int y = 0; y < frame.height(); y += m_tileSize) {
+    int runStart = -1;
+    for (int x = 0; x < frame.width(); x += m_tileSize) {
+      QRect tile =
+          QRect(x, y, m_tileSize, m_tileSize).intersected(frameRectangle);
+      if (isTileDirty(previousFrame, frame, tile)) {
+        if (runStart < 0) {
+          runStart = x;
+        }
+      } else if (runStart >= 0) {
+        runs.append(QRect(runStart, y, x - runStart, m_tileSize)
+                        .intersected(frameRectangle));
+        runStart = -1;
+      }
+    }
+    if (runStart >= 0) {
+      runs.append(QRect(runStart, y, frame.width() - runStart, m_tileSize)
+                      .intersected(frameRectangle));
+    }
+  }
+  return runs;
+}
+
+// Runs spanning the same columns in consecutive rows of tiles, like a line of
+// text that changed, become a single region.
+QList<QRect> DirtyRegionTracker::mergeVertically(const QList<QRect> &runs) {
+  QList<QRect> regions;
+  for (const QRect &run : runs) {
+    bool isMerged = false;
+    for (QRect &region : regions) {
+      if (region.left() == run.left() && region.right() == run.right() &&
+          region.bottom() + 1 == run.top()) {
+        region.setBottom(run.bottom());
+        isMerged = true;
+        break;
+      }
+    }
+    if (!isMerged) {
+      regions.append(run);
+    }
+  }
+  return regions;
+}
+
+// Every partial refresh has a fixed cost on top of the pixels it covers, so
+// two regions are refreshed as their bounding rectangle when the pixels that
+// adds in between cost less than that. There are a handful of regions per
+// frame at most, so trying every pair until nothing merges is cheap enough.
+QList<QRect> DirtyRegionTracker::mergeNearby(QList<QRect> regions) const {
+  auto getArea = [](const QRect &rectangle) {
+    return qint64(rectangle.width()) * rectangle.height();
+  };
+
+  bool hasMerged = true;
+  while (hasMerged) {
+    hasMerged = false;
+    for (int first = 0; first < regions.size() && !hasMerged; first++) {
+      for (int second = first + 1; second < regions.size(); second++) {
+        QRect united = regions[first].united(regions[second]);
+        if (getArea(united) <= getArea(regions[first]) +
+                                   getArea(regions[second]) +
+                                   m_refreshOverheadPixels) {
+          regions[first] = united;
+          regions.removeAt(second);
+          hasMerged = true;
+          break;
+        }
+      }
+    }
+  }
+  return regions;
+}
@@ -0,0 +1,32 @@
+#ifndef DIRTYREGIONTRACKER_H
+#define DIRTYREGIONTRACKER_H
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+
+// Finds the regions that differ between two frames of the same size, as a
+// small set of rectangles for partial panel refreshes. Frames are compared
+// in square tiles, so every region starts on a multiple of the tile size,
+// which has to be a multiple of the alignment the panel controller needs.
+// Nearby regions are merged when refreshing the pixels in between costs less
+// than the overhead of another refresh.
+class DirtyRegionTracker {
+public:
+  DirtyRegionTracker(int tileSize, qint64 refreshOverheadPixels);
+  QList<QRect> getDirtyRegions(const QImage &previousFrame,
+                               const QImage &frame) const;
+
+private:
+  int m_tileSize;
+  qint64 m_refreshOverheadPixels;
+
+  bool isTileDirty(const QImage &previousFrame, const QImage &frame,
+                   const QRect &tile) const;
+  QList<QRect> getDirtyRuns(const QImage &previousFrame,
+                            const QImage &frame) const;
+  static QList<QRect> mergeVertically(const QList<QRect> &runs);
+  QList<QRect> mergeNearby(QList<QRect> regions) const;
+};
+
+#endif // DIRTYREGIONTRACKER_H
@@ -0,0 +1,285 @@
+#include "epaperfrontend.h"
+#include "../assets/fontfallbackcache.h"
+#include "../diagnostics/logging.h"
+#include "../settingstrings.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QSettings>
+
+namespace {
+// Changes within this long of each other end up in the same refresh, so a
+// booking starting shows its new name and upcoming list in one go.
+const int REFRESH_DELAY = 1000;
+// Panel controllers want regions on multiples of 8 pixels, tiles of 16 keep
+// the comparison cheap on top of that.
+const int TILE_SIZE = 16;
+// What a partial refresh costs on top of its pixels, in pixels.
+const qint64 REFRESH_OVERHEAD_PIXELS = 64 * 64;
+// Past this share of the panel a full refresh is as fast and also clears the
+// ghosting the partial ones leave behind.
+const double FULL_REFRESH_AREA_RATIO = 0.5;
+// The widget layout is designed for 1080 pixels high.
+const double DESIGN_HEIGHT = 1080.0;
+} // namespace
+
+EpaperFrontend::EpaperFrontend(EpaperSink *sink,
+                               DisplayMetrics *displayMetrics,
+                               const Clock *clock, QObject *parent)
+    : QObject{parent}, m_sink(sink), m_displayMetrics(displayMetrics),
+      m_clock(clock),
+      m_dirtyRegionTracker(TILE_SIZE, REFRESH_OVERHEAD_PIXELS),
+      m_refreshTimer(new QTimer(this)), m_partialRefreshCount(0),
+      m_pixelsRefreshedToday(0) {
+  retrieveSettings();
+
+  QSettings settings;
+  CurrentBookingData unbookedBooking;
+  unbookedBooking.state = CurrentBookingState::UNBOOKED;
+  unbookedBooking.name = settings.value(UNBOOKED_NAME_TEXT_SETTING).toString();
+  unbookedBooking.info = settings.value(UNBOOKED_INFO_TEXT_SETTING).toString();
+  unbookedBooking.status =
+      settings.value(UNBOOKED_STATUS_TEXT_SETTING).toString();
+  m_displayState = DisplayState(0, unbookedBooking, {}, false, false);
+
+  m_refreshTimer->setSingleShot(true);
+  m_refreshTimer->setInterval(REFRESH_DELAY);
+  connect(m_refreshTimer, &QTimer::timeout, this,
+          &EpaperFrontend::refreshPanel);
+  m_refreshTimer->start();
+}
+
+void EpaperFrontend::retrieveSettings() {
+  QSettings settings;
+  m_panelSize = QSize(settings.value(EPAPER_WIDTH_SETTING).toInt(),
+                      settings.value(EPAPER_HEIGHT_SETTING).toInt());
+  m_greyLevels =
+      qBound(2, settings.value(EPAPER_GREY_LEVELS_SETTING).toInt(), 256);
+  m_fullRefreshAfterPartials =
+      settings.value(EPAPER_FULL_REFRESH_AFTER_SETTING).toInt();
+
+  m_nameFont = getScaledFont(
+      settings.value(BOOKNG_NAME_FONT_SETTING).value<QFont>());
+  m_infoFont = getScaledFont(
+      settings.value(BOOKING_INFO_FONT_SETTING).value<QFont>());
+  m_statusFont = getScaledFont(
+      settings.value(BOOKING_STATUS_FONT_SETTING).value<QFont>());
+  m_upcomingBoldFont = getScaledFont(
+      settings.value(UPCOMING_BOOKINGS_BOLD_FONT_SETTING).value<QFont>());
+  m_upcomingLightFont = getScaledFont(
+      settings.value(UPCOMING_BOOKINGS_LIGHT_FONT_SETTING).value<QFont>());
+
+  m_nameMaxCharacters = settings.value(BOOKING_NAME_MAX_CHARACTERS).toInt();
+  m_infoMaxCharacters =
+      settings.value(BOOKING_USERNAME_MAX_CHARACTERS).toInt();
+  m_upcomingNameMaxCharacters =
+      settings.value(UPCOMING_BOOKING_NAME_MAX_CHARACTERS).toInt();
+}
+
+// The font settings are in points for a full HD screen, the panel has no
+// meaningful DPI so the sizes are converted to pixels of the panel.
+QFont EpaperFrontend::getScaledFont(const QFont &font) const {
+  QFont scaledFont = font;
+  double scale = m_panelSize.height() / DESIGN_HEIGHT;
+  scaledFont.setPixelSize(
+      qMax(1, qRound(font.pointSizeF() * 96.0 / 72.0 * scale)));
+  // Anti-aliased edges would only turn into grey fringes after quantizing.
+  scaledFont.setStyleStrategy(m_greyLevels > 2 ? QFont::PreferAntialias
+                                               : QFont::NoAntialias);
+  return scaledFont;
+}
+
+void EpaperFrontend::updateDisplayState(const DisplayState &displayState) {
+  if (displayState.sequenceNumber() <= m_displayState.sequenceNumber()) {
+    return;
+  }
+  m_displayState = displayState;
+  if (!m_refreshTimer->isActive()) {
+    m_refreshTimer->start();
+  }
+}
+
+void EpaperFrontend::refreshPanel() {
+  QElapsedTimer renderTimer;
+  renderTimer.start();
+  QImage frame = renderFrame();
+  quantize(frame, m_greyLevels);
+  m_displayMetrics->recordEpaperRenderTime(renderTimer.nsecsElapsed() / 1e9);
+
+  const qint64 panelArea = qint64(frame.width()) * frame.height();
+  QList<QRect> regions;
+  bool isFullRefresh = m_panelFrame.isNull() ||
+                       (m_fullRefreshAfterPartials > 0 &&
+                        m_partialRefreshCount >= m_fullRefreshAfterPartials);
+  if (!isFullRefresh) {
+    regions = m_dirtyRegionTracker.getDirtyRegions(m_panelFrame, frame);
+    if (regions.isEmpty()) {
+      return;
+    }
+    qint64 dirtyArea = 0;
+    for (const QRect &region : std::as_const(regions)) {
+      dirtyArea += qint64(region.width()) * region.height();
+    }
+    isFullRefresh = dirtyArea > panelArea * FULL_REFRESH_AREA_RATIO;
+  }
+
+  quint64 refreshedPixels = 0;
+  if (isFullRefresh) {
+    regions = {frame.rect()};
+    refreshedPixels = panelArea;
+    m_partialRefreshCount = 0;
+  } else {
+    for (const QRect &region : std::as_const(regions)) {
+      refreshedPixels += qint64(region.width()) * region.height();
+    }
+    m_partialRefreshCount++;
+  }
+
+  m_sink->refresh(frame, regions, isFullRefresh);
+  m_panelFrame = frame;
+  recordRefreshedPixels(refreshedPixels, isFullRefresh);
+  qCDebug(lcDiagnostics) << (isFullRefresh ? "Full" : "Partial")
+                         << "e-paper refresh of" << regions.size()
+                         << "regions," << refreshedPixels << "pixels";
+}
+
+// The same layout as the widget frontend, without the backgrounds and the
+// icon: the current booking on the left, the upcoming bookings on the right
+// and the status in a band along the bottom. The upcoming bookings fade out
+// through shades of grey instead of opacity.
+QImage EpaperFrontend::renderFrame() const {
+  QImage frame(m_panelSize, QImage::Format_RGB32);
+  frame.fill(Qt::white);
+  QPainter painter(&frame);
+  painter.setRenderHint(QPainter::TextAntialiasing, m_greyLevels > 2);
+
+  const double scale = m_panelSize.height() / DESIGN_HEIGHT;
+  const int margin = qRound(60 * scale);
+  const int statusHeight = m_panelSize.height() / 5;
+  const int upcomingWidth = m_panelSize.width() * 3 / 10;
+  const QRect contentRectangle(margin, margin,
+                               m_panelSize.width() - 2 * margin,
+                               m_panelSize.height() - statusHeight -
+                                   2 * margin);
+  const QRect currentRectangle =
+      contentRectangle.adjusted(0, 0, -upcomingWidth - margin, 0);
+  const QRect upcomingRectangle(currentRectangle.right() + margin,
+                                contentRectangle.top(), upcomingWidth,
+                                contentRectangle.height());
+
+  FontFallbackCache *fontFallbackCache = FontFallbackCache::instance();
+  const CurrentBookingData &currentBooking = m_displayState.currentBooking();
+  QString name = getTruncatedText(currentBooking.name, m_nameMaxCharacters);
+  QString info = getTruncatedText(currentBooking.info, m_infoMaxCharacters);
+  painter.setPen(Qt::black);
+  painter.setFont(fontFallbackCache->getFallbackFont(m_nameFont, name));
+  QRect nameRectangle;
+  painter.drawText(currentRectangle,
+                   Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, name,
+                   &nameRectangle);
+  painter.setFont(fontFallbackCache->getFallbackFont(m_infoFont, info));
+  painter.drawText(
+      currentRectangle.adjusted(0, nameRectangle.height() + margin / 2, 0, 0),
+      Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, info);
+
+  const QList<QColor> upcomingColors = {QColor(0, 0, 0), QColor(96, 96, 96),
+                                        QColor(144, 144, 144)};
+  const QList<UpcomingBookingData> &upcomingBookings =
+      m_displayState.upcomingBookings();
+  int upcomingTop = upcomingRectangle.top();
+  for (int index = 0;
+       index < qMin(upcomingBookings.size(), upcomingColors.size());
+       index++) {
+    QRect textRectangle;
+    painter.setPen(upcomingColors[index]);
+    painter.setFont(m_upcomingBoldFont);
+    painter.drawText(upcomingRectangle.adjusted(
+                         0, upcomingTop - upcomingRectangle.top(), 0, 0),
+                     Qt::AlignLeft | Qt::AlignTop,
+                     upcomingBookings[index].timeString, &textRectangle);
+    upcomingTop += textRectangle.height();
+    QString upcomingName = getTruncatedText(upcomingBookings[index].name,
+                                            m_upcomingNameMaxCharacters);
+    painter.setFont(
+        fontFallbackCache->getFallbackFont(m_upcomingLightFont, upcomingName));
+    painter.drawText(upcomingRectangle.adjusted(
+                         0, upcomingTop - upcomingRectangle.top(), 0, 0),
+                     Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap,
+                     upcomingName, &textRectangle);
+    upcomingTop += textRectangle.height() + margin / 2;
+  }
+
+  const QRect statusRectangle(0, m_panelSize.height() - statusHeight,
+                              m_panelSize.width(), statusHeight);
+  if (currentBooking.state == CurrentBookingState::UNBOOKED) {
+    painter.fillRect(statusRectangle.left(), statusRectangle.top(),
+                     statusRectangle.width(), qMax(2, qRound(4 * scale)),
+                     Qt::black);
+    painter.setPen(Qt::black);
+  } else {
+    painter.fillRect(statusRectangle,
+                     currentBooking.state == CurrentBookingState::BOOKED
+                         ? QColor(0, 0, 0)
+                         : QColor(64, 64, 64));
+    painter.setPen(Qt::white);
+  }
+  painter.setFont(m_statusFont);
+  painter.drawText(statusRectangle.adjusted(margin, 0, -margin, 0),
+                   Qt::AlignLeft | Qt::AlignVCenter, currentBooking.status);
+
+  if (m_displayState.isStale()) {
+    const int markerSize = qMax(8, qRound(28 * scale));
+    painter.setRenderHint(QPainter::Antialiasing, m_greyLevels > 2);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(128, 128, 128));
+    painter.drawEllipse(m_panelSize.width() - margin / 2 - markerSize,
+                        margin / 2, markerSize, markerSize);
+  }
+  painter.end();
+
+  return frame.convertToFormat(QImage::Format_Grayscale8);
+}
+
+// Snaps every pixel to the nearest grey the panel can show, so the dirty
+// regions are compared on what actually ends up on the panel.
+void EpaperFrontend::quantize(QImage &frame, int greyLevels) {
+  uchar levels[256];
+  for (int value = 0; value < 256; value++) {
+    int level = qRound(value * (greyLevels - 1) / 255.0);
+    levels[value] = uchar(qRound(level * 255.0 / (greyLevels - 1)));
+  }
+  for (int y = 0; y < frame.height(); y++) {
+    uchar *line = frame.scanLine(y);
+    for (int x = 0; x < frame.width(); x++) {
+      line[x] = levels[line[x]];
+    }
+  }
+}
+
+// The panel wears per refreshed pixel, so the total of a day is logged with
+// the first refresh of the next one.
+void EpaperFrontend::recordRefreshedPixels(quint64 refreshedPixels,
+                                           bool isFullRefresh) {
+  QDate today =
+      QDateTime::fromMSecsSinceEpoch(m_clock->currentMSecsSinceEpoch()).date();
+  if (m_statisticsDate.isValid() && today != m_statisticsDate) {
+    qCInfo(lcDiagnostics) << "Refreshed" << m_pixelsRefreshedToday
+                          << "e-paper pixels on"
+                          << m_statisticsDate.toString(Qt::ISODate);
+    m_pixelsRefreshedToday = 0;
+  }
+  m_statisticsDate = today;
+  m_pixelsRefreshedToday += refreshedPixels;
+
+  m_displayMetrics->recordEpaperRefresh(refreshedPixels, isFullRefresh);
+  m_displayMetrics->setEpaperPixelsRefreshedToday(m_pixelsRefreshedToday);
+}
+
+QString EpaperFrontend::getTruncatedText(QString text,
+                                         int maxCharacters) const {
+  if (text.size() > maxCharacters) {
+    text.resize(maxCharacters);
+    text.append("...");
+  }
+  return text;
+}
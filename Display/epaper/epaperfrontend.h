@@ -0,0 +1,65 @@
+#ifndef EPAPERFRONTEND_H
+#define EPAPERFRONTEND_H
+
+#include "../datatypes.h"
+#include "../diagnostics/displaymetrics.h"
+#include "../timing/clock.h"
+#include "dirtyregiontracker.h"
+#include "epapersink.h"
+#include <QDate>
+#include <QFont>
+#include <QImage>
+#include <QObject>
+#include <QTimer>
+#include <memory>
+
+// Frontend for e-paper panels, which take around a second per refresh and
+// wear with every one of them. The layout is drawn offscreen without any
+// animation, quantized to the grey levels the panel can show, and only the
+// regions that changed since the last refresh are sent to the sink. Display
+// states arriving close together are drawn as one frame.
+class EpaperFrontend : public QObject {
+  Q_OBJECT
+public:
+  // Takes ownership of the sink.
+  EpaperFrontend(EpaperSink *sink, DisplayMetrics *displayMetrics,
+                 const Clock *clock, QObject *parent = nullptr);
+
+  void updateDisplayState(const DisplayState &displayState);
+  // Snaps every pixel of a Format_Grayscale8 frame to the nearest of
+  // greyLevels evenly spaced greys.
+  static void quantize(QImage &frame, int greyLevels);
+
+private:
+  std::unique_ptr<EpaperSink> m_sink;
+  DisplayMetrics *m_displayMetrics;
+  const Clock *m_clock;
+  DirtyRegionTracker m_dirtyRegionTracker;
+  QTimer *m_refreshTimer;
+  DisplayState m_displayState;
+  QImage m_panelFrame;
+  int m_partialRefreshCount;
+  QDate m_statisticsDate;
+  quint64 m_pixelsRefreshedToday;
+
+  QSize m_panelSize;
+  int m_greyLevels;
+  int m_fullRefreshAfterPartials;
+  QFont m_nameFont;
+  QFont m_infoFont;
+  QFont m_statusFont;
+  QFont m_upcomingBoldFont;
+  QFont m_upcomingLightFont;
+  int m_nameMaxCharacters;
+  int m_infoMaxCharacters;
+  int m_upcomingNameMaxCharacters;
+
+  void retrieveSettings();
+  QFont getScaledFont(const QFont &font) const;
+  void refreshPanel();
+  QImage renderFrame() const;
+  void recordRefreshedPixels(quint64 refreshedPixels, bool isFullRefresh);
+  QString getTruncatedText(QString text, int maxCharacters) const;
+};
+
+#endif // EPAPERFRONTEND_H
@@ -0,0 +1,29 @@
+#include "epapersink.h"
+#include "../diagnostics/logging.h"
+
+EpaperFramebufferSink::EpaperFramebufferSink(const QString &filePath)
+    : m_file(filePath) {
+  if (!m_file.open(QIODevice::ReadWrite)) {
+    qCWarning(lcDiagnostics) << "Could not open e-paper output" << filePath;
+  }
+}
+
+void EpaperFramebufferSink::refresh(const QImage &frame,
+                                    const QList<QRect> &regions,
+                                    bool isFullRefresh) {
+  if (!m_file.isOpen()) {
+    return;
+  }
+
+  const QList<QRect> writtenRegions =
+      isFullRefresh ? QList<QRect>{frame.rect()} : regions;
+  for (const QRect &region : writtenRegions) {
+    for (int y = region.top(); y <= region.bottom(); y++) {
+      m_file.seek(qint64(y) * frame.width() + region.left());
+      m_file.write(reinterpret_cast<const char *>(frame.constScanLine(y)) +
+                       region.left(),
+                   region.width());
+    }
+  }
+  m_file.flush();
+}
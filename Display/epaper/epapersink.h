@@ -0,0 +1,35 @@
+#ifndef EPAPERSINK_H
+#define EPAPERSINK_H
+
+#include <QFile>
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QString>
+
+// Where the e-paper frontend sends its panel updates. A driver for real
+// hardware implements this, pushing the regions to the panel controller.
+class EpaperSink {
+public:
+  virtual ~EpaperSink() = default;
+  // The frame is the whole 8-bit greyscale panel image, only the regions
+  // changed since the previous refresh. A full refresh has the whole frame
+  // as its only region.
+  virtual void refresh(const QImage &frame, const QList<QRect> &regions,
+                       bool isFullRefresh) = 0;
+};
+
+// Writes the panel image as raw 8-bit greyscale rows without padding, only
+// touching the bytes of the refreshed regions. Works on a regular file to
+// look at the output as well as on a greyscale framebuffer device.
+class EpaperFramebufferSink : public EpaperSink {
+public:
+  explicit EpaperFramebufferSink(const QString &filePath);
+  void refresh(const QImage &frame, const QList<QRect> &regions,
+               bool isFullRefresh) override;
+
+private:
+  QFile m_file;
+};
+
+#endif // EPAPERSINK_H
@@ -0,0 +1,229 @@
+#include "avatarstore.h"
+#include "../diagnostics/logging.h"
+#include "../settingstrings.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSettings>
+#include <QtNetwork/QNetworkRequest>
+
+namespace {
+const qint64 REVALIDATE_AGE = 24 * 60 * 60 * 1000;
+const QString AVATAR_FILE_SUFFIX = ".avatar";
+
+// Content hashes end up in file names, so only plain hex digests of at most
+// SHA-256 length are taken from the backend or from the directory.
+bool isContentHash(const QString &contentHash) {
+  static const QRegularExpression contentHashExpression("^[0-9a-f]{1,64}$");
+  return contentHashExpression.match(contentHash).hasMatch();
+}
+} // namespace
+
+AvatarStore::AvatarStore(const QString &directoryPath, qint64 maxDiskSize,
+                         QNetworkAccessManager *networkManager,
+                         QObject *parent)
+    : QObject{parent}, m_directoryPath(directoryPath),
+      m_maxDiskSize(maxDiskSize), m_networkManager(networkManager) {
+  // Only the primary endpoint, like the schedule cache. A picture that shows
+  // up a bit late after a failover doesn't matter.
+  m_apiAddress = QSettings()
+                     .value(API_ADDRESS_SETTING)
+                     .toString()
+                     .section(',', 0, 0)
+                     .trimmed();
+}
+
+void AvatarStore::startCaching() {
+  QDir().mkpath(m_directoryPath);
+  loadStoredAvatars();
+}
+
+void AvatarStore::requestAvatar(const QString &userId) {
+  if (userId.isEmpty()) {
+    emit avatarAvailable(userId, QString());
+    return;
+  }
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  auto storedAvatar = m_avatarsByUserId.find(userId);
+  if (storedAvatar == m_avatarsByUserId.end()) {
+    fetchAvatar(userId);
+    return;
+  }
+
+  storedAvatar->lastRequestedAt = now;
+  emit avatarAvailable(userId, storedAvatar->filePath);
+  if (now - storedAvatar->checkedAt > REVALIDATE_AGE) {
+    fetchAvatar(userId);
+  }
+}
+
+// The directory is the index: every file is named after the hex encoded user
+// ID and the hash of its content. Their modification time is when they were
+// downloaded, which also stands in for when they were last requested until
+// this run requests them.
+void AvatarStore::loadStoredAvatars() {
+  const QFileInfoList avatarFiles =
+      QDir(m_directoryPath)
+          .entryInfoList({"*" + AVATAR_FILE_SUFFIX}, QDir::Files,
+                         QDir::Time | QDir::Reversed);
+  for (const QFileInfo &avatarFile : avatarFiles) {
+    QString userIdHex = avatarFile.completeBaseName().section('_', 0, 0);
+    QString contentHash = avatarFile.completeBaseName().section('_', 1);
+    QString userId =
+        QString::fromUtf8(QByteArray::fromHex(userIdHex.toLatin1()));
+    if (userId.isEmpty() || !isContentHash(contentHash)) {
+      continue;
+    }
+
+    // Oldest first, so a newer picture of the same user replaces the file of
+    // an older one left behind by a crash.
+    if (m_avatarsByUserId.contains(userId)) {
+      QFile::remove(m_avatarsByUserId[userId].filePath);
+    }
+    StoredAvatar storedAvatar;
+    storedAvatar.filePath = avatarFile.absoluteFilePath();
+    storedAvatar.contentHash = contentHash;
+    storedAvatar.fileSize = avatarFile.size();
+    storedAvatar.checkedAt = avatarFile.lastModified().toMSecsSinceEpoch();
+    storedAvatar.lastRequestedAt = storedAvatar.checkedAt;
+    m_avatarsByUserId.insert(userId, storedAvatar);
+  }
+  removeLeastRecentlyRequested();
+}
+
+void AvatarStore::fetchAvatar(const QString &userId) {
+  if (m_userIdsBeingFetched.contains(userId)) {
+    return;
+  }
+  m_userIdsBeingFetched.insert(userId);
+
+  QNetworkRequest request(
+      QUrl(m_apiAddress + "/users/" +
+           QString::fromLatin1(QUrl::toPercentEncoding(userId)) + "/avatar"));
+  QString contentHash = m_avatarsByUserId.value(userId).contentHash;
+  if (!contentHash.isEmpty()) {
+    request.setRawHeader("If-None-Match", '"' + contentHash.toLatin1() + '"');
+  }
+  QNetworkReply *reply = m_networkManager->get(request);
+  reply->setProperty("userId", userId);
+  connect(reply, &QNetworkReply::finished, this,
+          [this, reply]() { onAvatarRequestFinished(reply); });
+}
+
+void AvatarStore::onAvatarRequestFinished(QNetworkReply *reply) {
+  reply->deleteLater();
+  QString userId = reply->property("userId").toString();
+  m_userIdsBeingFetched.remove(userId);
+  int statusCode =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  if (statusCode == 304 && m_avatarsByUserId.contains(userId)) {
+    m_avatarsByUserId[userId].checkedAt = now;
+    return;
+  }
+  if (statusCode == 404) {
+    bool hadAvatar = !m_avatarsByUserId.value(userId).filePath.isEmpty();
+    forgetAvatar(userId);
+    StoredAvatar missingAvatar;
+    missingAvatar.checkedAt = now;
+    missingAvatar.lastRequestedAt = now;
+    m_avatarsByUserId.insert(userId, missingAvatar);
+    if (hadAvatar) {
+      emit avatarAvailable(userId, QString());
+    }
+    return;
+  }
+  if (reply->error()) {
+    // Whatever was stored stays, the next request for the user retries.
+    qCWarning(lcNetwork) << "Could not fetch the avatar of" << userId << ":"
+                         << reply->errorString();
+    return;
+  }
+
+  QByteArray content = reply->readAll();
+  // A weak ETag, or one a proxy made up, names the file after the content.
+  QString contentHash =
+      QString::fromLatin1(reply->rawHeader("ETag")).remove('"');
+  if (!isContentHash(contentHash)) {
+    contentHash = QString::fromLatin1(
+        QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex());
+  }
+  if (m_avatarsByUserId.value(userId).contentHash == contentHash) {
+    m_avatarsByUserId[userId].checkedAt = now;
+    return;
+  }
+  storeAvatar(userId, content, contentHash);
+}
+
+void AvatarStore::storeAvatar(const QString &userId,
+                              const QByteArray &content,
+                              const QString &contentHash) {
+  QString filePath = getFilePath(userId, contentHash);
+  QSaveFile avatarFile(filePath);
+  if (!avatarFile.open(QIODevice::WriteOnly) ||
+      avatarFile.write(content) != content.size() || !avatarFile.commit()) {
+    qCWarning(lcDiagnostics) << "Could not store the avatar of" << userId
+                             << "at" << filePath;
+    return;
+  }
+
+  forgetAvatar(userId);
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  StoredAvatar storedAvatar;
+  storedAvatar.filePath = filePath;
+  storedAvatar.contentHash = contentHash;
+  storedAvatar.fileSize = content.size();
+  storedAvatar.checkedAt = now;
+  storedAvatar.lastRequestedAt = now;
+  m_avatarsByUserId.insert(userId, storedAvatar);
+  removeLeastRecentlyRequested();
+  if (m_avatarsByUserId.contains(userId)) {
+    emit avatarAvailable(userId, filePath);
+  }
+}
+
+void AvatarStore::forgetAvatar(const QString &userId) {
+  QString filePath = m_avatarsByUserId.take(userId).filePath;
+  if (!filePath.isEmpty()) {
+    QFile::remove(filePath);
+  }
+}
+
+// There are at most a few hundred bookers, so finding the least recently
+// requested one by going over all of them is cheap enough.
+void AvatarStore::removeLeastRecentlyRequested() {
+  qint64 diskSize = 0;
+  for (const StoredAvatar &storedAvatar : std::as_const(m_avatarsByUserId)) {
+    diskSize += storedAvatar.fileSize;
+  }
+
+  while (diskSize > m_maxDiskSize) {
+    auto leastRecentlyRequested = m_avatarsByUserId.end();
+    for (auto it = m_avatarsByUserId.begin(); it != m_avatarsByUserId.end();
+         ++it) {
+      if (!it->filePath.isEmpty() &&
+          (leastRecentlyRequested == m_avatarsByUserId.end() ||
+           it->lastRequestedAt < leastRecentlyRequested->lastRequestedAt)) {
+        leastRecentlyRequested = it;
+      }
+    }
+    if (leastRecentlyRequested == m_avatarsByUserId.end()) {
+      return;
+    }
+    diskSize -= leastRecentlyRequested->fileSize;
+    QFile::remove(leastRecentlyRequested->filePath);
+    m_avatarsByUserId.erase(leastRecentlyRequested);
+  }
+}
+
+QString AvatarStore::getFilePath(const QString &userId,
+                                 const QString &contentHash) const {
+  return QDir(m_directoryPath)
+      .filePath(QString::fromLatin1(userId.toUtf8().toHex()) + "_" +
+                contentHash + AVATAR_FILE_SUFFIX);
+}
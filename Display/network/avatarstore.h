@@ -0,0 +1,60 @@
+#ifndef AVATARSTORE_H
+#define AVATARSTORE_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+// Profile pictures of the bookers, fetched through the display API and kept
+// on disk as the encoded files it sent, named by user ID and content hash. A
+// booker seen before is answered from disk without any request. Once a day
+// the picture is revalidated with its hash, which only costs a 304 when it
+// didn't change. Past the disk budget the least recently requested pictures
+// are removed. Decoding and scaling is left to the AssetCache, which keeps
+// the results in memory. Lives on the data fetching thread.
+class AvatarStore : public QObject {
+  Q_OBJECT
+public:
+  AvatarStore(const QString &directoryPath, qint64 maxDiskSize,
+              QNetworkAccessManager *networkManager,
+              QObject *parent = nullptr);
+  void startCaching();
+  void requestAvatar(const QString &userId);
+
+signals:
+  // The path is empty when the user has no picture.
+  void avatarAvailable(const QString &userId, const QString &filePath);
+
+private:
+  // A user without a picture is remembered with an empty file path, so they
+  // aren't asked for again until the next revalidation.
+  struct StoredAvatar {
+    QString filePath;
+    QString contentHash;
+    qint64 fileSize = 0;
+    qint64 checkedAt = 0;
+    qint64 lastRequestedAt = 0;
+  };
+
+  QString m_directoryPath;
+  qint64 m_maxDiskSize;
+  QNetworkAccessManager *m_networkManager;
+  QString m_apiAddress;
+  QHash<QString, StoredAvatar> m_avatarsByUserId;
+  QSet<QString> m_userIdsBeingFetched;
+
+  void loadStoredAvatars();
+  void fetchAvatar(const QString &userId);
+  void onAvatarRequestFinished(QNetworkReply *reply);
+  void storeAvatar(const QString &userId, const QByteArray &content,
+                   const QString &contentHash);
+  void forgetAvatar(const QString &userId);
+  void removeLeastRecentlyRequested();
+  QString getFilePath(const QString &userId,
+                      const QString &contentHash) const;
+};
+
+#endif // AVATARSTORE_H
@@ -0,0 +1,48 @@
+#include "connectionmonitor.h"
+
+ConnectionMonitor::ConnectionMonitor(int maxConsecutiveFailures,
+                                     qint64 maxTimeWithoutSuccess)
+    : m_maxConsecutiveFailures(qMax(1, maxConsecutiveFailures)),
+      m_maxTimeWithoutSuccess(maxTimeWithoutSuccess),
+      m_state(ConnectionState::DISCONNECTED), m_consecutiveFailures(0),
+      m_lastSuccessAt(0) {}
+
+ConnectionState ConnectionMonitor::state() const { return m_state; }
+
+bool ConnectionMonitor::recordSuccess(qint64 now) {
+  bool wasFlapSuppressed = m_state == ConnectionState::DEGRADED;
+  m_state = ConnectionState::CONNECTED;
+  m_consecutiveFailures = 0;
+  m_lastSuccessAt = now;
+  return wasFlapSuppressed;
+}
+
+void ConnectionMonitor::recordFailure(qint64 now) {
+  m_consecutiveFailures++;
+  // Without a single success there is nothing worth holding on to.
+  if (m_lastSuccessAt == 0 ||
+      m_consecutiveFailures >= m_maxConsecutiveFailures ||
+      now - m_lastSuccessAt >= m_maxTimeWithoutSuccess) {
+    m_state = ConnectionState::DISCONNECTED;
+  } else if (m_state == ConnectionState::CONNECTED) {
+    m_state = ConnectionState::DEGRADED;
+  }
+}
+
+bool ConnectionMonitor::recordSilence(qint64 now) {
+  if (m_state == ConnectionState::DISCONNECTED || m_lastSuccessAt == 0 ||
+      now - m_lastSuccessAt < m_maxTimeWithoutSuccess) {
+    return false;
+  }
+  m_state = ConnectionState::DISCONNECTED;
+  return true;
+}
+
+qint64 ConnectionMonitor::maxTimeWithoutSuccess() const {
+  return m_maxTimeWithoutSuccess;
+}
+
+void ConnectionMonitor::recordPermanentFailure() {
+  m_consecutiveFailures++;
+  m_state = ConnectionState::DISCONNECTED;
+}
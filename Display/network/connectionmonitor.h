@@ -0,0 +1,36 @@
+#ifndef CONNECTIONMONITOR_H
+#define CONNECTIONMONITOR_H
+
+#include <QtGlobal>
+
+enum class ConnectionState { CONNECTED, DEGRADED, DISCONNECTED };
+
+// Tells a blip from an outage. Failed polls only count as disconnected after
+// a number of them in a row or a while without any success, until then the
+// connection is degraded and the display keeps showing what it last got.
+// Times are in clock milliseconds.
+class ConnectionMonitor {
+public:
+  ConnectionMonitor(int maxConsecutiveFailures, qint64 maxTimeWithoutSuccess);
+
+  ConnectionState state() const;
+  // True when this ends a run of failures that never got to disconnected,
+  // which is a flap the display didn't show.
+  bool recordSuccess(qint64 now);
+  void recordFailure(qint64 now);
+  // Polls that hang don't fail for a long time, so the time without success
+  // is also checked when nothing arrived at all. True when that disconnects.
+  bool recordSilence(qint64 now);
+  qint64 maxTimeWithoutSuccess() const;
+  // For failures that waiting won't fix, like an unknown room.
+  void recordPermanentFailure();
+
+private:
+  int m_maxConsecutiveFailures;
+  qint64 m_maxTimeWithoutSuccess;
+  ConnectionState m_state;
+  int m_consecutiveFailures;
+  qint64 m_lastSuccessAt; // 0 until the first success.
+};
+
+#endif // CONNECTIONMONITOR_H
@@ -0,0 +1,112 @@
+#include "endpointselector.h"
+#include "../diagnostics/logging.h"
+
+namespace {
+const double ROUND_TRIP_TIME_SMOOTHING = 0.2;
+const double ERROR_RATE_SMOOTHING = 0.1;
+const int UNHEALTHY_CONSECUTIVE_ERRORS = 3;
+// Score of an endpoint that hasn't answered yet, in seconds.
+const double UNKNOWN_ROUND_TRIP_TIME = 1.0;
+const double ERROR_RATE_PENALTY = 4.0;
+const double STANDBY_PENALTY = 0.5;
+const double SWITCH_SCORE_RATIO = 0.8;
+} // namespace
+
+EndpointSelector::EndpointSelector(const QStringList &addresses)
+    : m_selectedIndex(0) {
+  for (const QString &address : addresses) {
+    if (address.trimmed().isEmpty()) {
+      continue;
+    }
+    EndpointHealth endpoint;
+    endpoint.address = address.trimmed();
+    m_endpoints.append(endpoint);
+  }
+  if (m_endpoints.isEmpty()) {
+    m_endpoints.append(EndpointHealth());
+  }
+}
+
+int EndpointSelector::endpointCount() const { return m_endpoints.size(); }
+
+QString EndpointSelector::address(int index) const {
+  return m_endpoints[index].address;
+}
+
+int EndpointSelector::selectedIndex() const { return m_selectedIndex; }
+
+int EndpointSelector::alternativeIndex() const {
+  int bestIndex = -1;
+  for (int index = 0; index < m_endpoints.size(); index++) {
+    if (index == m_selectedIndex || !isHealthy(index)) {
+      continue;
+    }
+    if (bestIndex < 0 || getScore(index) < getScore(bestIndex)) {
+      bestIndex = index;
+    }
+  }
+  return bestIndex;
+}
+
+void EndpointSelector::recordSuccess(int index, double roundTripTime) {
+  EndpointHealth &endpoint = m_endpoints[index];
+  endpoint.smoothedRoundTripTime =
+      endpoint.smoothedRoundTripTime < 0
+          ? roundTripTime
+          : endpoint.smoothedRoundTripTime +
+                ROUND_TRIP_TIME_SMOOTHING *
+                    (roundTripTime - endpoint.smoothedRoundTripTime);
+  endpoint.errorRate *= 1.0 - ERROR_RATE_SMOOTHING;
+  endpoint.consecutiveErrors = 0;
+  updateSelection();
+}
+
+void EndpointSelector::recordError(int index) {
+  EndpointHealth &endpoint = m_endpoints[index];
+  endpoint.errorRate += ERROR_RATE_SMOOTHING * (1.0 - endpoint.errorRate);
+  endpoint.consecutiveErrors++;
+  updateSelection();
+}
+
+QList<EndpointHealth> EndpointSelector::health() const {
+  QList<EndpointHealth> endpoints = m_endpoints;
+  endpoints[m_selectedIndex].selected = true;
+  return endpoints;
+}
+
+bool EndpointSelector::isHealthy(int index) const {
+  return m_endpoints[index].consecutiveErrors < UNHEALTHY_CONSECUTIVE_ERRORS;
+}
+
+double EndpointSelector::getScore(int index) const {
+  const EndpointHealth &endpoint = m_endpoints[index];
+  double roundTripTime = endpoint.smoothedRoundTripTime < 0
+                             ? UNKNOWN_ROUND_TRIP_TIME
+                             : endpoint.smoothedRoundTripTime;
+  return roundTripTime * (1.0 + ERROR_RATE_PENALTY * endpoint.errorRate) *
+         (1.0 + STANDBY_PENALTY * index);
+}
+
+void EndpointSelector::updateSelection() {
+  int bestIndex = -1;
+  for (int index = 0; index < m_endpoints.size(); index++) {
+    if (isHealthy(index) &&
+        (bestIndex < 0 || getScore(index) < getScore(bestIndex))) {
+      bestIndex = index;
+    }
+  }
+
+  // With everything down, stay where we are until something answers again.
+  if (bestIndex < 0 || bestIndex == m_selectedIndex) {
+    return;
+  }
+  if (isHealthy(m_selectedIndex) &&
+      getScore(bestIndex) >= SWITCH_SCORE_RATIO * getScore(m_selectedIndex)) {
+    return;
+  }
+
+  qCInfo(lcNetwork) << "Switching API endpoint from"
+                    << m_endpoints[m_selectedIndex].address << "to"
+                    << m_endpoints[bestIndex].address;
+  m_selectedIndex = bestIndex;
+}
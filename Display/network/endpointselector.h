@@ -0,0 +1,43 @@
+#ifndef ENDPOINTSELECTOR_H
+#define ENDPOINTSELECTOR_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct EndpointHealth {
+  QString address;
+  double smoothedRoundTripTime = -1.0; // Seconds, negative until measured.
+  double errorRate = 0.0;
+  int consecutiveErrors = 0;
+  bool selected = false;
+};
+
+// Picks which of the configured backends to poll from the round trip times
+// and error rates seen so far. Earlier endpoints in the list are preferred, so
+// the display fails back to the primary once it is healthy again. Switching
+// needs a clear difference in score to avoid flapping between endpoints.
+class EndpointSelector {
+public:
+  explicit EndpointSelector(const QStringList &addresses);
+
+  int endpointCount() const;
+  QString address(int index) const;
+  int selectedIndex() const;
+  // The best endpoint other than the selected one, or -1 when there is none.
+  int alternativeIndex() const;
+
+  void recordSuccess(int index, double roundTripTime);
+  void recordError(int index);
+  QList<EndpointHealth> health() const;
+
+private:
+  QList<EndpointHealth> m_endpoints;
+  int m_selectedIndex;
+
+  bool isHealthy(int index) const;
+  double getScore(int index) const;
+  void updateSelection();
+};
+
+#endif // ENDPOINTSELECTOR_H
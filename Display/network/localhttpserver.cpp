@@ -0,0 +1,165 @@
+#include "localhttpserver.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace {
+const int MAX_REQUEST_HEADER_SIZE = 8192;
+const qint64 MAX_REQUEST_BODY_SIZE = 16384;
+
+QByteArray getReasonPhrase(int statusCode) {
+  switch (statusCode) {
+  case 200:
+    return "OK";
+  case 304:
+    return "Not Modified";
+  case 400:
+    return "Bad Request";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 502:
+    return "Bad Gateway";
+  case 503:
+    return "Service Unavailable";
+  default:
+    return "Unknown";
+  }
+}
+} // namespace
+
+LocalHttpServer::LocalHttpServer(QObject *parent)
+    : QObject{parent}, m_tcpServer(new QTcpServer(this)) {
+  connect(m_tcpServer, &QTcpServer::newConnection, this,
+          &LocalHttpServer::onNewConnection);
+}
+
+bool LocalHttpServer::listen(quint16 port) {
+  return m_tcpServer->listen(QHostAddress::Any, port);
+}
+
+void LocalHttpServer::addRoute(const QString &pathPrefix,
+                               RouteHandler handler,
+                               const QByteArray &method) {
+  m_routes.append(Route{method, pathPrefix, handler});
+}
+
+void LocalHttpServer::onNewConnection() {
+  while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+    connect(socket, &QTcpSocket::readyRead, this,
+            [this, socket]() { onSocketReadyRead(socket); });
+    connect(socket, &QTcpSocket::disconnected, socket,
+            &QObject::deleteLater);
+  }
+}
+
+void LocalHttpServer::onSocketReadyRead(QTcpSocket *socket) {
+  // Requests are tiny, so they are buffered on the socket itself until the
+  // header and the body announced by its Content-Length are complete.
+  QByteArray buffer =
+      socket->property("requestBuffer").toByteArray() + socket->readAll();
+  if (socket->property("requestHandled").toBool()) {
+    return;
+  }
+
+  int headerEnd = buffer.indexOf("\r\n\r\n");
+  if (headerEnd < 0) {
+    if (buffer.size() > MAX_REQUEST_HEADER_SIZE) {
+      sendResponse(socket, 400, "text/plain", "Request too large\n");
+      return;
+    }
+    socket->setProperty("requestBuffer", buffer);
+    return;
+  }
+
+  QList<QByteArray> headerLines = buffer.left(headerEnd).split('\n');
+  QByteArray requestLine = headerLines.takeFirst().trimmed();
+  QHash<QByteArray, QByteArray> headers;
+  for (const QByteArray &headerLine : std::as_const(headerLines)) {
+    int separator = headerLine.indexOf(':');
+    if (separator > 0) {
+      headers.insert(headerLine.left(separator).trimmed().toLower(),
+                     headerLine.mid(separator + 1).trimmed());
+    }
+  }
+
+  qint64 contentLength = headers.value("content-length", "0").toLongLong();
+  if (contentLength < 0 || contentLength > MAX_REQUEST_BODY_SIZE) {
+    sendResponse(socket, 400, "text/plain", "Request too large\n");
+    return;
+  }
+  qint64 bodyStart = headerEnd + 4;
+  if (buffer.size() - bodyStart < contentLength) {
+    socket->setProperty("requestBuffer", buffer);
+    return;
+  }
+
+  socket->setProperty("requestHandled", true);
+  socket->setProperty("requestBuffer", QVariant());
+  dispatchRequest(socket, requestLine, headers,
+                  buffer.mid(bodyStart, contentLength));
+}
+
+void LocalHttpServer::dispatchRequest(
+    QTcpSocket *socket, const QByteArray &requestLine,
+    const QHash<QByteArray, QByteArray> &headers, const QByteArray &body) {
+  QList<QByteArray> requestParts = requestLine.split(' ');
+  if (requestParts.size() != 3) {
+    sendResponse(socket, 400, "text/plain", "Malformed request\n");
+    return;
+  }
+
+  Request request;
+  request.method = requestParts[0];
+  request.url = QUrl(QString::fromLatin1(requestParts[1]));
+  request.headers = headers;
+  request.body = body;
+  QString path = request.url.path();
+
+  const RouteHandler *bestHandler = nullptr;
+  int bestPrefixLength = -1;
+  bool hasPathForOtherMethod = false;
+  for (const Route &route : m_routes) {
+    if (!path.startsWith(route.pathPrefix)) {
+      continue;
+    }
+    if (route.method != request.method) {
+      hasPathForOtherMethod = true;
+    } else if (route.pathPrefix.size() > bestPrefixLength) {
+      bestHandler = &route.handler;
+      bestPrefixLength = route.pathPrefix.size();
+    }
+  }
+
+  if (!bestHandler && hasPathForOtherMethod) {
+    sendResponse(socket, 405, "text/plain", "Method not allowed\n");
+    return;
+  }
+  if (!bestHandler) {
+    sendResponse(socket, 404, "text/plain", "Not found\n");
+    return;
+  }
+  (*bestHandler)(socket, request);
+}
+
+void LocalHttpServer::sendResponse(
+    QTcpSocket *socket, int statusCode, const QByteArray &contentType,
+    const QByteArray &body, const QHash<QByteArray, QByteArray> &extraHeaders) {
+  if (socket->state() != QAbstractSocket::ConnectedState) {
+    return;
+  }
+
+  QByteArray response = "HTTP/1.1 " + QByteArray::number(statusCode) + " " +
+                        getReasonPhrase(statusCode) + "\r\n";
+  response += "Content-Type: " + contentType + "\r\n";
+  response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+  for (auto it = extraHeaders.constBegin(); it != extraHeaders.constEnd();
+       ++it) {
+    response += it.key() + ": " + it.value() + "\r\n";
+  }
+  response += "Connection: close\r\n\r\n";
+  response += body;
+
+  socket->write(response);
+  socket->disconnectFromHost();
+}
@@ -0,0 +1,59 @@
+#ifndef LOCALHTTPSERVER_H
+#define LOCALHTTPSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QUrl>
+#include <functional>
+
+class QTcpServer;
+class QTcpSocket;
+
+// Tiny HTTP/1.1 server for the endpoints the display exposes on the local
+// network. Routes are registered per method, requests may carry a small body
+// and every connection is closed after a single response. Handlers may respond
+// later (asynchronously) as long as they call sendResponse() on the socket
+// they were given.
+class LocalHttpServer : public QObject {
+  Q_OBJECT
+public:
+  struct Request {
+    QByteArray method;
+    QUrl url;
+    // Header names are lower case.
+    QHash<QByteArray, QByteArray> headers;
+    QByteArray body;
+  };
+  using RouteHandler =
+      std::function<void(QTcpSocket *socket, const Request &request)>;
+
+  explicit LocalHttpServer(QObject *parent = nullptr);
+  bool listen(quint16 port);
+  void addRoute(const QString &pathPrefix, RouteHandler handler,
+                const QByteArray &method = "GET");
+
+  static void sendResponse(
+      QTcpSocket *socket, int statusCode, const QByteArray &contentType,
+      const QByteArray &body,
+      const QHash<QByteArray, QByteArray> &extraHeaders = {});
+
+private:
+  struct Route {
+    QByteArray method;
+    QString pathPrefix;
+    RouteHandler handler;
+  };
+
+  QTcpServer *m_tcpServer;
+  QList<Route> m_routes;
+
+  void onNewConnection();
+  void onSocketReadyRead(QTcpSocket *socket);
+  void dispatchRequest(QTcpSocket *socket, const QByteArray &requestLine,
+                       const QHash<QByteArray, QByteArray> &headers,
+                       const QByteArray &body);
+};
+
+#endif // LOCALHTTPSERVER_H
@@ -0,0 +1,426 @@
+#include "relayserver.h"
+#include "../datafetchinghandler.h"
+#include "../diagnostics/logging.h"
+#include "../settingstrings.h"
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTcpSocket>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+
+namespace {
+// Rooms nobody asked for in this long are no longer refreshed, unless they
+// are configured explicitly.
+const qint64 UNUSED_ROOM_EVICTION_TIME = 10 * 60 * 1000;
+const int STATS_LOG_INTERVAL = 60 * 1000;
+const QByteArray ROOM_NOT_FOUND_BODY =
+    R"({"detail":"ERROR: Room ID not found."})";
+const QByteArray BACKEND_UNREACHABLE_BODY =
+    R"({"detail":"ERROR: Relay could not reach the backend."})";
+const QByteArray SERVER_TIME_HEADER = "X-Server-Time";
+} // namespace
+
+RelayServer::RelayServer(DisplayMetrics *displayMetrics, QObject *parent)
+    : QObject{parent}, m_displayMetrics(displayMetrics),
+      m_httpServer(nullptr), m_networkManager(nullptr),
+      m_refreshTimer(nullptr), m_statsTimer(nullptr), m_servedRequests(0),
+      m_cacheHits(0) {
+  retrieveSettings();
+}
+
+void RelayServer::retrieveSettings() {
+  QSettings settings;
+  // The relay is the one thing in front of the backend at its site, so it
+  // only uses the primary of the configured endpoints.
+  m_apiAddress = settings.value(API_ADDRESS_SETTING)
+                     .toString()
+                     .section(',', 0, 0)
+                     .trimmed();
+  m_port = settings.value(RELAY_PORT_SETTING).toUInt();
+  m_refreshInterval = settings.value(RELAY_REFRESH_INTERVAL_SETTING).toInt();
+  m_maxAge = settings.value(RELAY_MAX_AGE_SETTING).toInt();
+  m_maxStaleAge = settings.value(RELAY_MAX_STALE_AGE_SETTING).toInt();
+
+  // Configured rooms are assumed to be in the same timezone as the relay.
+  QString timezoneId = DataFetchingHandler::getSystemTimezoneId();
+  const QStringList roomIds =
+      settings.value(RELAY_ROOM_IDS_SETTING).toString().split(',');
+  for (const QString &roomId : roomIds) {
+    bool isNumber = false;
+    int parsedRoomId = roomId.trimmed().toInt(&isNumber);
+    if (isNumber) {
+      m_configuredRoomKeys.insert(getRoomKey(parsedRoomId, timezoneId));
+    }
+  }
+}
+
+void RelayServer::startRelaying() {
+  // Created here so everything lives on the thread this relay was moved to.
+  m_networkManager = new QNetworkAccessManager(this);
+  connect(m_networkManager, &QNetworkAccessManager::finished, this,
+          &RelayServer::onBatchRequestFinished);
+  m_clock.start();
+
+  for (const QString &roomKey : std::as_const(m_configuredRoomKeys)) {
+    m_cachedRooms.insert(roomKey, CachedRoomData());
+  }
+
+  m_httpServer = new LocalHttpServer(this);
+  m_httpServer->addRoute(
+      "/rooms/",
+      [this](QTcpSocket *socket, const LocalHttpServer::Request &request) {
+        onRoomRequested(socket, request);
+      });
+  m_httpServer->addRoute(
+      "/rooms/",
+      [this](QTcpSocket *socket, const LocalHttpServer::Request &request) {
+        onBookingRequested(socket, request);
+      },
+      "POST");
+  // Booker avatars are cached by the panels themselves, which revalidate
+  // them with their ETag.
+  m_httpServer->addRoute(
+      "/users/",
+      [this](QTcpSocket *socket, const LocalHttpServer::Request &request) {
+        forwardRequest(socket, request);
+      });
+  if (!m_httpServer->listen(m_port)) {
+    qCWarning(lcNetwork) << "Could not start relay on port" << m_port;
+    return;
+  }
+
+  m_refreshTimer = new QTimer(this);
+  connect(m_refreshTimer, &QTimer::timeout, this,
+          &RelayServer::refreshRequestedRooms);
+  m_refreshTimer->start(m_refreshInterval);
+
+  m_statsTimer = new QTimer(this);
+  connect(m_statsTimer, &QTimer::timeout, this, &RelayServer::logStats);
+  m_statsTimer->start(STATS_LOG_INTERVAL);
+
+  qCInfo(lcNetwork) << "Relaying" << m_apiAddress << "on port" << m_port;
+  refreshRequestedRooms();
+}
+
+void RelayServer::onRoomRequested(QTcpSocket *socket,
+                                  const LocalHttpServer::Request &request) {
+  const QStringList pathParts =
+      request.url.path().split('/', Qt::SkipEmptyParts);
+  if (pathParts.size() > 3) {
+    // Day pages of the week view are only asked for when someone is looking
+    // at the panel, those aren't worth caching.
+    forwardRequest(socket, request);
+    return;
+  }
+  bool isNumber = false;
+  int roomId = pathParts.size() == 3 ? pathParts[1].toInt(&isNumber) : 0;
+  if (!isNumber) {
+    sendResponse(socket, 404, "application/json", R"({"detail":"Not Found"})");
+    return;
+  }
+
+  const QString &timezoneId = pathParts[2];
+  QString roomKey = getRoomKey(roomId, timezoneId);
+  CachedRoomData &roomData = m_cachedRooms[roomKey];
+  roomData.lastRequestedAt = m_clock.elapsed();
+
+  if (isFresh(roomData)) {
+    respond(socket, roomData, RelayRequestResult::HIT);
+    return;
+  }
+
+  // Anything not fresh waits for the next batch, which is started right away
+  // instead of waiting for the refresh timer. Concurrent misses for the same
+  // room all end up waiting on that one request.
+  m_waitingSockets[roomKey].append(QPointer<QTcpSocket>(socket));
+  const QSet<int> roomsBeingFetched = m_roomsBeingFetched.value(timezoneId);
+  if (m_roomsBeingFetched.contains(timezoneId) &&
+      !roomsBeingFetched.contains(roomId)) {
+    m_timezonesNeedingRefetch.insert(timezoneId);
+    return;
+  }
+  fetchTimezone(timezoneId);
+}
+
+void RelayServer::onBookingRequested(QTcpSocket *socket,
+                                     const LocalHttpServer::Request &request) {
+  // Book-now requests from the panels, /rooms/{id}/book.
+  const QStringList pathParts =
+      request.url.path().split('/', Qt::SkipEmptyParts);
+  bool isNumber = false;
+  int roomId = pathParts.size() == 3 ? pathParts[1].toInt(&isNumber) : 0;
+  if (!isNumber || pathParts[2] != "book") {
+    sendResponse(socket, 404, "application/json", R"({"detail":"Not Found"})");
+    return;
+  }
+  forwardRequest(socket, request, roomId);
+}
+
+void RelayServer::refreshRequestedRooms() {
+  qint64 now = m_clock.elapsed();
+  QSet<QString> timezonesToRefresh;
+
+  for (auto it = m_cachedRooms.begin(); it != m_cachedRooms.end();) {
+    bool isUnused = it->lastRequestedAt < 0 ||
+                    now - it->lastRequestedAt > UNUSED_ROOM_EVICTION_TIME;
+    if (isUnused && !m_configuredRoomKeys.contains(it.key()) &&
+        !m_waitingSockets.contains(it.key())) {
+      it = m_cachedRooms.erase(it);
+      continue;
+    }
+    timezonesToRefresh.insert(it.key().section('/', 1));
+    ++it;
+  }
+
+  for (const QString &timezoneId : std::as_const(timezonesToRefresh)) {
+    fetchTimezone(timezoneId);
+  }
+}
+
+void RelayServer::fetchTimezone(const QString &timezoneId) {
+  if (m_roomsBeingFetched.contains(timezoneId)) {
+    return;
+  }
+
+  QList<int> roomIds;
+  QStringList roomIdStrings;
+  for (auto it = m_cachedRooms.constBegin(); it != m_cachedRooms.constEnd();
+       ++it) {
+    if (it.key().section('/', 1) == timezoneId) {
+      int roomId = it.key().section('/', 0, 0).toInt();
+      roomIds.append(roomId);
+      roomIdStrings.append(QString::number(roomId));
+    }
+  }
+  if (roomIds.isEmpty()) {
+    return;
+  }
+
+  m_roomsBeingFetched.insert(timezoneId,
+                             QSet<int>(roomIds.begin(), roomIds.end()));
+  m_timezonesNeedingRefetch.remove(timezoneId);
+
+  QNetworkRequest request(QUrl(m_apiAddress + "/batch/rooms/" + timezoneId +
+                               "?room_ids=" + roomIdStrings.join(',')));
+  QNetworkReply *reply = m_networkManager->get(request);
+  reply->setProperty("requestSentAtSystemTime",
+                     QDateTime::currentMSecsSinceEpoch());
+  reply->setProperty("timezoneId", timezoneId);
+  reply->setProperty("roomIds", QVariant::fromValue(roomIds));
+  m_displayMetrics->recordRelayUpstreamRequest();
+}
+
+void RelayServer::forwardRequest(QTcpSocket *socket,
+                                 const LocalHttpServer::Request &request,
+                                 int bookedRoomId) {
+  QNetworkRequest upstreamRequest(
+      QUrl(m_apiAddress + request.url.path(QUrl::FullyEncoded)));
+  QNetworkReply *reply = nullptr;
+  if (request.method == "POST") {
+    upstreamRequest.setHeader(QNetworkRequest::ContentTypeHeader,
+                              request.headers.value("content-type"));
+    upstreamRequest.setRawHeader("Authorization",
+                                 request.headers.value("authorization"));
+    reply = m_networkManager->post(upstreamRequest, request.body);
+  } else {
+    if (request.headers.contains("if-none-match")) {
+      upstreamRequest.setRawHeader("If-None-Match",
+                                   request.headers.value("if-none-match"));
+    }
+    reply = m_networkManager->get(upstreamRequest);
+  }
+  reply->setProperty("requestSentAtSystemTime",
+                     QDateTime::currentMSecsSinceEpoch());
+  reply->setProperty("isForwardedRequest", true);
+  reply->setProperty("bookedRoomId", bookedRoomId);
+  reply->setProperty("socket",
+                     QVariant::fromValue(QPointer<QTcpSocket>(socket)));
+  m_displayMetrics->recordRelayUpstreamRequest();
+}
+
+void RelayServer::onForwardedRequestFinished(QNetworkReply *reply) {
+  reply->deleteLater();
+  QPointer<QTcpSocket> socket =
+      reply->property("socket").value<QPointer<QTcpSocket>>();
+  int statusCode =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  int bookedRoomId = reply->property("bookedRoomId").toInt();
+  if (bookedRoomId >= 0 && statusCode >= 200 && statusCode < 300) {
+    // The cached schedule doesn't have the new booking yet, so the next poll
+    // of that room has to wait for a fresh batch instead of rolling the
+    // panel's booking back.
+    const QString roomKeyPrefix = QString::number(bookedRoomId) + "/";
+    for (auto it = m_cachedRooms.begin(); it != m_cachedRooms.end(); ++it) {
+      if (it.key().startsWith(roomKeyPrefix)) {
+        it->fetchedAt = -1;
+      }
+    }
+  }
+
+  if (!socket) {
+    return;
+  }
+  if (statusCode == 0) {
+    sendResponse(socket, 502, "application/json", BACKEND_UNREACHABLE_BODY);
+  } else {
+    QByteArray contentType = reply->rawHeader("Content-Type");
+    QHash<QByteArray, QByteArray> extraHeaders;
+    if (reply->hasRawHeader("ETag")) {
+      extraHeaders.insert("ETag", reply->rawHeader("ETag"));
+    }
+    sendResponse(socket, statusCode,
+                 contentType.isEmpty() ? "application/json" : contentType,
+                 reply->readAll(), extraHeaders);
+  }
+  m_servedRequests++;
+  m_displayMetrics->recordRelayRequest(statusCode >= 200 && statusCode < 400
+                                           ? RelayRequestResult::MISS
+                                           : RelayRequestResult::FAILED);
+}
+
+void RelayServer::onBatchRequestFinished(QNetworkReply *reply) {
+  recordServerTime(reply);
+  if (reply->property("isForwardedRequest").toBool()) {
+    onForwardedRequestFinished(reply);
+    return;
+  }
+
+  QString timezoneId = reply->property("timezoneId").toString();
+  const QList<int> roomIds = reply->property("roomIds").value<QList<int>>();
+  m_roomsBeingFetched.remove(timezoneId);
+
+  int statusCode =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  QByteArray replyBody = reply->readAll();
+  QJsonObject rooms =
+      QJsonDocument::fromJson(replyBody).object().value("rooms").toObject();
+
+  if (reply->error() == QNetworkReply::NoError) {
+    qint64 now = m_clock.elapsed();
+    for (int roomId : roomIds) {
+      QString roomKey = getRoomKey(roomId, timezoneId);
+      CachedRoomData &roomData = m_cachedRooms[roomKey];
+      QJsonValue room = rooms.value(QString::number(roomId));
+      if (room.isObject()) {
+        roomData.body =
+            QJsonDocument(room.toObject()).toJson(QJsonDocument::Compact);
+        roomData.statusCode = 200;
+      } else {
+        roomData.body = ROOM_NOT_FOUND_BODY;
+        roomData.statusCode = 404;
+      }
+      roomData.fetchedAt = now;
+      respondToWaitingSockets(roomKey, RelayRequestResult::MISS);
+    }
+  } else if (statusCode >= 400 && statusCode < 500) {
+    // The backend rejected the request itself (bad timezone and such), which
+    // the displays should hear about just like they would without the relay.
+    for (int roomId : roomIds) {
+      QString roomKey = getRoomKey(roomId, timezoneId);
+      failWaitingSockets(roomKey, statusCode, replyBody);
+      if (!m_configuredRoomKeys.contains(roomKey)) {
+        m_cachedRooms.remove(roomKey);
+      }
+    }
+  } else {
+    qCWarning(lcNetwork) << "Relay could not reach the backend:"
+                         << reply->errorString();
+    for (int roomId : roomIds) {
+      QString roomKey = getRoomKey(roomId, timezoneId);
+      const CachedRoomData &roomData = m_cachedRooms[roomKey];
+      if (roomData.fetchedAt >= 0 &&
+          m_clock.elapsed() - roomData.fetchedAt <= m_maxStaleAge) {
+        respondToWaitingSockets(roomKey, RelayRequestResult::STALE);
+      } else {
+        failWaitingSockets(roomKey, 502, BACKEND_UNREACHABLE_BODY);
+      }
+    }
+  }
+  reply->deleteLater();
+
+  if (m_timezonesNeedingRefetch.contains(timezoneId)) {
+    fetchTimezone(timezoneId);
+  }
+}
+
+void RelayServer::respondToWaitingSockets(const QString &roomKey,
+                                          RelayRequestResult result) {
+  const QList<QPointer<QTcpSocket>> sockets = m_waitingSockets.take(roomKey);
+  const CachedRoomData roomData = m_cachedRooms.value(roomKey);
+  for (const QPointer<QTcpSocket> &socket : sockets) {
+    if (socket) {
+      respond(socket, roomData, result);
+    }
+  }
+}
+
+void RelayServer::failWaitingSockets(const QString &roomKey, int statusCode,
+                                     const QByteArray &body) {
+  const QList<QPointer<QTcpSocket>> sockets = m_waitingSockets.take(roomKey);
+  for (const QPointer<QTcpSocket> &socket : sockets) {
+    if (socket) {
+      sendResponse(socket, statusCode, "application/json", body);
+      m_servedRequests++;
+      m_displayMetrics->recordRelayRequest(RelayRequestResult::FAILED);
+    }
+  }
+}
+
+void RelayServer::respond(QTcpSocket *socket, const CachedRoomData &roomData,
+                          RelayRequestResult result) {
+  sendResponse(socket, roomData.statusCode, "application/json",
+               roomData.body);
+  m_servedRequests++;
+  if (result == RelayRequestResult::HIT) {
+    m_cacheHits++;
+  }
+  m_displayMetrics->recordRelayRequest(result);
+}
+
+void RelayServer::logStats() {
+  if (m_servedRequests == 0) {
+    return;
+  }
+  qCInfo(lcNetwork) << "Relay served" << m_servedRequests << "requests for"
+                    << m_cachedRooms.size() << "rooms, hit rate"
+                    << QString::number(100.0 * m_cacheHits / m_servedRequests,
+                                       'f', 1) +
+                           "%";
+}
+
+bool RelayServer::isFresh(const CachedRoomData &roomData) const {
+  return roomData.fetchedAt >= 0 &&
+         m_clock.elapsed() - roomData.fetchedAt <= m_maxAge;
+}
+
+QString RelayServer::getRoomKey(int roomId, const QString &timezoneId) {
+  return QString::number(roomId) + "/" + timezoneId;
+}
+
+void RelayServer::recordServerTime(QNetworkReply *reply) {
+  bool hasServerTime = false;
+  qint64 serverTime =
+      reply->rawHeader(SERVER_TIME_HEADER).toLongLong(&hasServerTime);
+  if (hasServerTime) {
+    m_clockOffsetEstimator.addSample(
+        reply->property("requestSentAtSystemTime").toLongLong(),
+        QDateTime::currentMSecsSinceEpoch(), serverTime, 0);
+  }
+}
+
+void RelayServer::sendResponse(QTcpSocket *socket, int statusCode,
+                               const QByteArray &contentType,
+                               const QByteArray &body,
+                               QHash<QByteArray, QByteArray> extraHeaders) {
+  // Until there is an estimate the header is left out, instead of passing the
+  // relay's own unsynced time off as the backend's.
+  if (m_clockOffsetEstimator.uncertainty() >= 0) {
+    extraHeaders.insert(SERVER_TIME_HEADER,
+                        QByteArray::number(QDateTime::currentMSecsSinceEpoch() +
+                                           m_clockOffsetEstimator.offset()));
+  }
+  LocalHttpServer::sendResponse(socket, statusCode, contentType, body,
+                                extraHeaders);
+}
@@ -0,0 +1,93 @@
+#ifndef RELAYSERVER_H
+#define RELAYSERVER_H
+
+#include "../diagnostics/displaymetrics.h"
+#include "../timing/clockoffsetestimator.h"
+#include "localhttpserver.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QtNetwork/QNetworkAccessManager>
+
+class QTcpSocket;
+
+// Optional relay mode: this display fetches the booking data of every room at
+// its site from the backend in one batched request per timezone and serves the
+// regular /rooms/{id}/{tz} API to the other displays from memory. Those just
+// point their API address at this display. Deeper paths below /rooms/,
+// book-now requests and booker avatars are passed through uncached. Replies
+// carry the backend's time as the relay estimates it, so the displays behind it
+// can sync their clocks as well. Lives on the data fetching thread.
+class RelayServer : public QObject {
+  Q_OBJECT
+public:
+  explicit RelayServer(DisplayMetrics *displayMetrics,
+                       QObject *parent = nullptr);
+  void startRelaying();
+
+private:
+  struct CachedRoomData {
+    QByteArray body;
+    int statusCode = 0;
+    qint64 fetchedAt = -1;
+    qint64 lastRequestedAt = -1;
+  };
+
+  DisplayMetrics *m_displayMetrics;
+  LocalHttpServer *m_httpServer;
+  QNetworkAccessManager *m_networkManager;
+  QTimer *m_refreshTimer;
+  QTimer *m_statsTimer;
+  QElapsedTimer m_clock;
+  // Of the backend's clock, from the relay's own upstream requests.
+  ClockOffsetEstimator m_clockOffsetEstimator;
+
+  QString m_apiAddress;
+  quint16 m_port;
+  int m_refreshInterval;
+  int m_maxAge;
+  int m_maxStaleAge;
+  QSet<QString> m_configuredRoomKeys;
+
+  // Keyed on "roomId/timezoneId", exactly as the displays request them.
+  QHash<QString, CachedRoomData> m_cachedRooms;
+  QHash<QString, QList<QPointer<QTcpSocket>>> m_waitingSockets;
+  QHash<QString, QSet<int>> m_roomsBeingFetched;
+  QSet<QString> m_timezonesNeedingRefetch;
+
+  quint64 m_servedRequests;
+  quint64 m_cacheHits;
+
+  void retrieveSettings();
+  void onRoomRequested(QTcpSocket *socket,
+                       const LocalHttpServer::Request &request);
+  void onBookingRequested(QTcpSocket *socket,
+                          const LocalHttpServer::Request &request);
+  void refreshRequestedRooms();
+  void forwardRequest(QTcpSocket *socket,
+                      const LocalHttpServer::Request &request,
+                      int bookedRoomId = -1);
+  void onForwardedRequestFinished(QNetworkReply *reply);
+  void fetchTimezone(const QString &timezoneId);
+  void onBatchRequestFinished(QNetworkReply *reply);
+  void respondToWaitingSockets(const QString &roomKey,
+                               RelayRequestResult result);
+  void failWaitingSockets(const QString &roomKey, int statusCode,
+                          const QByteArray &body);
+  void respond(QTcpSocket *socket, const CachedRoomData &roomData,
+               RelayRequestResult result);
+  void logStats();
+  void recordServerTime(QNetworkReply *reply);
+  void sendResponse(QTcpSocket *socket, int statusCode,
+                    const QByteArray &contentType, const QByteArray &body,
+                    QHash<QByteArray, QByteArray> extraHeaders = {});
+
+  bool isFresh(const CachedRoomData &roomData) const;
+  static QString getRoomKey(int roomId, const QString &timezoneId);
+};
+
+#endif // RELAYSERVER_H
@@ -0,0 +1,174 @@
+#include "schedulecache.h"
+#include "../datafetchinghandler.h"
+#include "../diagnostics/logging.h"
+#include "../settingstrings.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QtNetwork/QNetworkRequest>
+
+namespace {
+const int WEEK_DAY_COUNT = 7;
+// Pages are refetched after this long even when the version didn't change,
+// which also covers backends that don't send versions.
+const qint64 PAGE_MAX_AGE = 5 * 60 * 1000;
+
+// Versions are "epoch.counter" and the counters of two backends (or of one
+// backend before and after a restart) have nothing to do with each other.
+QString getVersionEpoch(const QString &version) {
+  return version.section('.', 0, 0);
+}
+} // namespace
+
+ScheduleCache::ScheduleCache(int roomId, const Clock *clock,
+                             QNetworkAccessManager *networkManager,
+                             QObject *parent)
+    : QObject{parent}, m_clock(clock), m_networkManager(networkManager),
+      m_isCaching(false), m_roomId(roomId) {
+  QSettings settings;
+  // Only the primary endpoint, a week view that is a bit late after a
+  // failover isn't worth the bookkeeping of the polls.
+  m_apiAddress = settings.value(API_ADDRESS_SETTING)
+                     .toString()
+                     .section(',', 0, 0)
+                     .trimmed();
+  m_timeZoneText = DataFetchingHandler::getSystemTimezoneId();
+}
+
+void ScheduleCache::startCaching() {
+  m_isCaching = true;
+  // Today and tomorrow are what the week view opens on and pages to first.
+  prefetchDay(0);
+  prefetchDay(1);
+}
+
+void ScheduleCache::requestDay(int dayOffset) {
+  dayOffset = qBound(0, dayOffset, WEEK_DAY_COUNT - 1);
+  evictPastPages();
+
+  ScheduleDayPage page = m_pages.value(getDate(dayOffset));
+  if (page.date.isValid()) {
+    page.isStale = isStale(page);
+  }
+  emit dayPageChanged(dayOffset, page);
+
+  prefetchDay(dayOffset);
+  prefetchDay(dayOffset - 1);
+  prefetchDay(dayOffset + 1);
+}
+
+void ScheduleCache::setScheduleVersion(const QString &scheduleVersion) {
+  if (scheduleVersion == m_scheduleVersion) {
+    return;
+  }
+
+  // Every page is stale now, but only the ones the week view opens on are
+  // refreshed right away. The others are once they are paged to.
+  m_scheduleVersion = scheduleVersion;
+  prefetchDay(0);
+  prefetchDay(1);
+}
+
+void ScheduleCache::prefetchDay(int dayOffset) {
+  if (!m_isCaching || dayOffset < 0 || dayOffset >= WEEK_DAY_COUNT) {
+    return;
+  }
+
+  QDate date = getDate(dayOffset);
+  if (m_datesBeingFetched.contains(date)) {
+    return;
+  }
+  auto page = m_pages.constFind(date);
+  if (page != m_pages.constEnd() && !isStale(*page)) {
+    return;
+  }
+  fetchDay(date);
+}
+
+void ScheduleCache::fetchDay(const QDate &date) {
+  m_datesBeingFetched.insert(date);
+  QNetworkRequest request(QUrl(m_apiAddress + "/rooms/" +
+                               QString::number(m_roomId) + "/" +
+                               m_timeZoneText + "/days/" +
+                               date.toString(Qt::ISODate)));
+  QNetworkReply *reply = m_networkManager->get(request);
+  reply->setProperty("date", date);
+  connect(reply, &QNetworkReply::finished, this,
+          [this, reply]() { onDayRequestFinished(reply); });
+}
+
+void ScheduleCache::onDayRequestFinished(QNetworkReply *reply) {
+  reply->deleteLater();
+  QDate date = reply->property("date").toDate();
+  m_datesBeingFetched.remove(date);
+
+  if (reply->error()) {
+    // Whatever was cached stays, the next request for the day retries.
+    qCWarning(lcNetwork) << "Could not fetch the schedule of" << date << ":"
+                         << reply->errorString();
+    return;
+  }
+
+  QJsonObject dayObject = QJsonDocument::fromJson(reply->readAll()).object();
+  ScheduleDayPage page;
+  page.date = date;
+  page.version = dayObject["version"].toString();
+  page.fetchedAt = m_clock->currentMSecsSinceEpoch();
+  const QJsonArray bookings = dayObject["bookings"].toArray();
+  for (const QJsonValue &bookingValue : bookings) {
+    QJsonObject bookingObject = bookingValue.toObject();
+    UpcomingBookingData booking;
+    booking.id = bookingObject["id"].toString();
+    booking.name = bookingObject["name"].toString();
+    booking.startTime = bookingObject["start_time"].toInteger();
+    booking.endTime = bookingObject["end_time"].toInteger();
+    booking.timeString = getTimeString(booking.startTime, booking.endTime);
+    page.bookings.append(booking);
+  }
+
+  m_pages.insert(date, page);
+  int dayOffset = getDayOffset(date);
+  if (dayOffset >= 0 && dayOffset < WEEK_DAY_COUNT) {
+    emit dayPageChanged(dayOffset, page);
+  }
+}
+
+bool ScheduleCache::isStale(const ScheduleDayPage &page) const {
+  // Pages always come from the primary endpoint while the version comes from
+  // whichever endpoint is polled, so only versions of the same epoch say
+  // anything. Otherwise the page ages out like an unversioned one.
+  if (!m_scheduleVersion.isEmpty() &&
+      getVersionEpoch(page.version) == getVersionEpoch(m_scheduleVersion) &&
+      page.version != m_scheduleVersion) {
+    return true;
+  }
+  return m_clock->currentMSecsSinceEpoch() - page.fetchedAt > PAGE_MAX_AGE;
+}
+
+void ScheduleCache::evictPastPages() {
+  for (auto it = m_pages.begin(); it != m_pages.end();) {
+    int dayOffset = getDayOffset(it.key());
+    if (dayOffset < 0 || dayOffset >= WEEK_DAY_COUNT) {
+      it = m_pages.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+QDate ScheduleCache::getDate(int dayOffset) const {
+  return m_clock->toDateTime(m_clock->currentSecsSinceEpoch())
+      .date()
+      .addDays(dayOffset);
+}
+
+int ScheduleCache::getDayOffset(const QDate &date) const {
+  return getDate(0).daysTo(date);
+}
+
+QString ScheduleCache::getTimeString(qint64 startTime, qint64 endTime) const {
+  // End times are the last second of a booking.
+  return m_clock->toDateTime(startTime).toString("hh:mm") + " - " +
+         m_clock->toDateTime(endTime + 1).toString("hh:mm");
+}
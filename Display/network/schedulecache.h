@@ -0,0 +1,53 @@
+#ifndef SCHEDULECACHE_H
+#define SCHEDULECACHE_H
+
+#include "../datatypes.h"
+#include "../timing/clock.h"
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+// Day pages of this room's schedule for the week view. Requesting a day
+// answers right away with whatever is cached, even when it is stale, and
+// fetches in the background whatever is missing or stale for that day and
+// the days next to it, so paging through the week never waits on the
+// network. Pages go stale when the schedule version seen by the polls moves
+// on. Lives on the data fetching thread.
+class ScheduleCache : public QObject {
+  Q_OBJECT
+public:
+  ScheduleCache(int roomId, const Clock *clock,
+                QNetworkAccessManager *networkManager,
+                QObject *parent = nullptr);
+  void startCaching();
+  void requestDay(int dayOffset);
+  void setScheduleVersion(const QString &scheduleVersion);
+
+signals:
+  // Also emitted with an empty page (invalid date) while a day is loading.
+  void dayPageChanged(int dayOffset, const ScheduleDayPage &page);
+
+private:
+  const Clock *m_clock;
+  QNetworkAccessManager *m_networkManager;
+  QMap<QDate, ScheduleDayPage> m_pages;
+  QSet<QDate> m_datesBeingFetched;
+  bool m_isCaching;
+  QString m_scheduleVersion;
+  QString m_apiAddress;
+  int m_roomId;
+  QString m_timeZoneText;
+
+  void prefetchDay(int dayOffset);
+  void fetchDay(const QDate &date);
+  void onDayRequestFinished(QNetworkReply *reply);
+  bool isStale(const ScheduleDayPage &page) const;
+  void evictPastPages();
+  QDate getDate(int dayOffset) const;
+  int getDayOffset(const QDate &date) const;
+  QString getTimeString(qint64 startTime, qint64 endTime) const;
+};
+
+#endif // SCHEDULECACHE_H
@@ -0,0 +1,388 @@
+import QtQuick
+
+// Same layout and choreography as the widget frontend. The texts shown are
+// copies that get swapped halfway through each transition, so the fade out
+// still shows the old value.
+Rectangle {
+    id: root
+
+    readonly property real bottomSectionHeight: height / 5
+
+    color: frontend.backgroundColor
+
+    Item {
+        id: topSection
+
+        x: 15
+        width: parent.width - 15
+        height: parent.height - root.bottomSectionHeight
+
+        Item {
+            id: leftSide
+
+            width: parent.width * 3 / 4
+            height: parent.height
+
+            Text {
+                id: bookingName
+
+                x: 9
+                y: 9
+                width: parent.width - 18
+                color: "white"
+                font: frontend.nameFont
+                wrapMode: Text.WordWrap
+                maximumLineCount: 3
+
+                Component.onCompleted: text = frontend.bookingName
+            }
+
+            Text {
+                id: bookingInfo
+
+                x: 9
+                anchors.bottom: parent.bottom
+                anchors.bottomMargin: 9
+                width: parent.width - 18
+                color: "white"
+                font: frontend.infoFont
+                wrapMode: Text.WordWrap
+
+                Component.onCompleted: text = frontend.bookingInfo
+            }
+        }
+
+        Column {
+            id: upcomingBookings
+
+            x: leftSide.width + 9
+            y: 9
+            width: parent.width - leftSide.width - 18
+
+            Repeater {
+                id: upcomingBookingRepeater
+
+                model: 3
+
+                Item {
+                    id: upcomingBooking
+
+                    property string timeString: ""
+                    property string name: ""
+                    property real baseOpacity: [1.0, 0.6, 0.4][index]
+
+                    width: upcomingBookings.width
+                    height: upcomingBookingColumn.height + 18
+                    opacity: baseOpacity
+                    transform: Translate {
+                        id: upcomingBookingTranslate
+                    }
+
+                    Column {
+                        id: upcomingBookingColumn
+
+                        width: parent.width
+                        spacing: 6
+
+                        Text {
+                            width: parent.width
+                            color: "black"
+                            font: frontend.upcomingBoldFont
+                            text: upcomingBooking.timeString
+                        }
+
+                        Text {
+                            width: parent.width
+                            color: "black"
+                            font: frontend.upcomingLightFont
+                            wrapMode: Text.WordWrap
+                            maximumLineCount: 2
+                            text: upcomingBooking.name
+                        }
+                    }
+
+                    // Staggered so the bottom booking fades first and the
+                    // top one last, mirroring the widget keyframes.
+                    SequentialAnimation {
+                        id: upcomingBookingTransition
+
+                        PauseAnimation {
+                            duration: [1000, 500, 0][index]
+                        }
+                        NumberAnimation {
+                            target: upcomingBooking
+                            property: "opacity"
+                            to: 0.0
+                            duration: 1000
+                        }
+                        PauseAnimation {
+                            duration: [0, 500, 1000][index]
+                        }
+                        ScriptAction {
+                            script: {
+                                let bookingData = frontend.upcomingBookings[index];
+                                upcomingBooking.timeString = bookingData ? bookingData.timeString : "";
+                                upcomingBooking.name = bookingData ? bookingData.name : "";
+                            }
+                        }
+                        PauseAnimation {
+                            duration: [600, 300, 0][index]
+                        }
+                        NumberAnimation {
+                            target: upcomingBooking
+                            property: "opacity"
+                            to: upcomingBooking.baseOpacity
+                            duration: 1000
+                        }
+                    }
+
+                    SequentialAnimation {
+                        id: slideUpAnimation
+
+                        PauseAnimation {
+                            duration: 1100
+                        }
+                        NumberAnimation {
+                            target: upcomingBookingTranslate
+                            property: "y"
+                            to: -159
+                            duration: 1200
+                            easing.type: Easing.InCubic
+                        }
+                        PropertyAction {
+                            target: upcomingBookingTranslate
+                            property: "y"
+                            value: 0
+                        }
+                    }
+
+                    Connections {
+                        function onUpcomingBookingsDisplayed() {
+                            upcomingBookingTransition.restart();
+                            if (index === 0 && frontend.firstUpcomingBookingStarted)
+                                slideUpAnimation.restart();
+                        }
+
+                        target: frontend
+                    }
+                }
+            }
+        }
+    }
+
+    Item {
+        id: bottomSection
+
+        property color displayedStatusColor: frontend.unbookedColor
+        property color nextStatusColor: frontend.unbookedColor
+        property real slideProgress: 0.0
+
+        anchors.bottom: parent.bottom
+        width: parent.width
+        height: root.bottomSectionHeight
+
+        Rectangle {
+            anchors.fill: parent
+            color: bottomSection.displayedStatusColor
+        }
+
+        Rectangle {
+            anchors.right: parent.right
+            width: parent.width * bottomSection.slideProgress
+            height: parent.height
+            color: bottomSection.nextStatusColor
+        }
+
+        Text {
+            id: bookingStatus
+
+            x: 15 + 9 + 9
+            anchors.verticalCenter: parent.verticalCenter
+            color: "white"
+            font: frontend.statusFont
+
+            Component.onCompleted: text = frontend.bookingStatus
+        }
+
+        Image {
+            anchors.right: parent.right
+            anchors.rightMargin: 20
+            anchors.verticalCenter: parent.verticalCenter
+            width: 64
+            height: 64
+            sourceSize: Qt.size(64, 64)
+            fillMode: Image.PreserveAspectFit
+            asynchronous: true
+            source: frontend.iconSource
+
+            MouseArea {
+                anchors.fill: parent
+                onClicked: frontend.requestSettingsWindow()
+            }
+        }
+    }
+
+    Rectangle {
+        x: parent.width * 2 / 3
+        width: parent.width / 3
+        height: parent.height
+
+        gradient: Gradient {
+            orientation: Gradient.Horizontal
+
+            GradientStop {
+                position: 0.0
+                color: Qt.rgba(1, 1, 1, 0)
+            }
+            GradientStop {
+                position: 1.0
+                color: Qt.rgba(1, 1, 1, 90 / 255)
+            }
+        }
+    }
+
+    // Shown while the bookings may be out of date, same as the widget frontend.
+    Rectangle {
+        anchors.top: parent.top
+        anchors.right: parent.right
+        anchors.margins: 12
+        width: 14
+        height: 14
+        radius: 7
+        color: Qt.rgba(1, 1, 1, 110 / 255)
+        visible: frontend.isStale
+    }
+
+    SequentialAnimation {
+        id: nameTransition
+
+        ParallelAnimation {
+            NumberAnimation {
+                target: bookingName
+                property: "opacity"
+                to: 0.0
+                duration: 500
+                easing.type: Easing.InOutQuad
+            }
+            NumberAnimation {
+                target: bookingName
+                property: "y"
+                from: 9
+                to: 30
+                duration: 500
+                easing.type: Easing.InOutQuad
+            }
+        }
+        PropertyAction {
+            target: bookingName
+            property: "text"
+            value: frontend.bookingName
+        }
+        ParallelAnimation {
+            NumberAnimation {
+                target: bookingName
+                property: "opacity"
+                from: 0.0
+                to: 1.0
+                duration: 1000
+            }
+            NumberAnimation {
+                target: bookingName
+                property: "y"
+                from: -30
+                to: 9
+                duration: 800
+                easing.type: Easing.OutQuad
+            }
+        }
+    }
+
+    SequentialAnimation {
+        id: infoTransition
+
+        NumberAnimation {
+            target: bookingInfo
+            property: "opacity"
+            to: 0.0
+            duration: 500
+            easing.type: Easing.InOutQuad
+        }
+        PropertyAction {
+            target: bookingInfo
+            property: "text"
+            value: frontend.bookingInfo
+        }
+        NumberAnimation {
+            target: bookingInfo
+            property: "opacity"
+            from: 0.0
+            to: 1.0
+            duration: 1000
+        }
+    }
+
+    SequentialAnimation {
+        id: statusTransition
+
+        NumberAnimation {
+            target: bookingStatus
+            property: "opacity"
+            to: 0.0
+            duration: 240
+            easing.type: Easing.InOutQuad
+        }
+        PauseAnimation {
+            duration: 560
+        }
+        PropertyAction {
+            target: bookingStatus
+            property: "text"
+            value: frontend.bookingStatus
+        }
+        NumberAnimation {
+            target: bookingStatus
+            property: "opacity"
+            from: 0.0
+            to: 1.0
+            duration: 800
+        }
+    }
+
+    SequentialAnimation {
+        id: statusColorTransition
+
+        PropertyAction {
+            target: bottomSection
+            property: "nextStatusColor"
+            value: frontend.statusColor
+        }
+        NumberAnimation {
+            target: bottomSection
+            property: "slideProgress"
+            from: 0.0
+            to: 1.0
+            duration: 700
+        }
+        PropertyAction {
+            target: bottomSection
+            property: "displayedStatusColor"
+            value: bottomSection.nextStatusColor
+        }
+        PropertyAction {
+            target: bottomSection
+            property: "slideProgress"
+            value: 0.0
+        }
+    }
+
+    Connections {
+        function onCurrentBookingDisplayed() {
+            nameTransition.restart();
+            infoTransition.restart();
+            statusTransition.restart();
+            statusColorTransition.restart();
+        }
+
+        target: frontend
+    }
+}
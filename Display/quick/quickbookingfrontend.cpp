@@ -0,0 +1,171 @@
+#include "quickbookingfrontend.h"
+#include "../settingstrings.h"
+#include <QFile>
+#include <QIcon>
+#include <QQmlContext>
+#include <QQuickView>
+#include <QQuickWindow>
+#include <QSGRendererInterface>
+#include <QSettings>
+#include <QTimer>
+#include <QVariantMap>
+
+QuickBookingFrontend::QuickBookingFrontend(QObject *parent)
+    : QObject{parent}, m_view(new QQuickView()),
+      m_displayedSequenceNumber(0), m_firstUpcomingBookingStarted(false),
+      m_isStale(false) {
+  retrieveSettings();
+
+  QSettings settings;
+  m_displayedCurrentBooking.state = CurrentBookingState::UNBOOKED;
+  m_displayedCurrentBooking.name =
+      settings.value(UNBOOKED_NAME_TEXT_SETTING).toString();
+  m_displayedCurrentBooking.info =
+      settings.value(UNBOOKED_INFO_TEXT_SETTING).toString();
+  m_displayedCurrentBooking.status =
+      settings.value(UNBOOKED_STATUS_TEXT_SETTING).toString();
+
+  m_view->setTitle("BreakTools Room Booker");
+  m_view->setIcon(QIcon(":/icon.png"));
+  m_view->setColor(m_backgroundColor);
+  m_view->setCursor(Qt::BlankCursor);
+  m_view->setResizeMode(QQuickView::SizeRootObjectToView);
+  m_view->rootContext()->setContextProperty("frontend", this);
+  m_view->setSource(QUrl("qrc:/quick/BookingDisplay.qml"));
+}
+
+QuickBookingFrontend::~QuickBookingFrontend() { delete m_view; }
+
+void QuickBookingFrontend::configureSoftwareRendering() {
+  // Has to happen before the first QQuickWindow gets created.
+  QQuickWindow::setGraphicsApi(QSGRendererInterface::Software);
+}
+
+void QuickBookingFrontend::show() { m_view->showFullScreen(); }
+
+QQuickWindow *QuickBookingFrontend::window() const { return m_view; }
+
+void QuickBookingFrontend::retrieveSettings() {
+  QSettings settings;
+  m_backgroundColor = settings.value(BACKGROUND_COLOR_SETTING).value<QColor>();
+  m_unbookedColor = settings.value(UNBOOKED_COLOR_SETTING).value<QColor>();
+  m_bookedColor = settings.value(BOOKED_COLOR_SETTING).value<QColor>();
+
+  m_nameFont = settings.value(BOOKNG_NAME_FONT_SETTING).value<QFont>();
+  m_infoFont = settings.value(BOOKING_INFO_FONT_SETTING).value<QFont>();
+  m_statusFont = settings.value(BOOKING_STATUS_FONT_SETTING).value<QFont>();
+  m_upcomingBoldFont =
+      settings.value(UPCOMING_BOOKINGS_BOLD_FONT_SETTING).value<QFont>();
+  m_upcomingLightFont =
+      settings.value(UPCOMING_BOOKINGS_LIGHT_FONT_SETTING).value<QFont>();
+
+  m_nameMaxCharacters = settings.value(BOOKING_NAME_MAX_CHARACTERS).toInt();
+  m_infoMaxCharacters =
+      settings.value(BOOKING_USERNAME_MAX_CHARACTERS).toInt();
+  m_upcomingNameMaxCharacters =
+      settings.value(UPCOMING_BOOKING_NAME_MAX_CHARACTERS).toInt();
+
+  QString iconPath = settings.value(ICON_FILE_PATH_SETTING).toString();
+  if (!QFile::exists(iconPath)) {
+    iconPath = QString(":/resources/defaulticon.png");
+  }
+  m_iconSource = iconPath.startsWith(":") ? QUrl("qrc" + iconPath)
+                                          : QUrl::fromLocalFile(iconPath);
+}
+
+void QuickBookingFrontend::updateDisplayState(
+    const DisplayState &displayState) {
+  if (displayState.sequenceNumber() <= m_displayedSequenceNumber) {
+    return;
+  }
+  m_displayedSequenceNumber = displayState.sequenceNumber();
+  if (displayState.isStale() != m_isStale) {
+    m_isStale = displayState.isStale();
+    emit staleChanged();
+  }
+
+  if (displayState.upcomingBookingsChanged()) {
+    displayUpcomingBookings(displayState);
+  }
+
+  if (displayState.currentBookingChanged()) {
+    // Same delay as the widget frontend, so the upcoming bookings animate
+    // first.
+    QTimer::singleShot(1600, this, [this, displayState]() {
+      displayCurrentBooking(displayState.currentBooking());
+    });
+  }
+}
+
+void QuickBookingFrontend::displayCurrentBooking(
+    const CurrentBookingData &newCurrentBooking) {
+  m_displayedCurrentBooking = newCurrentBooking;
+  m_displayedCurrentBooking.name =
+      getTruncatedText(newCurrentBooking.name, m_nameMaxCharacters);
+  m_displayedCurrentBooking.info =
+      getTruncatedText(newCurrentBooking.info, m_infoMaxCharacters);
+  emit currentBookingDisplayed();
+}
+
+void QuickBookingFrontend::displayUpcomingBookings(
+    const DisplayState &displayState) {
+  m_firstUpcomingBookingStarted =
+      !m_displayedUpcomingBookings.isEmpty() &&
+      m_displayedUpcomingBookings[0].id == displayState.currentBooking().id;
+  m_displayedUpcomingBookings = displayState.upcomingBookings();
+  emit upcomingBookingsDisplayed();
+}
+
+QString QuickBookingFrontend::bookingName() const {
+  return m_displayedCurrentBooking.name;
+}
+
+QString QuickBookingFrontend::bookingInfo() const {
+  return m_displayedCurrentBooking.info;
+}
+
+QString QuickBookingFrontend::bookingStatus() const {
+  return m_displayedCurrentBooking.status;
+}
+
+QColor QuickBookingFrontend::statusColor() const {
+  if (m_displayedCurrentBooking.state == CurrentBookingState::UNBOOKED) {
+    return m_unbookedColor;
+  }
+  if (m_displayedCurrentBooking.state == CurrentBookingState::BOOKED) {
+    return m_bookedColor;
+  }
+  return QColor(0, 0, 0);
+}
+
+QVariantList QuickBookingFrontend::upcomingBookings() const {
+  QVariantList upcomingBookings;
+  for (const UpcomingBookingData &upcomingBooking :
+       m_displayedUpcomingBookings) {
+    QVariantMap upcomingBookingMap;
+    upcomingBookingMap["timeString"] = upcomingBooking.timeString;
+    upcomingBookingMap["name"] =
+        getTruncatedText(upcomingBooking.name, m_upcomingNameMaxCharacters);
+    upcomingBookings.append(upcomingBookingMap);
+  }
+  return upcomingBookings;
+}
+
+bool QuickBookingFrontend::firstUpcomingBookingStarted() const {
+  return m_firstUpcomingBookingStarted;
+}
+
+bool QuickBookingFrontend::isStale() const { return m_isStale; }
+
+void QuickBookingFrontend::requestSettingsWindow() {
+  emit settingsWindowRequested();
+}
+
+QString QuickBookingFrontend::getTruncatedText(QString text,
+                                               int maxCharacters) const {
+  if (text.size() > maxCharacters) {
+    text.resize(maxCharacters);
+    text.append("...");
+  }
+  return text;
+}
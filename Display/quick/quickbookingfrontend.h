@@ -0,0 +1,93 @@
+#ifndef QUICKBOOKINGFRONTEND_H
+#define QUICKBOOKINGFRONTEND_H
+
+#include "../datatypes.h"
+#include <QColor>
+#include <QFont>
+#include <QObject>
+#include <QUrl>
+#include <QVariantList>
+
+class QQuickView;
+class QQuickWindow;
+
+// Alternative to the QWidget tree, rendered by Qt Quick's software scene
+// graph backend. It shows the same layout as
+// BookingDisplay::configureWidgetLayout(), but only the regions that change
+// during an animation get re-rasterized. All display logic stays in C++; the
+// QML file only lays out and animates what this object exposes.
+class QuickBookingFrontend : public QObject {
+  Q_OBJECT
+  Q_PROPERTY(QString bookingName READ bookingName NOTIFY currentBookingDisplayed)
+  Q_PROPERTY(QString bookingInfo READ bookingInfo NOTIFY currentBookingDisplayed)
+  Q_PROPERTY(
+      QString bookingStatus READ bookingStatus NOTIFY currentBookingDisplayed)
+  Q_PROPERTY(QColor statusColor READ statusColor NOTIFY currentBookingDisplayed)
+  Q_PROPERTY(QVariantList upcomingBookings READ upcomingBookings NOTIFY
+                 upcomingBookingsDisplayed)
+  Q_PROPERTY(bool firstUpcomingBookingStarted READ firstUpcomingBookingStarted
+                 NOTIFY upcomingBookingsDisplayed)
+  Q_PROPERTY(bool isStale READ isStale NOTIFY staleChanged)
+  Q_PROPERTY(QColor backgroundColor MEMBER m_backgroundColor CONSTANT)
+  Q_PROPERTY(QColor unbookedColor MEMBER m_unbookedColor CONSTANT)
+  Q_PROPERTY(QFont nameFont MEMBER m_nameFont CONSTANT)
+  Q_PROPERTY(QFont infoFont MEMBER m_infoFont CONSTANT)
+  Q_PROPERTY(QFont statusFont MEMBER m_statusFont CONSTANT)
+  Q_PROPERTY(QFont upcomingBoldFont MEMBER m_upcomingBoldFont CONSTANT)
+  Q_PROPERTY(QFont upcomingLightFont MEMBER m_upcomingLightFont CONSTANT)
+  Q_PROPERTY(QUrl iconSource MEMBER m_iconSource CONSTANT)
+
+public:
+  explicit QuickBookingFrontend(QObject *parent = nullptr);
+  ~QuickBookingFrontend();
+  static void configureSoftwareRendering();
+  void show();
+  QQuickWindow *window() const;
+
+  void updateDisplayState(const DisplayState &displayState);
+
+  QString bookingName() const;
+  QString bookingInfo() const;
+  QString bookingStatus() const;
+  QColor statusColor() const;
+  QVariantList upcomingBookings() const;
+  bool firstUpcomingBookingStarted() const;
+  bool isStale() const;
+
+  Q_INVOKABLE void requestSettingsWindow();
+
+signals:
+  void currentBookingDisplayed();
+  void upcomingBookingsDisplayed();
+  void staleChanged();
+  void settingsWindowRequested();
+
+private:
+  // A window can't have a QObject parent, so this one is deleted by hand.
+  QQuickView *m_view;
+  CurrentBookingData m_displayedCurrentBooking;
+  QList<UpcomingBookingData> m_displayedUpcomingBookings;
+  quint64 m_displayedSequenceNumber;
+  bool m_firstUpcomingBookingStarted;
+  bool m_isStale;
+
+  QColor m_backgroundColor;
+  QColor m_unbookedColor;
+  QColor m_bookedColor;
+  QFont m_nameFont;
+  QFont m_infoFont;
+  QFont m_statusFont;
+  QFont m_upcomingBoldFont;
+  QFont m_upcomingLightFont;
+  QUrl m_iconSource;
+  int m_nameMaxCharacters;
+  int m_infoMaxCharacters;
+  int m_upcomingNameMaxCharacters;
+
+  void retrieveSettings();
+  void displayCurrentBooking(const CurrentBookingData &newCurrentBooking);
+  void displayUpcomingBookings(const DisplayState &displayState);
+  QString getTruncatedText(QString text, int maxCharacters) const;
+};
+
+#endif // QUICKBOOKINGFRONTEND_H
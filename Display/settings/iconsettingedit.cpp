@@ -1,30 +1,34 @@
 #include "iconsettingedit.h"
+#include "../assets/assetcache.h"
+#include <QFile>
 #include <QFileDialog>
 #include <QLabel>
 #include <QMouseEvent>
 #include <QVBoxLayout>
 
 IconSettingEdit::IconSettingEdit(QString textToDisplay, QString settingString,
-                                 QWidget *parent)
+                                 QString fallbackPath, QWidget *parent)
     : QWidget(parent), m_settingString(settingString),
       m_settings(new QSettings(this)) {
   QVBoxLayout *layout = new QVBoxLayout(this);
   QLabel *titleLabel = new QLabel(textToDisplay, this);
   layout->addWidget(titleLabel);
 
-  QString storedPath = m_settings->value(m_settingString).toString();
-  if (!QFile::exists(storedPath)) {
-    storedPath = QString(":/resources/defaulticon.png");
+  m_currentPath = m_settings->value(m_settingString).toString();
+  if (!QFile::exists(m_currentPath)) {
+    m_currentPath = fallbackPath;
   }
 
-  m_currentPixmap.load(storedPath);
   m_iconLabel = new QLabel(this);
-  m_iconLabel->setPixmap(m_currentPixmap.scaled(64, 64, Qt::KeepAspectRatio,
-                                                Qt::SmoothTransformation));
+  m_iconLabel->setMinimumSize(64, 64);
+  if (m_currentPath.isEmpty()) {
+    m_iconLabel->setText("Click me!");
+  }
   m_iconLabel->installEventFilter(this);
   layout->addWidget(m_iconLabel);
 
   setLayout(layout);
+  updateIconDisplay();
 }
 
 bool IconSettingEdit::eventFilter(QObject *obj, QEvent *event) {
@@ -43,13 +47,25 @@ void IconSettingEdit::selectIcon() {
   QString fileName = QFileDialog::getOpenFileName(
       this, tr("Select Icon"), QString(), tr("PNG Files (*.png)"));
   if (!fileName.isEmpty()) {
-    m_currentPixmap.load(fileName);
+    m_currentPath = fileName;
     m_settings->setValue(m_settingString, fileName);
     updateIconDisplay();
   }
 }
 
 void IconSettingEdit::updateIconDisplay() {
-  m_iconLabel->setPixmap(m_currentPixmap.scaled(64, 64, Qt::KeepAspectRatio,
-                                                Qt::SmoothTransformation));
+  if (m_currentPath.isEmpty()) {
+    return;
+  }
+
+  QString requestedPath = m_currentPath;
+  AssetCache::instance()->requestPixmap(
+      m_currentPath, QSize(64, 64), this->devicePixelRatioF(),
+      Qt::KeepAspectRatio, m_iconLabel,
+      [this, requestedPath](const QPixmap &scaledIconPixmap) {
+        // Another icon might have been picked while this one was loading.
+        if (requestedPath == m_currentPath) {
+          m_iconLabel->setPixmap(scaledIconPixmap);
+        }
+      });
 }
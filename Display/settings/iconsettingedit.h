@@ -1,7 +1,6 @@
 #ifndef ICONSETTINGEDIT_H
 #define ICONSETTINGEDIT_H
 
-#include <QPixmap>
 #include <QSettings>
 #include <QWidget>
 
@@ -10,8 +9,10 @@ class QLabel;
 class IconSettingEdit : public QWidget {
   Q_OBJECT
 public:
-  explicit IconSettingEdit(QString textToDisplay, QString settingString,
-                           QWidget *parent = nullptr);
+  explicit IconSettingEdit(
+      QString textToDisplay, QString settingString,
+      QString fallbackPath = QString(":/resources/defaulticon.png"),
+      QWidget *parent = nullptr);
 
 protected:
   bool eventFilter(QObject *obj, QEvent *event) override;
@@ -22,7 +23,7 @@ private:
 
   QString m_settingString;
   QSettings *m_settings;
-  QPixmap m_currentPixmap;
+  QString m_currentPath;
   QLabel *m_iconLabel;
 };
 
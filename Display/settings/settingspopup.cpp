@@ -1,4 +1,5 @@
 #include "settingspopup.h"
+#include "../diagnostics/logging.h"
 #include "../settingstrings.h"
 #include "colorsettingedit.h"
 #include "fontsettingedit.h"
@@ -31,13 +32,18 @@ void SettingsPopup::populateWidgets() {
   layout->setAlignment(Qt::AlignTop);
 
   TextSettingEdit *apiEdit =
-      new TextSettingEdit("API Address", API_ADDRESS_SETTING);
+      new TextSettingEdit("API Address (comma separated for standbys)",
+                          API_ADDRESS_SETTING);
   layout->addWidget(apiEdit);
 
   IntegerSettingEdit *roomIdEdit =
       new IntegerSettingEdit("Room ID", ROOM_ID_SETTING, 100000);
   layout->addWidget(roomIdEdit);
 
+  TextSettingEdit *bookNowTokenEdit =
+      new TextSettingEdit("Book now token", BOOK_NOW_TOKEN_SETTING);
+  layout->addWidget(bookNowTokenEdit);
+
   TextSettingEdit *unbookedNameEdit =
       new TextSettingEdit("Unbooked large text", UNBOOKED_NAME_TEXT_SETTING);
   layout->addWidget(unbookedNameEdit);
@@ -54,6 +60,14 @@ void SettingsPopup::populateWidgets() {
       "Booked username prefix text", BOOKED_USERNAME_PREFIX_TEXT_SETTING);
   layout->addWidget(bookedUsernamePrefixEdit);
 
+  TextSettingEdit *bookNowNameEdit =
+      new TextSettingEdit("Book now booking name", BOOK_NOW_NAME_TEXT_SETTING);
+  layout->addWidget(bookNowNameEdit);
+
+  TextSettingEdit *bookNowUserEdit =
+      new TextSettingEdit("Book now username", BOOK_NOW_USER_TEXT_SETTING);
+  layout->addWidget(bookNowUserEdit);
+
   IntegerSettingEdit *bookingNameMaxCharactersEdit = new IntegerSettingEdit(
       "Max booking name characters", BOOKING_NAME_MAX_CHARACTERS, 2000);
   layout->addWidget(bookingNameMaxCharactersEdit);
@@ -101,6 +115,13 @@ void SettingsPopup::populateWidgets() {
       new IconSettingEdit("Select icon", ICON_FILE_PATH_SETTING);
   layout->addWidget(iconEdit);
 
+  IconSettingEdit *unbookedBackgroundEdit = new IconSettingEdit(
+      "Unbooked background image", UNBOOKED_BACKGROUND_IMAGE_SETTING, "");
+  layout->addWidget(unbookedBackgroundEdit);
+  IconSettingEdit *bookedBackgroundEdit = new IconSettingEdit(
+      "Booked background image", BOOKED_BACKGROUND_IMAGE_SETTING, "");
+  layout->addWidget(bookedBackgroundEdit);
+
   scrollLayout->addLayout(layout);
   scrollWidget->setLayout(scrollLayout);
   mainLayout->addWidget(scrollArea);
@@ -146,6 +167,7 @@ QWidget *SettingsPopup::getBottomButtons() {
 }
 
 void SettingsPopup::restartProgram() {
+  qCInfo(lcSettings) << "Restarting to apply the changed settings";
   QString program = qApp->arguments()[0];
   QStringList arguments = qApp->arguments();
   QProcess::startDetached(program, arguments);
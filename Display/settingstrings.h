@@ -5,12 +5,20 @@
 
 const QString API_ADDRESS_SETTING = "api/address";
 const QString ROOM_ID_SETTING = "api/roomId";
+const QString API_HEDGE_DELAY_SETTING = "api/hedgeDelayMs";
+const QString API_POLL_INTERVAL_SETTING = "api/pollIntervalMs";
+// Failed polls only show the error once either of these is reached.
+const QString API_ERROR_AFTER_FAILURES_SETTING = "api/errorAfterFailures";
+const QString API_ERROR_AFTER_TIME_SETTING = "api/errorAfterMs";
 
 const QString UNBOOKED_NAME_TEXT_SETTING = "texts/unbookedName";
 const QString UNBOOKED_INFO_TEXT_SETTING = "texts/unbookedInfo";
 const QString UNBOOKED_STATUS_TEXT_SETTING = "texts/unbookedStatus";
 const QString BOOKED_USERNAME_PREFIX_TEXT_SETTING =
     "texts/bookedUsernamePrefix";
+const QString BOOK_NOW_NAME_TEXT_SETTING = "texts/bookNowName";
+const QString BOOK_NOW_USER_TEXT_SETTING = "texts/bookNowUser";
+const QString BOOK_NOW_REFUSED_TEXT_SETTING = "texts/bookNowRefused";
 
 const QString BOOKING_NAME_MAX_CHARACTERS = "texts/nameMaxChars";
 const QString BOOKING_USERNAME_MAX_CHARACTERS = "texts/usernameMaxChars";
@@ -25,7 +33,66 @@ const QString BOOKING_INFO_FONT_SETTING = "fonts/info";
 const QString BOOKING_STATUS_FONT_SETTING = "fonts/status";
 const QString UPCOMING_BOOKINGS_BOLD_FONT_SETTING = "fonts/upcomingBold";
 const QString UPCOMING_BOOKINGS_LIGHT_FONT_SETTING = "fonts/upcomingLight";
+// Comma separated families tried in order for characters the fonts above
+// don't have. Font files in the directory are loaded at startup, so an emoji
+// font can be shipped next to the executable.
+const QString FALLBACK_FONT_FAMILIES_SETTING = "fonts/fallbackFamilies";
+const QString FALLBACK_FONT_DIRECTORY_SETTING = "fonts/fallbackDirectory";
 
 const QString ICON_FILE_PATH_SETTING = "icon/filePath";
 
+const QString UNBOOKED_BACKGROUND_IMAGE_SETTING = "images/unbookedBackground";
+const QString BOOKED_BACKGROUND_IMAGE_SETTING = "images/bookedBackground";
+
+// Profile pictures of the bookers, fetched through the display API.
+const QString AVATARS_ENABLED_SETTING = "avatars/enabled";
+const QString AVATAR_DISK_CACHE_SIZE_SETTING = "avatars/diskCacheSizeKb";
+
+const QString MEASURE_EVENT_LOOP_STALLS_SETTING =
+    "diagnostics/measureEventLoopStalls";
+const QString METRICS_PORT_SETTING = "diagnostics/metricsPort";
+const QString RECORD_PAYLOADS_PATH_SETTING = "diagnostics/recordPayloadsPath";
+const QString OCCUPANCY_HISTORY_PATH_SETTING =
+    "diagnostics/occupancyHistoryPath";
+
+// Logging to files is off when the directory is empty. The maximum file size
+// is in kilobytes, the rate limit is per category and level.
+const QString LOG_DIRECTORY_SETTING = "logging/directory";
+const QString LOG_LEVEL_SETTING = "logging/level";
+const QString LOG_MAX_FILE_SIZE_SETTING = "logging/maxFileSizeKb";
+const QString LOG_MAX_FILE_COUNT_SETTING = "logging/maxFileCount";
+const QString LOG_RATE_LIMIT_SETTING = "logging/maxMessagesPerMinute";
+
+const QString RELAY_ENABLED_SETTING = "relay/enabled";
+const QString RELAY_PORT_SETTING = "relay/port";
+const QString RELAY_ROOM_IDS_SETTING = "relay/roomIds";
+const QString RELAY_REFRESH_INTERVAL_SETTING = "relay/refreshIntervalMs";
+const QString RELAY_MAX_AGE_SETTING = "relay/maxAgeMs";
+const QString RELAY_MAX_STALE_AGE_SETTING = "relay/maxStaleAgeMs";
+
+const QString FRONTEND_SETTING = "display/frontend";
+const QString MAX_TRANSITION_DURATION_SETTING =
+    "display/maxTransitionDurationMs";
+const QString MAX_FRAME_RATE_SETTING = "display/maxFrameRate";
+const QString BOOK_NOW_ENABLED_SETTING = "display/bookNowEnabled";
+// The token the backend derives for this display's room. Without one the
+// book-now buttons aren't shown, since the backend would refuse every booking.
+const QString BOOK_NOW_TOKEN_SETTING = "api/bookNowToken";
+
+// Only used by the epaper frontend. The output is a file or framebuffer device
+// the panel image is written to as raw 8-bit greyscale.
+const QString EPAPER_WIDTH_SETTING = "epaper/width";
+const QString EPAPER_HEIGHT_SETTING = "epaper/height";
+const QString EPAPER_GREY_LEVELS_SETTING = "epaper/greyLevels";
+const QString EPAPER_OUTPUT_PATH_SETTING = "epaper/outputPath";
+const QString EPAPER_FULL_REFRESH_AFTER_SETTING =
+    "epaper/fullRefreshAfterPartials";
+
+// One room ID per screen, in the order Qt lists the screens. Empty for a
+// single screen showing the room of api/roomId. Color settings can be
+// overridden per screen by prefixing them with this, e.g.
+// screens/1/colors/background.
+const QString SCREEN_ROOM_IDS_SETTING = "screens/roomIds";
+const QString SCREEN_OVERRIDE_PREFIX = "screens/%1/";
+
 #endif // SETTINGSTRINGS_H
@@ -0,0 +1,175 @@
+#include "../datafetchinghandler.h"
+#include "../settingstrings.h"
+#include "../timing/clock.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtTest>
+
+// Plays a working day of bookings through DataFetchingHandler on a simulated
+// clock, in a few seconds. The schedule is synced once at the start of the
+// day, after that every switch comes from the handler's own boundary timers.
+namespace {
+const QDate SIMULATED_DATE(2026, 1, 5);
+const QTime DAY_START(8, 0);
+const QTime DAY_END(17, 0);
+const int BOOKING_COUNT = 8;
+const qint64 BOOKING_DURATION = 30 * 60;
+// Nine simulated hours in nine seconds.
+const double CLOCK_SPEED = 3600.0;
+// Timers are only as exact as the wall clock milliseconds they run on, which
+// are seconds on the simulated clock. This still tells a switch on the
+// boundary from one at the next poll.
+const qint64 BOUNDARY_TOLERANCE = 5 * 60 * 1000;
+
+struct ObservedState {
+  qint64 observedAt;
+  CurrentBookingState state;
+  QString bookingId;
+};
+} // namespace
+
+class DayScheduleTest : public QObject {
+  Q_OBJECT
+
+private:
+  qint64 m_dayStartTime;
+  QList<qint64> m_bookingStartTimes;
+
+  QByteArray getSchedulePayload() const;
+  static qint64 findFirstObservation(const QList<ObservedState> &states,
+                                     CurrentBookingState state,
+                                     const QString &bookingId,
+                                     qint64 notBefore);
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void switchesAtBookingBoundaries();
+};
+
+void DayScheduleTest::initTestCase() {
+  QStandardPaths::setTestModeEnabled(true);
+  QSettings settings;
+  settings.setValue(UNBOOKED_NAME_TEXT_SETTING, "Free");
+  settings.setValue(BOOKED_USERNAME_PREFIX_TEXT_SETTING, "Booked by ");
+  settings.setValue(API_POLL_INTERVAL_SETTING, 60 * 1000);
+  settings.setValue(API_ERROR_AFTER_FAILURES_SETTING, 3);
+  // Nothing polls here, so the display must not give up on the connection
+  // during the simulated day.
+  settings.setValue(API_ERROR_AFTER_TIME_SETTING, 24 * 60 * 60 * 1000);
+  settings.sync();
+
+  QTimeZone timeZone = SystemClock().timeZone();
+  m_dayStartTime =
+      QDateTime(SIMULATED_DATE, DAY_START, timeZone).toSecsSinceEpoch();
+  for (int index = 0; index < BOOKING_COUNT; index++) {
+    m_bookingStartTimes.append(
+        QDateTime(SIMULATED_DATE, QTime(9 + index, 0), timeZone)
+            .toSecsSinceEpoch());
+  }
+}
+
+void DayScheduleTest::cleanupTestCase() { QSettings().clear(); }
+
+QByteArray DayScheduleTest::getSchedulePayload() const {
+  QJsonObject noBooking{{"id", ""},
+                        {"name", ""},
+                        {"user", ""},
+                        {"start_time", 0},
+                        {"end_time", 0}};
+  QJsonArray bookings;
+  for (int index = 0; index < m_bookingStartTimes.size(); index++) {
+    qint64 startTime = m_bookingStartTimes[index];
+    qint64 endTime = startTime + BOOKING_DURATION - 1;
+    bookings.append(QJsonObject{{"id", QString::number(index + 1)},
+                                {"name", QString("Meeting %1").arg(index + 1)},
+                                {"user", "Jane Doe"},
+                                {"start_time", startTime},
+                                {"end_time", endTime}});
+  }
+
+  // A full reply, like the first poll of the day gets.
+  QJsonObject payload;
+  payload["current_booking"] = noBooking;
+  payload["first_upcoming_booking"] = bookings[0];
+  payload["second_upcoming_booking"] = bookings[1];
+  payload["third_upcoming_booking"] = bookings[2];
+  payload["version"] = QString("%1.1").arg(m_dayStartTime);
+  payload["bookings"] = bookings;
+  return QJsonDocument(payload).toJson(QJsonDocument::Compact);
+}
+
+qint64 DayScheduleTest::findFirstObservation(
+    const QList<ObservedState> &states, CurrentBookingState state,
+    const QString &bookingId, qint64 notBefore) {
+  for (const ObservedState &observedState : states) {
+    if (observedState.observedAt >= notBefore &&
+        observedState.state == state && observedState.bookingId == bookingId) {
+      return observedState.observedAt;
+    }
+  }
+  return -1;
+}
+
+void DayScheduleTest::switchesAtBookingBoundaries() {
+  SimulatedClock clock(m_dayStartTime * 1000, CLOCK_SPEED);
+  // No network manager, so nothing is polled and only the boundary timers
+  // move the display along.
+  DataFetchingHandler handler(0, nullptr, &clock, nullptr, nullptr, nullptr);
+  QList<ObservedState> states;
+  connect(&handler, &DataFetchingHandler::displayStateChanged, this,
+          [&states, &clock](const DisplayState &displayState) {
+            states.append({clock.currentMSecsSinceEpoch(),
+                           displayState.currentBooking().state,
+                           displayState.currentBooking().id});
+          });
+
+  handler.startDataFetching();
+  RecordedPayload payload;
+  payload.receivedAt = clock.currentMSecsSinceEpoch();
+  payload.httpStatusCode = 200;
+  payload.body = getSchedulePayload();
+  handler.processPayload(payload);
+  QVERIFY(!states.isEmpty());
+  QVERIFY(states.first().state == CurrentBookingState::UNBOOKED);
+
+  qint64 dayEndTime =
+      QDateTime(SIMULATED_DATE, DAY_END, clock.timeZone()).toMSecsSinceEpoch();
+  int wallClockTimeout =
+      clock.toWallClockInterval(dayEndTime - clock.currentMSecsSinceEpoch()) +
+      5000;
+  QTRY_VERIFY_WITH_TIMEOUT(clock.currentMSecsSinceEpoch() >= dayEndTime,
+                           wallClockTimeout);
+
+  for (int index = 0; index < m_bookingStartTimes.size(); index++) {
+    QString bookingId = QString::number(index + 1);
+    qint64 startTime = m_bookingStartTimes[index] * 1000;
+    qint64 endTime = startTime + BOOKING_DURATION * 1000;
+
+    qint64 bookedAt = findFirstObservation(states, CurrentBookingState::BOOKED,
+                                           bookingId, startTime);
+    QVERIFY2(bookedAt >= 0,
+             qPrintable(QString("Booking %1 was never shown").arg(bookingId)));
+    QVERIFY2(bookedAt - startTime <= BOUNDARY_TOLERANCE,
+             qPrintable(QString("Booking %1 was shown %2 ms late")
+                            .arg(bookingId)
+                            .arg(bookedAt - startTime)));
+    QVERIFY2(findFirstObservation(states, CurrentBookingState::BOOKED,
+                                  bookingId, 0) >= startTime,
+             qPrintable(QString("Booking %1 was shown before it started")
+                            .arg(bookingId)));
+
+    qint64 freedAt = findFirstObservation(
+        states, CurrentBookingState::UNBOOKED, QString(), endTime);
+    QVERIFY2(freedAt >= 0 && freedAt - endTime <= BOUNDARY_TOLERANCE,
+             qPrintable(QString("The room wasn't freed on time after "
+                                "booking %1")
+                            .arg(bookingId)));
+  }
+}
+
+QTEST_GUILESS_MAIN(DayScheduleTest)
+#include "dayscheduletest.moc"
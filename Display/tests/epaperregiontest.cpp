@@ -0,0 +1,168 @@
+#include "../epaper/dirtyregiontracker.h"
+#include "../epaper/epaperfrontend.h"
+#include <QImage>
+#include <QSet>
+#include <QtTest>
+
+// Checks the dirty regions of small hand-made frames against the rectangles
+// worked out by hand, and the quantization against the greys a panel with a
+// given number of levels can show.
+namespace {
+const int TILE_SIZE = 4;
+
+QImage getBlankFrame(int width, int height) {
+  QImage frame(width, height, QImage::Format_Grayscale8);
+  frame.fill(255);
+  return frame;
+}
+
+void setBlack(QImage &frame, const QList<QPoint> &points) {
+  for (const QPoint &point : points) {
+    frame.scanLine(point.y())[point.x()] = 0;
+  }
+}
+} // namespace
+
+class EpaperRegionTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void findsNothingInEqualFrames();
+  void refreshesEverythingOnSizeChange();
+  void findsRunsOfDirtyTiles();
+  void clipsTilesAtTheFrameEdge();
+  void mergesRunsVertically();
+  void mergesRegionsByCost_data();
+  void mergesRegionsByCost();
+  void quantizesToGreyLevels_data();
+  void quantizesToGreyLevels();
+  void quantizesToExactlyTheGreyLevels();
+};
+
+void EpaperRegionTest::findsNothingInEqualFrames() {
+  DirtyRegionTracker tracker(TILE_SIZE, 0);
+  QImage frame = getBlankFrame(16, 8);
+  setBlack(frame, {{3, 3}, {9, 6}});
+  QVERIFY(tracker.getDirtyRegions(frame, frame.copy()).isEmpty());
+}
+
+void EpaperRegionTest::refreshesEverythingOnSizeChange() {
+  DirtyRegionTracker tracker(TILE_SIZE, 0);
+  QCOMPARE(tracker.getDirtyRegions(getBlankFrame(16, 8), getBlankFrame(8, 8)),
+           QList<QRect>{QRect(0, 0, 8, 8)});
+}
+
+// Two neighbouring tiles are one run, a tile after a clean one starts the
+// next. Without any refresh overhead the gap between them stays out.
+void EpaperRegionTest::findsRunsOfDirtyTiles() {
+  DirtyRegionTracker tracker(TILE_SIZE, 0);
+  QImage previousFrame = getBlankFrame(16, 8);
+  QImage frame = previousFrame.copy();
+  setBlack(frame, {{1, 1}, {6, 2}, {15, 3}});
+  QCOMPARE(tracker.getDirtyRegions(previousFrame, frame),
+           (QList<QRect>{QRect(0, 0, 8, 4), QRect(12, 0, 4, 4)}));
+}
+
+void EpaperRegionTest::clipsTilesAtTheFrameEdge() {
+  DirtyRegionTracker tracker(TILE_SIZE, 0);
+  QImage previousFrame = getBlankFrame(10, 6);
+  QImage frame = previousFrame.copy();
+  setBlack(frame, {{9, 5}});
+  QCOMPARE(tracker.getDirtyRegions(previousFrame, frame),
+           QList<QRect>{QRect(8, 4, 2, 2)});
+}
+
+// The runs of the first two tile rows span the same columns and become one
+// region, the narrower run below them doesn't.
+void EpaperRegionTest::mergesRunsVertically() {
+  DirtyRegionTracker tracker(TILE_SIZE, 0);
+  QImage previousFrame = getBlankFrame(8, 12);
+  QImage frame = previousFrame.copy();
+  setBlack(frame, {{0, 0}, {4, 0}, {3, 7}, {7, 7}, {0, 8}});
+  QCOMPARE(tracker.getDirtyRegions(previousFrame, frame),
+           (QList<QRect>{QRect(0, 0, 8, 8), QRect(0, 8, 4, 4)}));
+}
+
+// Two tiles at the ends of a 32 pixel wide row leave 96 clean pixels in
+// between, which are only worth refreshing for an overhead at least as big.
+void EpaperRegionTest::mergesRegionsByCost_data() {
+  QTest::addColumn<qint64>("refreshOverheadPixels");
+  QTest::addColumn<QList<QRect>>("expectedRegions");
+
+  QTest::newRow("cheaper apart")
+      << qint64(95) << QList<QRect>{QRect(0, 0, 4, 4), QRect(28, 0, 4, 4)};
+  QTest::newRow("break even")
+      << qint64(96) << QList<QRect>{QRect(0, 0, 32, 4)};
+  QTest::newRow("cheaper merged")
+      << qint64(1000) << QList<QRect>{QRect(0, 0, 32, 4)};
+}
+
+void EpaperRegionTest::mergesRegionsByCost() {
+  QFETCH(qint64, refreshOverheadPixels);
+  QFETCH(QList<QRect>, expectedRegions);
+
+  DirtyRegionTracker tracker(TILE_SIZE, refreshOverheadPixels);
+  QImage previousFrame = getBlankFrame(32, 4);
+  QImage frame = previousFrame.copy();
+  setBlack(frame, {{2, 2}, {29, 1}});
+  QCOMPARE(tracker.getDirtyRegions(previousFrame, frame), expectedRegions);
+}
+
+void EpaperRegionTest::quantizesToGreyLevels_data() {
+  QTest::addColumn<int>("greyLevels");
+  QTest::addColumn<int>("value");
+  QTest::addColumn<int>("expectedValue");
+
+  QTest::newRow("2 levels, black") << 2 << 0 << 0;
+  QTest::newRow("2 levels, below middle") << 2 << 127 << 0;
+  QTest::newRow("2 levels, above middle") << 2 << 128 << 255;
+  QTest::newRow("2 levels, white") << 2 << 255 << 255;
+  QTest::newRow("4 levels, below first step") << 4 << 42 << 0;
+  QTest::newRow("4 levels, above first step") << 4 << 43 << 85;
+  QTest::newRow("4 levels, light grey") << 4 << 200 << 170;
+  QTest::newRow("16 levels, near black") << 16 << 8 << 0;
+  QTest::newRow("16 levels, first grey") << 16 << 9 << 17;
+  QTest::newRow("16 levels, mid grey") << 16 << 100 << 102;
+  QTest::newRow("16 levels, white") << 16 << 255 << 255;
+}
+
+void EpaperRegionTest::quantizesToGreyLevels() {
+  QFETCH(int, greyLevels);
+  QFETCH(int, value);
+  QFETCH(int, expectedValue);
+
+  QImage frame = getBlankFrame(3, 2);
+  frame.fill(value);
+  EpaperFrontend::quantize(frame, greyLevels);
+  for (int y = 0; y < frame.height(); y++) {
+    for (int x = 0; x < frame.width(); x++) {
+      QCOMPARE(int(frame.constScanLine(y)[x]), expectedValue);
+    }
+  }
+}
+
+void EpaperRegionTest::quantizesToExactlyTheGreyLevels() {
+  QImage gradient(256, 1, QImage::Format_Grayscale8);
+  for (int value = 0; value < 256; value++) {
+    gradient.scanLine(0)[value] = uchar(value);
+  }
+
+  for (int greyLevels : {2, 4, 16}) {
+    QImage frame = gradient.copy();
+    EpaperFrontend::quantize(frame, greyLevels);
+    QSet<int> values;
+    int previousValue = 0;
+    for (int x = 0; x < frame.width(); x++) {
+      int value = frame.constScanLine(0)[x];
+      QVERIFY2(value >= previousValue, "Quantizing must keep the order");
+      previousValue = value;
+      values.insert(value);
+    }
+    QCOMPARE(values.size(), greyLevels);
+    QVERIFY(values.contains(0));
+    QVERIFY(values.contains(255));
+  }
+}
+
+QTEST_GUILESS_MAIN(EpaperRegionTest)
+#include "epaperregiontest.moc"
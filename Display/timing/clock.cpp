@@ -0,0 +1,46 @@
+#include "clock.h"
+#include <QTimer>
+#include <limits>
+
+qint64 Clock::currentSecsSinceEpoch() const {
+  return currentMSecsSinceEpoch() / 1000;
+}
+
+QDateTime Clock::toDateTime(qint64 secsSinceEpoch) const {
+  return QDateTime::fromSecsSinceEpoch(secsSinceEpoch, timeZone());
+}
+
+QTimeZone Clock::timeZone() const { return QTimeZone::systemTimeZone(); }
+
+void Clock::callAfter(qint64 clockInterval, const QObject *receiver,
+                      std::function<void()> callback) const {
+  QTimer::singleShot(toWallClockInterval(clockInterval), receiver, callback);
+}
+
+SystemClock::SystemClock(const ClockOffsetEstimator *offsetEstimator)
+    : m_offsetEstimator(offsetEstimator) {}
+
+qint64 SystemClock::currentMSecsSinceEpoch() const {
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  return m_offsetEstimator ? now + m_offsetEstimator->offset() : now;
+}
+
+int SystemClock::toWallClockInterval(qint64 clockInterval) const {
+  return static_cast<int>(
+      qBound<qint64>(0, clockInterval, std::numeric_limits<int>::max()));
+}
+
+SimulatedClock::SimulatedClock(qint64 startMSecsSinceEpoch, double speed)
+    : m_startMSecsSinceEpoch(startMSecsSinceEpoch),
+      m_speed(speed > 0 ? speed : 1.0) {
+  m_wallClock.start();
+}
+
+qint64 SimulatedClock::currentMSecsSinceEpoch() const {
+  return m_startMSecsSinceEpoch + qRound64(m_wallClock.elapsed() * m_speed);
+}
+
+int SimulatedClock::toWallClockInterval(qint64 clockInterval) const {
+  return static_cast<int>(qBound<qint64>(
+      0, qRound64(clockInterval / m_speed), std::numeric_limits<int>::max()));
+}
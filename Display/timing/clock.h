@@ -0,0 +1,57 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "clockoffsetestimator.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimeZone>
+#include <functional>
+
+// Source of "now" for everything that depends on the booking schedule, so a
+// day of bookings can be played back in seconds. Delays passed in are in clock
+// time and converted to wall clock time here. Safe to use from any thread.
+class Clock {
+public:
+  virtual ~Clock() = default;
+
+  virtual qint64 currentMSecsSinceEpoch() const = 0;
+  virtual int toWallClockInterval(qint64 clockInterval) const = 0;
+
+  qint64 currentSecsSinceEpoch() const;
+  QDateTime toDateTime(qint64 secsSinceEpoch) const;
+  QTimeZone timeZone() const;
+  // Runs the callback on the receiver's thread once the clock time has passed,
+  // unless the receiver was deleted in the meantime.
+  void callAfter(qint64 clockInterval, const QObject *receiver,
+                 std::function<void()> callback) const;
+};
+
+// The local system clock, corrected by the offset to the backend's clock when
+// an estimator is given. Intervals don't need converting, an offset doesn't
+// change how fast time passes.
+class SystemClock : public Clock {
+public:
+  explicit SystemClock(const ClockOffsetEstimator *offsetEstimator = nullptr);
+  qint64 currentMSecsSinceEpoch() const override;
+  int toWallClockInterval(qint64 clockInterval) const override;
+
+private:
+  const ClockOffsetEstimator *m_offsetEstimator;
+};
+
+// Starts at the given time and runs the given number of times faster than
+// the wall clock.
+class SimulatedClock : public Clock {
+public:
+  SimulatedClock(qint64 startMSecsSinceEpoch, double speed);
+  qint64 currentMSecsSinceEpoch() const override;
+  int toWallClockInterval(qint64 clockInterval) const override;
+
+private:
+  qint64 m_startMSecsSinceEpoch;
+  double m_speed;
+  QElapsedTimer m_wallClock;
+};
+
+#endif // CLOCK_H
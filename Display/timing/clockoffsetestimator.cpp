@@ -0,0 +1,64 @@
+#include "clockoffsetestimator.h"
+#include "../diagnostics/logging.h"
+#include <QMutexLocker>
+
+namespace {
+// At one poll a second this is about a minute, short enough for the drift of
+// even a bad local clock to stay within a few milliseconds.
+const int MAX_SAMPLE_COUNT = 64;
+// Offsets changing by more than this are logged, they mean someone set the
+// local clock or the backend's.
+const qint64 CLOCK_STEP_WARNING_THRESHOLD = 1000;
+} // namespace
+
+ClockOffsetEstimator::ClockOffsetEstimator()
+    : m_offset(0), m_uncertainty(-1) {}
+
+void ClockOffsetEstimator::addSample(qint64 requestSentAt,
+                                     qint64 replyReceivedAt, qint64 serverTime,
+                                     qint64 serverTimeResolution) {
+  if (replyReceivedAt < requestSentAt) {
+    return;
+  }
+
+  QMutexLocker locker(&m_samplesMutex);
+  m_samples.append({serverTime - replyReceivedAt,
+                    serverTime + serverTimeResolution - requestSentAt});
+  if (m_samples.size() > MAX_SAMPLE_COUNT) {
+    m_samples.removeFirst();
+  }
+
+  // Going back from the newest sample, the first one that doesn't overlap
+  // with the newer ones is from before a clock step. That one and everything
+  // older is of no use anymore.
+  qint64 lowestOffset = m_samples.last().lowestOffset;
+  qint64 highestOffset = m_samples.last().highestOffset;
+  for (int index = m_samples.size() - 2; index >= 0; index--) {
+    const OffsetWindow &sample = m_samples[index];
+    if (sample.lowestOffset > highestOffset ||
+        sample.highestOffset < lowestOffset) {
+      m_samples.remove(0, index + 1);
+      break;
+    }
+    lowestOffset = qMax(lowestOffset, sample.lowestOffset);
+    highestOffset = qMin(highestOffset, sample.highestOffset);
+  }
+
+  qint64 offset = (lowestOffset + highestOffset) / 2;
+  qint64 previousOffset = m_offset.exchange(offset, std::memory_order_relaxed);
+  qint64 previousUncertainty = m_uncertainty.exchange(
+      (highestOffset - lowestOffset) / 2, std::memory_order_relaxed);
+  if (previousUncertainty >= 0 &&
+      qAbs(offset - previousOffset) > CLOCK_STEP_WARNING_THRESHOLD) {
+    qCWarning(lcNetwork) << "Clock offset to the backend jumped from"
+                         << previousOffset << "to" << offset << "ms";
+  }
+}
+
+qint64 ClockOffsetEstimator::offset() const {
+  return m_offset.load(std::memory_order_relaxed);
+}
+
+qint64 ClockOffsetEstimator::uncertainty() const {
+  return m_uncertainty.load(std::memory_order_relaxed);
+}
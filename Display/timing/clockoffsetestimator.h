@@ -0,0 +1,42 @@
+#ifndef CLOCKOFFSETESTIMATOR_H
+#define CLOCKOFFSETESTIMATOR_H
+
+#include <QList>
+#include <QMutex>
+#include <atomic>
+
+// Estimates how far the local system clock is off from the backend's, NTP
+// style. Every reply bounds the offset: the backend read its clock somewhere
+// between sending the request and receiving the reply, and a timestamp with a
+// coarse resolution (the whole seconds of a Date header) widens that window
+// further. The estimate is the middle of where the windows of recent replies
+// overlap, which narrows down as replies arrive at different points in the
+// round trip and in the second. Safe to use from any thread.
+class ClockOffsetEstimator {
+public:
+  ClockOffsetEstimator();
+
+  // All times in milliseconds since the epoch, the request times taken from
+  // the local system clock. The resolution is 0 for exact server times.
+  void addSample(qint64 requestSentAt, qint64 replyReceivedAt,
+                 qint64 serverTime, qint64 serverTimeResolution);
+  // What to add to the local system clock to get the backend's time.
+  qint64 offset() const;
+  // Half the width of the window the offset is known to be in, negative
+  // while there is no estimate yet.
+  qint64 uncertainty() const;
+
+private:
+  struct OffsetWindow {
+    qint64 lowestOffset;
+    qint64 highestOffset;
+  };
+
+  QMutex m_samplesMutex;
+  // Newest last.
+  QList<OffsetWindow> m_samples;
+  std::atomic<qint64> m_offset;
+  std::atomic<qint64> m_uncertainty;
+};
+
+#endif // CLOCKOFFSETESTIMATOR_H
@@ -0,0 +1,103 @@
+#include "bookeravatar.h"
+#include "../assets/assetcache.h"
+#include <QGraphicsOpacityEffect>
+#include <QPainter>
+#include <QPainterPath>
+
+namespace {
+const int AVATAR_SIZE = 64;
+} // namespace
+
+BookerAvatar::BookerAvatar(QWidget *parent)
+    : QWidget{parent}, m_isChanging(false) {
+  // Always taking up the space, so the booking info doesn't move sideways
+  // between bookers with and without a picture.
+  this->setFixedSize(AVATAR_SIZE, AVATAR_SIZE);
+  configureAnimations();
+}
+
+void BookerAvatar::configureAnimations() {
+  QGraphicsOpacityEffect *opacityEffect = new QGraphicsOpacityEffect(this);
+  opacityEffect->setOpacity(100);
+  this->setGraphicsEffect(opacityEffect);
+
+  m_fadeInPropertyAnimation = new QPropertyAnimation(opacityEffect, "opacity");
+  m_fadeInPropertyAnimation->setDuration(1000);
+  m_fadeInPropertyAnimation->setStartValue(0.0);
+  m_fadeInPropertyAnimation->setEndValue(1.0);
+
+  m_fadeOutPropertyAnimation = new QPropertyAnimation(opacityEffect, "opacity");
+  m_fadeOutPropertyAnimation->setDuration(500);
+  m_fadeOutPropertyAnimation->setStartValue(1.0);
+  m_fadeOutPropertyAnimation->setEndValue(0.0);
+  m_fadeOutPropertyAnimation->setEasingCurve(QEasingCurve::InOutQuad);
+}
+
+void BookerAvatar::changeAvatar(const QString &userId,
+                                TransitionTimeline *timeline, int startTime) {
+  // Same timing as the booking info it sits next to.
+  if (userId != m_userId) {
+    m_userId = userId;
+    m_avatarPixmap = QPixmap();
+  }
+  m_isChanging = true;
+  emit avatarRequested(userId);
+
+  int fadeInStartTime = startTime + m_fadeOutPropertyAnimation->duration();
+  timeline->addAnimation(startTime, m_fadeOutPropertyAnimation);
+  timeline->addAction(fadeInStartTime, [this]() {
+    m_isChanging = false;
+    showLoadedAvatar();
+  });
+  timeline->addAnimation(fadeInStartTime, m_fadeInPropertyAnimation);
+}
+
+void BookerAvatar::prepareAvatar(const QString &userId) {
+  if (!userId.isEmpty()) {
+    emit avatarRequested(userId);
+  }
+}
+
+// Pictures for other users than the shown one are still decoded, that is how
+// the next booker's picture ends up in the memory cache in advance.
+void BookerAvatar::showAvatar(const QString &userId, const QString &filePath) {
+  if (filePath.isEmpty()) {
+    if (userId == m_userId) {
+      m_avatarPixmap = QPixmap();
+      showLoadedAvatar();
+    }
+    return;
+  }
+
+  AssetCache::instance()->requestPixmap(
+      filePath, this->size(), this->devicePixelRatioF(),
+      Qt::KeepAspectRatioByExpanding, this,
+      [this, userId](const QPixmap &avatarPixmap) {
+        if (userId == m_userId) {
+          m_avatarPixmap = avatarPixmap;
+          showLoadedAvatar();
+        }
+      });
+}
+
+// A picture arriving halfway a transition waits for the fade in, so the old
+// booker never fades out with the new face.
+void BookerAvatar::showLoadedAvatar() {
+  if (m_isChanging) {
+    return;
+  }
+  m_shownPixmap = m_avatarPixmap;
+  update();
+}
+
+void BookerAvatar::paintEvent(QPaintEvent *) {
+  if (m_shownPixmap.isNull()) {
+    return;
+  }
+  QPainter painter(this);
+  painter.setRenderHint(QPainter::Antialiasing);
+  QPainterPath clipPath;
+  clipPath.addEllipse(this->rect());
+  painter.setClipPath(clipPath);
+  painter.drawPixmap(this->rect(), m_shownPixmap);
+}
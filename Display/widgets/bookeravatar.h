@@ -0,0 +1,41 @@
+#ifndef BOOKERAVATAR_H
+#define BOOKERAVATAR_H
+
+#include "../animations/transitiontimeline.h"
+#include <QPixmap>
+#include <QPropertyAnimation>
+#include <QWidget>
+
+// Round profile picture of the booker, next to the booking info. Pictures
+// are requested by user ID and arrive whenever the avatar store has them,
+// which is right away for anyone who booked before.
+class BookerAvatar : public QWidget {
+  Q_OBJECT
+public:
+  explicit BookerAvatar(QWidget *parent = nullptr);
+  void changeAvatar(const QString &userId, TransitionTimeline *timeline,
+                    int startTime);
+  // Gets the picture of the next booker decoded before it is shown.
+  void prepareAvatar(const QString &userId);
+  void showAvatar(const QString &userId, const QString &filePath);
+
+signals:
+  void avatarRequested(const QString &userId);
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+
+private:
+  QString m_userId;
+  QPixmap m_avatarPixmap;
+  QPixmap m_shownPixmap;
+  bool m_isChanging;
+
+  QPropertyAnimation *m_fadeInPropertyAnimation;
+  QPropertyAnimation *m_fadeOutPropertyAnimation;
+
+  void configureAnimations();
+  void showLoadedAvatar();
+};
+
+#endif // BOOKERAVATAR_H
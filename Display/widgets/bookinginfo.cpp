@@ -10,7 +10,7 @@ BookingInfo::BookingInfo(QWidget *parent) : QWidget{parent} {
 
   m_bookingInfoText =
       new QString(settings.value(UNBOOKED_INFO_TEXT_SETTING).toString());
-  m_bookingInfoLabel = new QLabel(*m_bookingInfoText, this);
+  m_bookingInfoLabel = new PrerenderedLabel(*m_bookingInfoText, this);
 
   QVBoxLayout *layout = new QVBoxLayout(this);
   layout->addWidget(m_bookingInfoLabel);
@@ -42,24 +42,30 @@ void BookingInfo::configureAnimations() {
   m_fadeOutPropertyAnimation->setStartValue(1.0);
   m_fadeOutPropertyAnimation->setEndValue(0.0);
   m_fadeOutPropertyAnimation->setEasingCurve(QEasingCurve::InOutQuad);
-
-  connect(m_fadeOutPropertyAnimation, &QPropertyAnimation::finished, this,
-          &BookingInfo::fadeInNewInfo);
 }
 
-void BookingInfo::changeBookingInfo(QString newBookingInfoText) {
-  if (newBookingInfoText.size() > m_maxCharacters) {
-    newBookingInfoText.resize(m_maxCharacters);
-    newBookingInfoText.append("...");
-  }
-  *m_bookingInfoText = newBookingInfoText;
-  fadeOutOldInfo();
-}
+void BookingInfo::changeBookingInfo(QString newBookingInfoText,
+                                    TransitionTimeline *timeline,
+                                    int startTime) {
+  *m_bookingInfoText = getTruncatedInfo(newBookingInfoText);
+  QString bookingInfoText = *m_bookingInfoText;
+  int fadeInStartTime = startTime + m_fadeOutPropertyAnimation->duration();
 
-void BookingInfo::fadeOutOldInfo() { m_fadeOutPropertyAnimation->start(); }
+  timeline->addAnimation(startTime, m_fadeOutPropertyAnimation);
+  timeline->addAction(fadeInStartTime, [this, bookingInfoText]() {
+    m_bookingInfoLabel->showText(bookingInfoText);
+  });
+  timeline->addAnimation(fadeInStartTime, m_fadeInPropertyAnimation);
+}
 
-void BookingInfo::fadeInNewInfo() {
+void BookingInfo::prerenderBookingInfo(QString bookingInfoText) {
+  m_bookingInfoLabel->prerenderText(getTruncatedInfo(bookingInfoText));
+}
 
-  m_bookingInfoLabel->setText(*m_bookingInfoText);
-  m_fadeInPropertyAnimation->start();
+QString BookingInfo::getTruncatedInfo(QString bookingInfoText) {
+  if (bookingInfoText.size() > m_maxCharacters) {
+    bookingInfoText.resize(m_maxCharacters);
+    bookingInfoText.append("...");
+  }
+  return bookingInfoText;
 }
@@ -1,7 +1,8 @@
 #ifndef BOOKINGINFO_H
 #define BOOKINGINFO_H
 
-#include <QLabel>
+#include "../animations/transitiontimeline.h"
+#include "prerenderedlabel.h"
 #include <QPropertyAnimation>
 #include <QWidget>
 
@@ -9,11 +10,13 @@ class BookingInfo : public QWidget {
   Q_OBJECT
 public:
   explicit BookingInfo(QWidget *parent = nullptr);
-  void changeBookingInfo(QString newBookingInfoText);
+  void changeBookingInfo(QString newBookingInfoText,
+                         TransitionTimeline *timeline, int startTime);
+  void prerenderBookingInfo(QString bookingInfoText);
 
 private:
   QString *m_bookingInfoText;
-  QLabel *m_bookingInfoLabel;
+  PrerenderedLabel *m_bookingInfoLabel;
   int m_maxCharacters;
 
   QPropertyAnimation *m_fadeInPropertyAnimation;
@@ -21,8 +24,7 @@ private:
 
   void configureLabelStyling();
   void configureAnimations();
-  void fadeOutOldInfo();
-  void fadeInNewInfo();
+  QString getTruncatedInfo(QString bookingInfoText);
 };
 
 #endif // BOOKINGINFO_H
@@ -13,7 +13,7 @@ BookingName::BookingName(QWidget *parent)
   m_maxCharacters = settings.value(BOOKING_NAME_MAX_CHARACTERS).toInt();
   m_bookingNameText =
       new QString(settings.value(UNBOOKED_NAME_TEXT_SETTING).toString());
-  m_bookingNameLabel = new QLabel(*m_bookingNameText, this);
+  m_bookingNameLabel = new PrerenderedLabel(*m_bookingNameText, this);
 
   QVBoxLayout *layout = new QVBoxLayout(this);
 
@@ -75,23 +75,30 @@ void BookingName::configureAnimations() {
   fadeOutPositionAnimation->setEasingCurve(QEasingCurve::InOutQuad);
 
   m_fadeOutAnimationGroup->addAnimation(fadeOutPositionAnimation);
-
-  connect(m_fadeOutAnimationGroup, &QParallelAnimationGroup::finished, this,
-          &BookingName::fadeInNewName);
 }
 
-void BookingName::changeBookingName(QString newBookingNameText) {
-  if (newBookingNameText.size() > m_maxCharacters) {
-    newBookingNameText.resize(m_maxCharacters);
-    newBookingNameText.append("...");
-  }
-  *m_bookingNameText = newBookingNameText;
-  fadeOutOldName();
+void BookingName::changeBookingName(QString newBookingNameText,
+                                    TransitionTimeline *timeline,
+                                    int startTime) {
+  *m_bookingNameText = getTruncatedName(newBookingNameText);
+  QString bookingNameText = *m_bookingNameText;
+  int fadeInStartTime = startTime + m_fadeOutAnimationGroup->duration();
+
+  timeline->addAnimation(startTime, m_fadeOutAnimationGroup);
+  timeline->addAction(fadeInStartTime, [this, bookingNameText]() {
+    m_bookingNameLabel->showText(bookingNameText);
+  });
+  timeline->addAnimation(fadeInStartTime, m_fadeInAnimationGroup);
 }
 
-void BookingName::fadeOutOldName() { m_fadeOutAnimationGroup->start(); }
+void BookingName::prerenderBookingName(QString bookingNameText) {
+  m_bookingNameLabel->prerenderText(getTruncatedName(bookingNameText));
+}
 
-void BookingName::fadeInNewName() {
-  m_bookingNameLabel->setText(*m_bookingNameText);
-  m_fadeInAnimationGroup->start();
+QString BookingName::getTruncatedName(QString bookingNameText) {
+  if (bookingNameText.size() > m_maxCharacters) {
+    bookingNameText.resize(m_maxCharacters);
+    bookingNameText.append("...");
+  }
+  return bookingNameText;
 }
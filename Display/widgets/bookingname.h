@@ -1,7 +1,8 @@
 #ifndef BOOKINGNAME_H
 #define BOOKINGNAME_H
 
-#include <QLabel>
+#include "../animations/transitiontimeline.h"
+#include "prerenderedlabel.h"
 #include <QParallelAnimationGroup>
 #include <QWidget>
 
@@ -9,19 +10,20 @@ class BookingName : public QWidget {
   Q_OBJECT
 public:
   explicit BookingName(QWidget *parent = nullptr);
-  void changeBookingName(QString newBookingNameText);
+  void changeBookingName(QString newBookingNameText,
+                         TransitionTimeline *timeline, int startTime);
+  void prerenderBookingName(QString bookingNameText);
 
 private:
   QString *m_bookingNameText;
-  QLabel *m_bookingNameLabel;
+  PrerenderedLabel *m_bookingNameLabel;
   int m_maxCharacters;
   QParallelAnimationGroup *m_fadeInAnimationGroup;
   QParallelAnimationGroup *m_fadeOutAnimationGroup;
 
   void configureLabelStyling();
   void configureAnimations();
-  void fadeOutOldName();
-  void fadeInNewName();
+  QString getTruncatedName(QString bookingNameText);
 };
 
 #endif // BOOKINGNAME_H
@@ -8,7 +8,7 @@ BookingStatus::BookingStatus(QWidget *parent) : QWidget{parent} {
   QSettings settings;
   m_bookingStatusText =
       new QString(settings.value(UNBOOKED_STATUS_TEXT_SETTING).toString());
-  m_bookingStatusLabel = new QLabel(*m_bookingStatusText, this);
+  m_bookingStatusLabel = new PrerenderedLabel(*m_bookingStatusText, this);
 
   QVBoxLayout *layout = new QVBoxLayout(this);
   layout->addWidget(m_bookingStatusLabel);
@@ -41,19 +41,21 @@ void BookingStatus::configureAnimations() {
   m_fadeOutPropertyAnimation->setKeyValueAt(0.3, 0.0);
   m_fadeOutPropertyAnimation->setEndValue(0.0);
   m_fadeOutPropertyAnimation->setEasingCurve(QEasingCurve::InOutQuad);
-
-  connect(m_fadeOutPropertyAnimation, &QPropertyAnimation::finished, this,
-          &BookingStatus::fadeInNewStatus);
 }
 
-void BookingStatus::changeBookingStatus(QString newBookingStatusText) {
+void BookingStatus::changeBookingStatus(QString newBookingStatusText,
+                                        TransitionTimeline *timeline,
+                                        int startTime) {
   *m_bookingStatusText = newBookingStatusText;
-  fadeOutOldStatus();
-}
+  int fadeInStartTime = startTime + m_fadeOutPropertyAnimation->duration();
 
-void BookingStatus::fadeOutOldStatus() { m_fadeOutPropertyAnimation->start(); }
+  timeline->addAnimation(startTime, m_fadeOutPropertyAnimation);
+  timeline->addAction(fadeInStartTime, [this, newBookingStatusText]() {
+    m_bookingStatusLabel->showText(newBookingStatusText);
+  });
+  timeline->addAnimation(fadeInStartTime, m_fadeInPropertyAnimation);
+}
 
-void BookingStatus::fadeInNewStatus() {
-  m_bookingStatusLabel->setText(*m_bookingStatusText);
-  m_fadeInPropertyAnimation->start();
+void BookingStatus::prerenderBookingStatus(QString bookingStatusText) {
+  m_bookingStatusLabel->prerenderText(bookingStatusText);
 }
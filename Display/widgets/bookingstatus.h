@@ -1,7 +1,8 @@
 #ifndef BOOKINGSTATUS_H
 #define BOOKINGSTATUS_H
 
-#include <QLabel>
+#include "../animations/transitiontimeline.h"
+#include "prerenderedlabel.h"
 #include <QPropertyAnimation>
 #include <QWidget>
 
@@ -9,19 +10,19 @@ class BookingStatus : public QWidget {
   Q_OBJECT
 public:
   explicit BookingStatus(QWidget *parent = nullptr);
-  void changeBookingStatus(QString newBookingStatusText);
+  void changeBookingStatus(QString newBookingStatusText,
+                           TransitionTimeline *timeline, int startTime);
+  void prerenderBookingStatus(QString bookingStatusText);
 
 private:
   QString *m_bookingStatusText;
-  QLabel *m_bookingStatusLabel;
+  PrerenderedLabel *m_bookingStatusLabel;
 
   QPropertyAnimation *m_fadeInPropertyAnimation;
   QPropertyAnimation *m_fadeOutPropertyAnimation;
 
   void configureLabelStyling();
   void configureAnimations();
-  void fadeOutOldStatus();
-  void fadeInNewStatus();
 };
 
 #endif // BOOKINGSTATUS_H
@@ -1,43 +1,69 @@
 #include "bookingwidget.h"
+#include "../assets/assetcache.h"
 #include "../settingstrings.h"
+#include <QFile>
 #include <QSettings>
 
-BookingWidget::BookingWidget(QWidget *parent)
-    : QWidget{parent}, m_statusColorToAnimateTo(Qt::black),
+BookingWidget::BookingWidget(const ScreenConfiguration &configuration,
+                             QScreen *screen, QWidget *parent)
+    : QWidget{parent}, m_currentlyDisplayingStatusColor(
+                           configuration.unbookedColor),
+      m_statusColorToAnimateTo(Qt::black),
+      m_backgroundColor(configuration.backgroundColor),
       m_slidingColorAnimationProgress(0.0),
       m_slidingColorAnimation(
-          new QPropertyAnimation(this, "slidingColorAnimationProgress")) {
+          new QPropertyAnimation(this, "slidingColorAnimationProgress")),
+      m_currentlyDisplayingState(CurrentBookingState::UNBOOKED),
+      m_stateToAnimateTo(CurrentBookingState::UNBOOKED), m_isStale(false) {
 
   QSettings settings;
-  m_backgroundColor = settings.value(BACKGROUND_COLOR_SETTING).value<QColor>();
-  m_currentlyDisplayingStatusColor =
-      settings.value(UNBOOKED_COLOR_SETTING).value<QColor>();
+  m_unbookedBackgroundImagePath =
+      settings.value(UNBOOKED_BACKGROUND_IMAGE_SETTING).toString();
+  m_bookedBackgroundImagePath =
+      settings.value(BOOKED_BACKGROUND_IMAGE_SETTING).toString();
 
   this->setWindowTitle("BreakTools Room Booker");
   QIcon windowIcon(":/icon.png");
   this->setWindowIcon(windowIcon);
   configureAnimation();
+  // Full screen goes to the screen the window is on, so that is set first.
+  this->setScreen(screen);
+  this->setGeometry(screen->geometry());
   this->showFullScreen();
   QCursor cursor = Qt::BlankCursor;
   this->setCursor(cursor);
 }
 
-void BookingWidget::changeStatusColor(QColor newColor) {
-  m_statusColorToAnimateTo = newColor;
-  m_slidingColorAnimation->start();
+void BookingWidget::changeStatus(CurrentBookingState newState,
+                                 QColor newColor,
+                                 TransitionTimeline *timeline,
+                                 int startTime) {
+  timeline->addAction(startTime, [this, newState, newColor]() {
+    m_statusColorToAnimateTo = newColor;
+    m_stateToAnimateTo = newState;
+  });
+  timeline->addAnimation(startTime, m_slidingColorAnimation);
+  timeline->addAction(startTime + m_slidingColorAnimation->duration(),
+                      [this]() { onAnimationFinished(); });
+}
+
+void BookingWidget::setStale(bool isStale) {
+  if (isStale == m_isStale) {
+    return;
+  }
+  m_isStale = isStale;
+  update(getStaleMarkerRectangle());
 }
 
 void BookingWidget::configureAnimation() {
   m_slidingColorAnimation->setDuration(700);
   m_slidingColorAnimation->setStartValue(0.0);
   m_slidingColorAnimation->setEndValue(1.0);
-
-  connect(m_slidingColorAnimation, &QPropertyAnimation::finished, this,
-          &BookingWidget::onAnimationFinished);
 }
 
 void BookingWidget::onAnimationFinished() {
   m_currentlyDisplayingStatusColor = m_statusColorToAnimateTo;
+  m_currentlyDisplayingState = m_stateToAnimateTo;
   m_slidingColorAnimationProgress = 0.0;
 }
 
@@ -50,12 +76,60 @@ void BookingWidget::setSlidingColorAnimationProgress(float progress) {
   update();
 }
 
+void BookingWidget::resizeEvent(QResizeEvent *event) {
+  QWidget::resizeEvent(event);
+  requestBackgroundImages();
+}
+
+void BookingWidget::requestBackgroundImages() {
+  // Decoded and scaled to the screen size in the background. Until they are
+  // ready the plain background color is drawn instead.
+  QSize backgroundSize = this->size();
+  if (QFile::exists(m_unbookedBackgroundImagePath)) {
+    AssetCache::instance()->requestPixmap(
+        m_unbookedBackgroundImagePath, backgroundSize,
+        this->devicePixelRatioF(), Qt::KeepAspectRatioByExpanding, this,
+        [this, backgroundSize](const QPixmap &backgroundImage) {
+          if (backgroundSize == this->size()) {
+            m_unbookedBackgroundImage = backgroundImage;
+            update();
+          }
+        });
+  }
+  if (QFile::exists(m_bookedBackgroundImagePath)) {
+    AssetCache::instance()->requestPixmap(
+        m_bookedBackgroundImagePath, backgroundSize,
+        this->devicePixelRatioF(), Qt::KeepAspectRatioByExpanding, this,
+        [this, backgroundSize](const QPixmap &backgroundImage) {
+          if (backgroundSize == this->size()) {
+            m_bookedBackgroundImage = backgroundImage;
+            update();
+          }
+        });
+  }
+}
+
+QPixmap
+BookingWidget::getBackgroundImageForState(CurrentBookingState state) const {
+  if (state == CurrentBookingState::UNBOOKED) {
+    return m_unbookedBackgroundImage;
+  }
+  if (state == CurrentBookingState::BOOKED) {
+    return m_bookedBackgroundImage;
+  }
+  return QPixmap();
+}
+
 void BookingWidget::paintEvent(QPaintEvent *event) {
   QPainter painter(this);
   QRect backgroundRectangle = this->rect();
   drawBackgroundColor(painter, backgroundRectangle);
+  drawBackgroundImage(painter, backgroundRectangle);
   drawAnimatedStatusColor(painter, backgroundRectangle);
   drawOverlayGradient(painter, backgroundRectangle);
+  if (m_isStale) {
+    drawStaleMarker(painter);
+  }
 }
 
 void BookingWidget::drawBackgroundColor(QPainter &painter,
@@ -65,6 +139,30 @@ void BookingWidget::drawBackgroundColor(QPainter &painter,
   painter.fillRect(backgroundRectangle, m_backgroundColor);
 }
 
+void BookingWidget::drawBackgroundImage(QPainter &painter,
+                                        QRect &backgroundRectangle) {
+  QPixmap currentBackgroundImage =
+      getBackgroundImageForState(m_currentlyDisplayingState);
+  if (!currentBackgroundImage.isNull()) {
+    painter.drawPixmap(backgroundRectangle.topLeft(), currentBackgroundImage);
+  }
+
+  if (m_slidingColorAnimationProgress <= 0.0 ||
+      m_stateToAnimateTo == m_currentlyDisplayingState) {
+    return;
+  }
+
+  QPixmap nextBackgroundImage = getBackgroundImageForState(m_stateToAnimateTo);
+  painter.save();
+  painter.setOpacity(m_slidingColorAnimationProgress);
+  if (nextBackgroundImage.isNull()) {
+    painter.fillRect(backgroundRectangle, m_backgroundColor);
+  } else {
+    painter.drawPixmap(backgroundRectangle.topLeft(), nextBackgroundImage);
+  }
+  painter.restore();
+}
+
 void BookingWidget::drawAnimatedStatusColor(QPainter &painter,
                                             QRect &backgroundRectangle) {
   QRect lowerRect = backgroundRectangle.adjusted(
@@ -89,3 +187,19 @@ void BookingWidget::drawOverlayGradient(QPainter &painter,
   gradient.setColorAt(1.0, QColor(255, 255, 255, 90));
   painter.fillRect(backgroundRectangle, gradient);
 }
+
+QRect BookingWidget::getStaleMarkerRectangle() const {
+  const int markerSize = 14;
+  const int markerMargin = 12;
+  return QRect(this->width() - markerSize - markerMargin, markerMargin,
+               markerSize, markerSize);
+}
+
+void BookingWidget::drawStaleMarker(QPainter &painter) {
+  painter.save();
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(QColor(255, 255, 255, 110));
+  painter.drawEllipse(getStaleMarkerRectangle());
+  painter.restore();
+}
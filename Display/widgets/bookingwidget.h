@@ -1,10 +1,14 @@
 #ifndef BOOKINGWIDGET_H
 #define BOOKINGWIDGET_H
 
+#include "../animations/transitiontimeline.h"
+#include "../datatypes.h"
 #include <QColor>
 #include <QPainter>
+#include <QPixmap>
 #include <QPropertyAnimation>
 #include <QRect>
+#include <QScreen>
 #include <QWidget>
 
 class BookingWidget : public QWidget {
@@ -14,8 +18,14 @@ class BookingWidget : public QWidget {
           WRITE setSlidingColorAnimationProgress)
 
 public:
-  explicit BookingWidget(QWidget *parent = nullptr);
-  void changeStatusColor(QColor newColor);
+  BookingWidget(const ScreenConfiguration &configuration, QScreen *screen,
+                QWidget *parent = nullptr);
+  // Slides in the new status color and cross-fades to the background image of
+  // the new state at the same time.
+  void changeStatus(CurrentBookingState newState, QColor newColor,
+                    TransitionTimeline *timeline, int startTime);
+  // A small dot in the corner while the shown bookings may be out of date.
+  void setStale(bool isStale);
 
 private:
   QColor m_currentlyDisplayingStatusColor;
@@ -24,17 +34,31 @@ private:
   float m_slidingColorAnimationProgress;
   QPropertyAnimation *m_slidingColorAnimation;
 
+  QString m_unbookedBackgroundImagePath;
+  QString m_bookedBackgroundImagePath;
+  QPixmap m_unbookedBackgroundImage;
+  QPixmap m_bookedBackgroundImage;
+  CurrentBookingState m_currentlyDisplayingState;
+  CurrentBookingState m_stateToAnimateTo;
+  bool m_isStale;
+
   void configureAnimation();
+  void requestBackgroundImages();
+  QPixmap getBackgroundImageForState(CurrentBookingState state) const;
   void onAnimationFinished();
   float slidingColorAnimationProgress() const;
   void setSlidingColorAnimationProgress(float progress);
 
   void drawBackgroundColor(QPainter &painter, QRect &backgroundRectangle);
+  void drawBackgroundImage(QPainter &painter, QRect &backgroundRectangle);
   void drawAnimatedStatusColor(QPainter &painter, QRect &backgroundRectangle);
   void drawOverlayGradient(QPainter &painter, QRect &backgroundRectangle);
+  QRect getStaleMarkerRectangle() const;
+  void drawStaleMarker(QPainter &painter);
 
 protected:
   void paintEvent(QPaintEvent *event) override;
+  void resizeEvent(QResizeEvent *event) override;
 };
 
 #endif // BOOKINGWIDGET_H
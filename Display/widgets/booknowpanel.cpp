@@ -0,0 +1,124 @@
+#include "booknowpanel.h"
+#include "../settingstrings.h"
+#include <QHBoxLayout>
+#include <QSettings>
+
+namespace {
+// Has to match the durations the backend accepts.
+const QList<int> BOOK_NOW_DURATIONS_MINUTES = {15, 30, 60};
+const int REFUSAL_MESSAGE_DURATION = 5000;
+} // namespace
+
+BookNowPanel::BookNowPanel(const Clock *clock, QWidget *parent)
+    : QWidget{parent}, m_clock(clock), m_isRoomFree(false),
+      m_nextBookingStartTime(0) {
+  QHBoxLayout *layout = new QHBoxLayout(this);
+  layout->setContentsMargins(0, 0, 20, 0);
+
+  for (int durationMinutes : BOOK_NOW_DURATIONS_MINUTES) {
+    QPushButton *durationButton =
+        new QPushButton(QString("Book %1 min").arg(durationMinutes), this);
+    configureButtonStyling(durationButton);
+    connect(durationButton, &QPushButton::clicked, this,
+            [this, durationMinutes]() {
+              // Hidden right away so a double tap can't book twice, the
+              // optimistic booked state follows a moment later.
+              this->hide();
+              emit bookingRequested(durationMinutes);
+            });
+    layout->addWidget(durationButton);
+    m_durationButtons.append(durationButton);
+  }
+
+  QSettings settings;
+  m_refusalLabel = new QLabel(
+      settings.value(BOOK_NOW_REFUSED_TEXT_SETTING).toString(), this);
+  m_refusalLabel->setFont(
+      settings.value(UPCOMING_BOOKINGS_BOLD_FONT_SETTING).value<QFont>());
+  m_refusalLabel->setStyleSheet("color: white;");
+  m_refusalLabel->hide();
+  layout->addWidget(m_refusalLabel);
+
+  m_availabilityTimer = new QTimer(this);
+  m_availabilityTimer->setSingleShot(true);
+  connect(m_availabilityTimer, &QTimer::timeout, this,
+          &BookNowPanel::updateButtons);
+  m_refusalTimer = new QTimer(this);
+  m_refusalTimer->setSingleShot(true);
+  connect(m_refusalTimer, &QTimer::timeout, this, &BookNowPanel::endRefusal);
+
+  // Keeps the rest of the bottom row in place while the buttons are hidden.
+  QSizePolicy retainingSizePolicy = this->sizePolicy();
+  retainingSizePolicy.setRetainSizeWhenHidden(true);
+  this->setSizePolicy(retainingSizePolicy);
+  this->hide();
+}
+
+void BookNowPanel::configureButtonStyling(QPushButton *button) {
+  QSettings settings;
+  button->setFont(
+      settings.value(UPCOMING_BOOKINGS_BOLD_FONT_SETTING).value<QFont>());
+  button->setFocusPolicy(Qt::NoFocus);
+  button->setStyleSheet(
+      "QPushButton { color: white; background: transparent; border: 2px solid "
+      "white; border-radius: 8px; padding: 8px 16px; }"
+      "QPushButton:pressed { background: rgba(255, 255, 255, 60); }"
+      "QPushButton:disabled { color: rgba(255, 255, 255, 80); border-color: "
+      "rgba(255, 255, 255, 80); }");
+}
+
+void BookNowPanel::updateAvailability(const DisplayState &displayState) {
+  m_isRoomFree =
+      displayState.currentBooking().state == CurrentBookingState::UNBOOKED;
+  m_nextBookingStartTime = displayState.nextBooking().startTime;
+  if (!m_isRoomFree) {
+    m_availabilityTimer->stop();
+    this->hide();
+    return;
+  }
+
+  updateButtons();
+  this->show();
+}
+
+void BookNowPanel::updateButtons() {
+  // A duration goes unavailable once it would end after the next booking
+  // starts, so the timer aims at the first of those moments still ahead.
+  qint64 now = m_clock->currentSecsSinceEpoch();
+  qint64 nextChange = -1;
+  for (int index = 0; index < m_durationButtons.size(); index++) {
+    qint64 latestStartTime =
+        m_nextBookingStartTime - BOOK_NOW_DURATIONS_MINUTES[index] * 60;
+    bool isAvailable = m_nextBookingStartTime <= 0 || now <= latestStartTime;
+    m_durationButtons[index]->setEnabled(isAvailable);
+    if (isAvailable && m_nextBookingStartTime > 0 &&
+        (nextChange < 0 || latestStartTime < nextChange)) {
+      nextChange = latestStartTime;
+    }
+  }
+
+  if (nextChange < 0) {
+    m_availabilityTimer->stop();
+    return;
+  }
+  m_availabilityTimer->start(
+      m_clock->toWallClockInterval((nextChange - now + 1) * 1000));
+}
+
+void BookNowPanel::showRefusal() {
+  for (QPushButton *durationButton : std::as_const(m_durationButtons)) {
+    durationButton->hide();
+  }
+  m_refusalLabel->show();
+  this->show();
+  m_refusalTimer->start(REFUSAL_MESSAGE_DURATION);
+}
+
+void BookNowPanel::endRefusal() {
+  m_refusalLabel->hide();
+  for (QPushButton *durationButton : std::as_const(m_durationButtons)) {
+    durationButton->show();
+  }
+  updateButtons();
+  this->setVisible(m_isRoomFree);
+}
@@ -0,0 +1,40 @@
+#ifndef BOOKNOWPANEL_H
+#define BOOKNOWPANEL_H
+
+#include "../datatypes.h"
+#include "../timing/clock.h"
+#include <QLabel>
+#include <QList>
+#include <QPushButton>
+#include <QTimer>
+#include <QWidget>
+
+// Buttons for booking the room right away, only shown while it is free.
+// Durations that would run into the next booking are disabled, also when
+// that only happens as time passes.
+class BookNowPanel : public QWidget {
+  Q_OBJECT
+public:
+  explicit BookNowPanel(const Clock *clock, QWidget *parent = nullptr);
+  void updateAvailability(const DisplayState &displayState);
+  // Tells the user a tap didn't lead to a booking, in place of the buttons.
+  void showRefusal();
+
+signals:
+  void bookingRequested(int durationMinutes);
+
+private:
+  const Clock *m_clock;
+  QList<QPushButton *> m_durationButtons;
+  QLabel *m_refusalLabel;
+  QTimer *m_availabilityTimer;
+  QTimer *m_refusalTimer;
+  bool m_isRoomFree;
+  qint64 m_nextBookingStartTime;
+
+  void configureButtonStyling(QPushButton *button);
+  void updateButtons();
+  void endRefusal();
+};
+
+#endif // BOOKNOWPANEL_H
@@ -1,10 +1,11 @@
 #include "clickableicon.h"
+#include "../assets/assetcache.h"
 #include "../settingstrings.h"
 #include <QFile>
 #include <QMouseEvent>
 #include <QSettings>
 
-ClickableIcon::ClickableIcon(QWidget *parent) {
+ClickableIcon::ClickableIcon(QWidget *parent) : QLabel{parent} {
   QSettings settings;
 
   QString imagePath = settings.value(ICON_FILE_PATH_SETTING).toString();
@@ -12,10 +13,14 @@ ClickableIcon::ClickableIcon(QWidget *parent) {
     imagePath = QString(":/resources/defaulticon.png");
   }
 
-  QPixmap iconPixmap(imagePath);
-  QPixmap scaledIconPixmap =
-      iconPixmap.scaled(64, 64, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  this->setPixmap(scaledIconPixmap);
+  // Reserving the space up front so the layout doesn't jump once the icon
+  // has been decoded in the background.
+  this->setMinimumSize(64, 64);
+  AssetCache::instance()->requestPixmap(
+      imagePath, QSize(64, 64), this->devicePixelRatioF(), Qt::KeepAspectRatio,
+      this, [this](const QPixmap &scaledIconPixmap) {
+        this->setPixmap(scaledIconPixmap);
+      });
 }
 
 void ClickableIcon::mousePressEvent(QMouseEvent *event) {
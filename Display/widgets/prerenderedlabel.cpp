@@ -0,0 +1,33 @@
+#include "prerenderedlabel.h"
+#include "../assets/fontfallbackcache.h"
+#include "../assets/textprerenderer.h"
+
+PrerenderedLabel::PrerenderedLabel(const QString &text, QWidget *parent)
+    : QLabel{text, parent} {}
+
+void PrerenderedLabel::prerenderText(const QString &text) {
+  // Polishing applies the style sheet, which is where the text color is set.
+  ensurePolished();
+  TextPrerenderer::instance()->prerender(
+      text, FontFallbackCache::instance()->getFallbackFont(font(), text),
+      palette().color(foregroundRole()), contentsRect().width(),
+      maximumHeight(), devicePixelRatioF());
+}
+
+void PrerenderedLabel::showText(const QString &text) {
+  ensurePolished();
+  // The families only grow for characters the label's own font doesn't have,
+  // so for most texts this leaves the font alone.
+  QFont textFont = FontFallbackCache::instance()->getFallbackFont(font(), text);
+  if (textFont != font()) {
+    setFont(textFont);
+  }
+  QPixmap prerenderedText = TextPrerenderer::instance()->find(
+      text, textFont, palette().color(foregroundRole()), contentsRect().width(),
+      maximumHeight(), devicePixelRatioF());
+  if (prerenderedText.isNull()) {
+    setText(text);
+  } else {
+    setPixmap(prerenderedText);
+  }
+}
@@ -0,0 +1,17 @@
+#ifndef PRERENDEREDLABEL_H
+#define PRERENDEREDLABEL_H
+
+#include <QLabel>
+
+// Word wrapped label that can have its next text rasterized in advance through
+// the TextPrerenderer. Showing prerendered text just blits the cached pixmap,
+// anything else is laid out and drawn as regular label text.
+class PrerenderedLabel : public QLabel {
+  Q_OBJECT
+public:
+  explicit PrerenderedLabel(const QString &text, QWidget *parent = nullptr);
+  void prerenderText(const QString &text);
+  void showText(const QString &text);
+};
+
+#endif // PRERENDEREDLABEL_H
@@ -1,9 +1,9 @@
 #include "upcomingbookings.h"
+#include "../assets/fontfallbackcache.h"
 #include "../settingstrings.h"
 #include <QGraphicsOpacityEffect>
 #include <QPropertyAnimation>
 #include <QSettings>
-#include <QTimer>
 #include <QVBoxLayout>
 
 UpcomingBooking::UpcomingBooking(QWidget *parent)
@@ -44,6 +44,8 @@ void UpcomingBooking::updateBookingText(
     upcomingBookingDataToDisplay.name.append("...");
   }
   m_bookingTimeLabel->setText(upcomingBookingDataToDisplay.timeString);
+  m_bookingNameLabel->setFont(FontFallbackCache::instance()->getFallbackFont(
+      m_bookingNameLabel->font(), upcomingBookingDataToDisplay.name));
   m_bookingNameLabel->setText(upcomingBookingDataToDisplay.name);
 }
 
@@ -68,27 +70,36 @@ UpcomingBookings::UpcomingBookings(QWidget *parent)
   configureFadeOutAnimations();
 }
 
-void UpcomingBookings::updateCurrentBooking(CurrentBookingData currentBooking) {
-  m_currentBookingId = currentBooking.id;
-}
-
-void UpcomingBookings::updateUpcomingBookings(
-    QList<UpcomingBookingData> upcomingBookingData) {
-
+void UpcomingBookings::changeUpcomingBookings(
+    const DisplayState &displayState, TransitionTimeline *timeline,
+    int startTime) {
+  // The first upcoming booking becoming the current one slides up into the
+  // big name, both are part of the same snapshot so no ordering is needed.
   if (!m_storedUpcomingBookingData.isEmpty() &&
-      m_storedUpcomingBookingData[0].id == m_currentBookingId) {
-    QTimer::singleShot(1100, m_firstBookingPositionAnimation, SLOT(start()));
+      m_storedUpcomingBookingData[0].id == displayState.currentBooking().id) {
+    int slideStartTime = startTime + 1100;
+    timeline->addAnimation(slideStartTime, m_firstBookingPositionAnimation);
+    timeline->addAction(slideStartTime +
+                            m_firstBookingPositionAnimation->duration(),
+                        [this]() { onPositionFadeAnimationFinished(); });
   }
 
-  m_storedUpcomingBookingData = upcomingBookingData;
-  m_fadeOutAllAnimationGroup->start();
+  m_storedUpcomingBookingData = displayState.upcomingBookings();
+  int fadeInStartTime = startTime + m_fadeOutAllAnimationGroup->duration();
+  timeline->addAnimation(startTime, m_fadeOutAllAnimationGroup);
+  timeline->addAction(fadeInStartTime,
+                      [this]() { onFadeOutAnimationFinished(); });
+  timeline->addAnimation(fadeInStartTime, m_fadeInAllAnimationGroup);
+}
+
+void UpcomingBookings::mouseReleaseEvent(QMouseEvent *) {
+  emit clicked();
 }
 
 void UpcomingBookings::onFadeOutAnimationFinished() {
   m_firstUpcomingBooking->updateBookingText(m_storedUpcomingBookingData[0]);
   m_secondUpcomingBooking->updateBookingText(m_storedUpcomingBookingData[1]);
   m_thirdUpcomingBooking->updateBookingText(m_storedUpcomingBookingData[2]);
-  m_fadeInAllAnimationGroup->start();
 }
 
 void UpcomingBookings::onPositionFadeAnimationFinished() {
@@ -132,9 +143,6 @@ void UpcomingBookings::configureFadeOutAnimations() {
   configureSingleFadeOutAnimation(m_firstOpacityEffect, 1000, 0.5, 1.0);
   configureSingleFadeOutAnimation(m_secondOpacityEffect, 500, 0.33, 0.6);
   configureSingleFadeOutAnimation(m_thirdOpacityEffect, 0, 0.0, 0.4);
-
-  connect(m_fadeOutAllAnimationGroup, &QParallelAnimationGroup::finished, this,
-          &UpcomingBookings::onFadeOutAnimationFinished);
 }
 
 void UpcomingBookings::configureSingleFadeOutAnimation(
@@ -161,7 +169,4 @@ void UpcomingBookings::configureFirstBookingPositionAnimation() {
   m_firstBookingPositionAnimation->setEndValue(
       *firstUpcomingBookingStartingPosition + QPoint(9, -150));
   m_firstBookingPositionAnimation->setEasingCurve(QEasingCurve::InCubic);
-
-  connect(m_firstBookingPositionAnimation, &QPropertyAnimation::finished, this,
-          &UpcomingBookings::onPositionFadeAnimationFinished);
 }
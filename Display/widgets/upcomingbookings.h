@@ -1,6 +1,7 @@
 #ifndef UPCOMINGBOOKINGS_H
 #define UPCOMINGBOOKINGS_H
 
+#include "../animations/transitiontimeline.h"
 #include "../datatypes.h"
 #include <QGraphicsOpacityEffect>
 #include <QLabel>
@@ -28,12 +29,17 @@ class UpcomingBookings : public QWidget {
   Q_OBJECT
 public:
   explicit UpcomingBookings(QWidget *parent = nullptr);
-  void updateCurrentBooking(CurrentBookingData currentBooking);
-  void updateUpcomingBookings(QList<UpcomingBookingData> upcomingBookingData);
+  void changeUpcomingBookings(const DisplayState &displayState,
+                              TransitionTimeline *timeline, int startTime);
+
+signals:
+  void clicked();
+
+protected:
+  void mouseReleaseEvent(QMouseEvent *event) override;
 
 private:
   QList<UpcomingBookingData> m_storedUpcomingBookingData;
-  QString m_currentBookingId;
   UpcomingBooking *m_firstUpcomingBooking;
   UpcomingBooking *m_secondUpcomingBooking;
   UpcomingBooking *m_thirdUpcomingBooking;
@@ -0,0 +1,172 @@
+#include "weekview.h"
+#include "../settingstrings.h"
+#include <QHBoxLayout>
+#include <QMouseEvent>
+#include <QSettings>
+
+namespace {
+const int WEEK_DAY_COUNT = 7;
+const int INACTIVITY_TIMEOUT = 30 * 1000;
+// Horizontal travel needed before a press counts as a swipe instead of a tap.
+const int SWIPE_DISTANCE = 80;
+} // namespace
+
+WeekView::WeekView(const QColor &backgroundColor, QWidget *parent)
+    : QWidget{parent}, m_dayOffset(0), m_dayLabel(new QLabel(this)),
+      m_messageLabel(new QLabel(this)),
+      m_previousDayButton(new QPushButton("<", this)),
+      m_nextDayButton(new QPushButton(">", this)),
+      m_bookingRowsLayout(new QVBoxLayout()),
+      m_inactivityTimer(new QTimer(this)) {
+  QSettings settings;
+  m_maxCharacters = settings.value(BOOKING_NAME_MAX_CHARACTERS).toInt();
+  this->setAttribute(Qt::WA_StyledBackground);
+  this->setStyleSheet(QString("WeekView { background: %1; } QLabel { color: "
+                              "white; }")
+                          .arg(backgroundColor.name()));
+
+  QPushButton *closeButton = new QPushButton("Close", this);
+  configureButtonStyling(m_previousDayButton);
+  configureButtonStyling(m_nextDayButton);
+  configureButtonStyling(closeButton);
+  connect(m_previousDayButton, &QPushButton::clicked, this,
+          [this]() { showDay(m_dayOffset - 1); });
+  connect(m_nextDayButton, &QPushButton::clicked, this,
+          [this]() { showDay(m_dayOffset + 1); });
+  connect(closeButton, &QPushButton::clicked, this, &QWidget::hide);
+
+  m_dayLabel->setFont(
+      settings.value(BOOKING_STATUS_FONT_SETTING).value<QFont>());
+  m_messageLabel->setFont(
+      settings.value(UPCOMING_BOOKINGS_LIGHT_FONT_SETTING).value<QFont>());
+
+  QHBoxLayout *headerLayout = new QHBoxLayout();
+  headerLayout->addWidget(m_previousDayButton);
+  headerLayout->addWidget(m_dayLabel, 1, Qt::AlignCenter);
+  headerLayout->addWidget(m_nextDayButton);
+  headerLayout->addWidget(closeButton);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(30, 20, 30, 20);
+  layout->addLayout(headerLayout);
+  layout->addLayout(m_bookingRowsLayout);
+  layout->addWidget(m_messageLabel);
+  layout->addStretch();
+
+  m_inactivityTimer->setSingleShot(true);
+  m_inactivityTimer->setInterval(INACTIVITY_TIMEOUT);
+  connect(m_inactivityTimer, &QTimer::timeout, this, &QWidget::hide);
+  this->hide();
+}
+
+void WeekView::open() {
+  this->setGeometry(parentWidget()->rect());
+  this->raise();
+  this->show();
+  showDay(0);
+}
+
+void WeekView::showDay(int dayOffset) {
+  m_dayOffset = qBound(0, dayOffset, WEEK_DAY_COUNT - 1);
+  m_previousDayButton->setEnabled(m_dayOffset > 0);
+  m_nextDayButton->setEnabled(m_dayOffset < WEEK_DAY_COUNT - 1);
+  m_inactivityTimer->start();
+  emit dayRequested(m_dayOffset);
+}
+
+void WeekView::showDayPage(int dayOffset, const ScheduleDayPage &page) {
+  if (dayOffset != m_dayOffset || this->isHidden()) {
+    return;
+  }
+
+  m_dayLabel->setText(getDayTitle(dayOffset, page.date));
+  clearBookingRows();
+  if (!page.date.isValid()) {
+    m_messageLabel->setText("Loading...");
+    m_messageLabel->show();
+    return;
+  }
+
+  for (const UpcomingBookingData &booking : page.bookings) {
+    addBookingRow(booking);
+  }
+  // A stale page is still shown while the cache fetches the fresh one, which
+  // replaces it through dayPageChanged.
+  if (page.isStale) {
+    m_messageLabel->setText(page.bookings.isEmpty()
+                                ? "No bookings (updating...)"
+                                : "Updating...");
+    m_messageLabel->show();
+    return;
+  }
+  m_messageLabel->setText("No bookings");
+  m_messageLabel->setVisible(page.bookings.isEmpty());
+}
+
+void WeekView::clearBookingRows() {
+  while (QLayoutItem *item = m_bookingRowsLayout->takeAt(0)) {
+    delete item->widget();
+    delete item;
+  }
+}
+
+void WeekView::addBookingRow(const UpcomingBookingData &booking) {
+  QSettings settings;
+  QString name = booking.name;
+  if (name.size() > m_maxCharacters) {
+    name.resize(m_maxCharacters);
+    name.append("...");
+  }
+
+  QWidget *row = new QWidget();
+  QHBoxLayout *rowLayout = new QHBoxLayout(row);
+  rowLayout->setContentsMargins(0, 4, 0, 4);
+  QLabel *timeLabel = new QLabel(booking.timeString, row);
+  timeLabel->setFont(
+      settings.value(UPCOMING_BOOKINGS_BOLD_FONT_SETTING).value<QFont>());
+  QLabel *nameLabel = new QLabel(name, row);
+  nameLabel->setFont(
+      settings.value(UPCOMING_BOOKINGS_LIGHT_FONT_SETTING).value<QFont>());
+  rowLayout->addWidget(timeLabel);
+  rowLayout->addSpacing(30);
+  rowLayout->addWidget(nameLabel, 1);
+  m_bookingRowsLayout->addWidget(row);
+}
+
+void WeekView::configureButtonStyling(QPushButton *button) {
+  QSettings settings;
+  button->setFont(
+      settings.value(UPCOMING_BOOKINGS_BOLD_FONT_SETTING).value<QFont>());
+  button->setFocusPolicy(Qt::NoFocus);
+  button->setStyleSheet(
+      "QPushButton { color: white; background: transparent; border: 2px solid "
+      "white; border-radius: 8px; padding: 8px 16px; }"
+      "QPushButton:pressed { background: rgba(255, 255, 255, 60); }"
+      "QPushButton:disabled { color: rgba(255, 255, 255, 80); border-color: "
+      "rgba(255, 255, 255, 80); }");
+}
+
+QString WeekView::getDayTitle(int dayOffset, const QDate &date) const {
+  if (dayOffset == 0) {
+    return "Today";
+  }
+  if (dayOffset == 1) {
+    return "Tomorrow";
+  }
+  // Loading pages have no date yet, the weekday follows once they arrive.
+  return date.isValid() ? date.toString("dddd d MMMM") : "";
+}
+
+void WeekView::mousePressEvent(QMouseEvent *event) {
+  m_pressPosition = event->position().toPoint();
+  m_inactivityTimer->start();
+}
+
+void WeekView::mouseReleaseEvent(QMouseEvent *event) {
+  int swipeDistance = event->position().toPoint().x() - m_pressPosition.x();
+  if (swipeDistance <= -SWIPE_DISTANCE) {
+    showDay(m_dayOffset + 1);
+  } else if (swipeDistance >= SWIPE_DISTANCE) {
+    showDay(m_dayOffset - 1);
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef WEEKVIEW_H
+#define WEEKVIEW_H
+
+#include "../datatypes.h"
+#include <QLabel>
+#include <QPoint>
+#include <QPushButton>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <QWidget>
+
+// Full screen overlay with the bookings of today and the coming six days, one
+// day at a time. Paged with the buttons or by swiping, and closes by itself
+// after a while so a forgotten week view doesn't hide the room's status.
+class WeekView : public QWidget {
+  Q_OBJECT
+public:
+  explicit WeekView(const QColor &backgroundColor, QWidget *parent = nullptr);
+  void open();
+  // Pages for any other day than the one shown are ignored, those are only
+  // the cache prefetching around it.
+  void showDayPage(int dayOffset, const ScheduleDayPage &page);
+
+signals:
+  void dayRequested(int dayOffset);
+
+protected:
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+  int m_dayOffset;
+  int m_maxCharacters;
+  QLabel *m_dayLabel;
+  QLabel *m_messageLabel;
+  QPushButton *m_previousDayButton;
+  QPushButton *m_nextDayButton;
+  QVBoxLayout *m_bookingRowsLayout;
+  QTimer *m_inactivityTimer;
+  QPoint m_pressPosition;
+
+  void showDay(int dayOffset);
+  void clearBookingRows();
+  void addBookingRow(const UpcomingBookingData &booking);
+  void configureButtonStyling(QPushButton *button);
+  QString getDayTitle(int dayOffset, const QDate &date) const;
+};
+
+#endif // WEEKVIEW_H